@@ -1110,42 +1110,6 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
     if (m_keyframeList.size() == 0) {
         return QVariant();
     }
-    Mlt::Properties mlt_prop;
-    QString animData;
-    int out = 0;
-    bool useOpacity = false;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(mlt_prop);
-        out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
-        useOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
-        animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
-    }
-
-    if (!animData.isEmpty() && (m_paramType == ParamType::KeyframeParam || m_paramType == ParamType::ColorWheel)) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        return QVariant(mlt_prop.anim_get_double("key", pos.frames(pCore->getCurrentFps())));
-    }
-    if (!animData.isEmpty() && m_paramType == ParamType::AnimatedRect) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_rect rect = mlt_prop.anim_get_rect("key", pos.frames(pCore->getCurrentFps()));
-        QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
-        if (useOpacity) {
-            res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
-        }
-        return QVariant(res);
-    }
-    if (!animData.isEmpty() && m_paramType == ParamType::Color) {
-        mlt_prop.set("key", animData.toUtf8().constData());
-        // This is a fake query to force the animation to be parsed
-        (void)mlt_prop.anim_get_double("key", 0, out);
-        mlt_color mltColor = mlt_prop.anim_get_color("key", pos.frames(pCore->getCurrentFps()));
-        QColor color(mltColor.r, mltColor.g, mltColor.b, mltColor.a);
-        return QVariant(QColorUtils::colorToString(color, true));
-    }
     if (m_paramType == ParamType::Roto_spline) {
         // interpolate
         auto next = m_keyframeList.upper_bound(pos);
@@ -1187,11 +1151,97 @@ QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
         }
         return vlist;
     }
-    return QVariant();
+    QMutexLocker lock(&m_animationMutex);
+    if (!loadAnimation()) {
+        return QVariant();
+    }
+    return animationValue(pos.frames(pCore->getCurrentFps()));
+}
+
+QVector<QVariant> KeyframeModel::getInterpolatedValues(int in, int out) const
+{
+    QVector<QVariant> values;
+    if (out < in) {
+        return values;
+    }
+    values.reserve(out - in + 1);
+    const double fps = pCore->getCurrentFps();
+    if (m_keyframeList.empty() || m_paramType == ParamType::Roto_spline) {
+        for (int frame = in; frame <= out; ++frame) {
+            values << getInterpolatedValue(GenTime(frame, fps));
+        }
+        return values;
+    }
+    QMutexLocker lock(&m_animationMutex);
+    bool animated = loadAnimation();
+    for (int frame = in; frame <= out; ++frame) {
+        auto keyframe = m_keyframeList.find(GenTime(frame, fps));
+        if (keyframe != m_keyframeList.end()) {
+            values << keyframe->second.second;
+        } else {
+            values << (animated ? animationValue(frame) : QVariant());
+        }
+    }
+    return values;
+}
+
+bool KeyframeModel::loadAnimation() const
+{
+    if (m_paramType != ParamType::KeyframeParam && m_paramType != ParamType::ColorWheel && m_paramType != ParamType::AnimatedRect &&
+        m_paramType != ParamType::Color) {
+        return false;
+    }
+    auto ptr = m_model.lock();
+    if (!ptr) {
+        return false;
+    }
+    // The animation length follows the parent clip, which can be resized without modifying the parameter
+    int out = ptr->data(m_index, AssetParameterModel::ParentDurationRole).toInt();
+    if (m_animation && out == m_animationDuration) {
+        return true;
+    }
+    const QString animData = ptr->data(m_index, AssetParameterModel::ValueRole).toString();
+    if (animData.isEmpty()) {
+        m_animation.reset();
+        return false;
+    }
+    m_animation.reset(new Mlt::Properties());
+    ptr->passProperties(*m_animation.get());
+    m_animation->set("key", animData.toUtf8().constData());
+    // This is a fake query to force the animation to be parsed
+    (void)m_animation->anim_get_double("key", 0, out);
+    m_animationDuration = out;
+    m_animationOpacity = ptr->data(m_index, AssetParameterModel::OpacityRole).toBool();
+    return true;
+}
+
+void KeyframeModel::invalidateAnimation()
+{
+    QMutexLocker lock(&m_animationMutex);
+    m_animation.reset();
+}
+
+QVariant KeyframeModel::animationValue(int frame) const
+{
+    if (m_paramType == ParamType::AnimatedRect) {
+        mlt_rect rect = m_animation->anim_get_rect("key", frame);
+        QString res = QStringLiteral("%1 %2 %3 %4").arg(int(rect.x)).arg(int(rect.y)).arg(int(rect.w)).arg(int(rect.h));
+        if (m_animationOpacity) {
+            res.append(QStringLiteral(" %1").arg(QString::number(rect.o, 'f')));
+        }
+        return QVariant(res);
+    }
+    if (m_paramType == ParamType::Color) {
+        mlt_color mltColor = m_animation->anim_get_color("key", frame);
+        QColor color(mltColor.r, mltColor.g, mltColor.b, mltColor.a);
+        return QVariant(QColorUtils::colorToString(color, true));
+    }
+    return QVariant(m_animation->anim_get_double("key", frame));
 }
 
 void KeyframeModel::sendModification()
 {
+    invalidateAnimation();
     if (auto ptr = m_model.lock()) {
         Q_ASSERT(m_index.isValid());
         QString name = ptr->data(m_index, AssetParameterModel::NameRole).toString();
@@ -1246,6 +1296,8 @@ void KeyframeModel::refresh()
         // qDebug() << "// DATA WAS ALREADY PARSED, ABORTING REFRESH\n";
         return;
     }
+    // The parameter was modified from outside of this model
+    invalidateAnimation();
     if (m_paramType == ParamType::Roto_spline) {
         parseRotoProperty(animData);
     } else if (AssetParameterModel::isAnimated(m_paramType)) {
@@ -1280,6 +1332,8 @@ void KeyframeModel::reset()
         qDebug() << "// DATA WAS ALREADY PARSED, ABORTING\n_________________";
         return;
     }
+    // The parameter was reset from outside of this model
+    invalidateAnimation();
     if (m_paramType == ParamType::Roto_spline) {
         // TODO: resetRotoProperty(animData);
     } else if (AssetParameterModel::isAnimated(m_paramType)) {
@@ -11,6 +11,7 @@
 #include "utils/gentime.h"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
@@ -142,6 +143,8 @@ public:
     /** @brief Return the interpolated value at given pos */
     QVariant getInterpolatedValue(int pos) const;
     QVariant getInterpolatedValue(const GenTime &pos) const;
+    /** @brief Return the interpolated values of all frames from @p in to @p out included, the animation is only parsed once */
+    QVector<QVariant> getInterpolatedValues(int in, int out) const;
     QVariant updateInterpolated(const QVariant &interpValue, double val);
     /** @brief Return the real value from a normalized one */
     QVariant getNormalizedValue(double newVal) const;
@@ -203,6 +206,18 @@ private:
     mutable QReadWriteLock m_lock;
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
+    /** @brief The parsed MLT animation of the parameter, reused by getInterpolatedValue until the parameter is modified */
+    mutable std::unique_ptr<Mlt::Properties> m_animation;
+    mutable int m_animationDuration{0};
+    mutable bool m_animationOpacity{false};
+    mutable QMutex m_animationMutex;
+    /** @brief Parse the animation of the parameter if it is not cached, m_animationMutex must be locked.
+        Returns false if the parameter has no MLT animation */
+    bool loadAnimation() const;
+    /** @brief Drop the cached animation after a change of the parameter value */
+    void invalidateAnimation();
+    /** @brief Read the value of the cached animation at a frame, m_animationMutex must be locked */
+    QVariant animationValue(int frame) const;
     bool moveOneKeyframe(GenTime oldPos, GenTime pos, QVariant newVal, Fun &undo, Fun &redo, bool updateView = true);
 
 Q_SIGNALS:
@@ -442,7 +442,7 @@ void KeyframeModelList::setParametersFromTask(const paramVector &params)
         refresh();
         UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo);
     }
-    pCore->pushUndo(undo, redo, i18n("Update effect"));
+    pCore->pushUndo(undo, redo, i18n("Update effect"), AssetParameterModel::paramsSize(params) + AssetParameterModel::paramsSize(currentValues));
 }
 
 void KeyframeModelList::reset()
@@ -467,6 +467,13 @@ QVariant KeyframeModelList::getInterpolatedValue(const GenTime &pos, const QPers
     return m_parameters.at(index)->getInterpolatedValue(pos);
 }
 
+QVector<QVariant> KeyframeModelList::getInterpolatedValues(int in, int out, const QPersistentModelIndex &index) const
+{
+    READ_LOCK();
+    Q_ASSERT(m_parameters.count(index) > 0);
+    return m_parameters.at(index)->getInterpolatedValues(in, out);
+}
+
 KeyframeModel *KeyframeModelList::getKeyModel()
 {
     if (m_inTimelineIndex.isValid()) {
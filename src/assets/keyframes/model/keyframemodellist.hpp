@@ -118,6 +118,9 @@ public:
        @param pos is the position where we interpolate
        @param index is the index of the queried parameter. */
     QVariant getInterpolatedValue(const GenTime &pos, const QPersistentModelIndex &index) const;
+    /** @brief Return the interpolated values of a parameter for all frames from @p in to @p out included.
+       @param index is the index of the queried parameter. */
+    QVector<QVariant> getInterpolatedValues(int in, int out, const QPersistentModelIndex &index) const;
 
     /** @brief Load keyframes from the current parameter value. */
     void refresh();
@@ -66,6 +66,7 @@ KeyframeView::~KeyframeView()
 
 void KeyframeView::slotModelChanged()
 {
+    m_curveValid = false;
     int offset = pCore->getItemIn(m_model->getOwnerId());
     Q_EMIT atKeyframe(m_model->hasKeyframe(m_position + offset), m_model->singleKeyframe());
     Q_EMIT modified();
@@ -199,6 +200,7 @@ void KeyframeView::slotRemoveKeyframe(const QVector<int> &positions)
 void KeyframeView::setDuration(int duration)
 {
     m_duration = duration;
+    m_curveValid = false;
     int offset = pCore->getItemIn(m_model->getOwnerId());
     Q_EMIT atKeyframe(m_model->hasKeyframe(m_position + offset), m_model->singleKeyframe());
     // Unselect keyframes that are outside range if any
@@ -727,6 +729,36 @@ void KeyframeView::wheelEvent(QWheelEvent *event)
     Q_EMIT seekToPos(pos);
 }
 
+void KeyframeView::updateCurve()
+{
+    m_curveValid = true;
+    m_curve.clear();
+    KeyframeModel *keyModel = m_model->getKeyModel();
+    if (keyModel == nullptr || m_duration < 2) {
+        return;
+    }
+    for (const auto &ix : m_model->getIndexes()) {
+        if (m_model->getKeyModel(ix) != keyModel) {
+            continue;
+        }
+        // Read all frames at once, the animation is only parsed once
+        int offset = pCore->getItemIn(m_model->getOwnerId());
+        const QVector<QVariant> values = m_model->getInterpolatedValues(offset, offset + m_duration - 1, ix);
+        m_curve.reserve(values.size());
+        for (const QVariant &value : values) {
+            bool ok = false;
+            double val = value.toDouble(&ok);
+            if (!ok) {
+                // Not a single number, like a geometry
+                m_curve.clear();
+                return;
+            }
+            m_curve << val;
+        }
+        break;
+    }
+}
+
 void KeyframeView::paintEvent(QPaintEvent *event)
 {
     Q_UNUSED(event)
@@ -789,6 +821,35 @@ void KeyframeView::paintEvent(QPaintEvent *event)
         p.drawLine(QPointF(scaledTick, m_lineHeight + 1), QPointF(scaledTick, m_lineHeight - 3));
     }
 
+    /*
+     * value curve
+     */
+    if (!m_curveValid) {
+        updateCurve();
+    }
+    if (m_curve.size() > 1) {
+        const auto range = std::minmax_element(m_curve.cbegin(), m_curve.cend());
+        const double min = *range.first;
+        const double span = *range.second - min;
+        if (span > 0) {
+            int firstFrame = qMax(0, int(m_zoomStart / m_scale));
+            int lastFrame = qMin(int(m_curve.size()) - 1, qCeil(zoomEnd / m_scale));
+            // At most one point per pixel
+            int step = qMax(1, (lastFrame - firstFrame) / qMax(1, maxWidth));
+            QPolygonF curve;
+            for (int frame = firstFrame; frame <= lastFrame; frame += step) {
+                double x = (frame * m_scale - m_zoomStart) * m_zoomFactor + m_offset;
+                double y = m_lineHeight - 1 - (m_curve.at(frame) - min) / span * (m_lineHeight - 1 - headOffset);
+                curve << QPointF(x, y);
+            }
+            p.save();
+            p.setOpacity(0.5);
+            p.setPen(m_colSelected);
+            p.drawPolyline(curve);
+            p.restore();
+        }
+    }
+
     /*
      * keyframes
      */
@@ -92,6 +92,11 @@ private:
     /** @brief the x click position offset for moving zoom */
     double m_clickOffset;
     int m_size;
+    /** @brief Value of the parameter shown in timeline at each frame, drawn behind the keyframes. Empty for non numeric parameters */
+    QVector<double> m_curve;
+    bool m_curveValid{false};
+    /** @brief Read the values of the curve from the model */
+    void updateCurve();
 
     QColor m_colSelected;
     QColor m_colKeyframe;
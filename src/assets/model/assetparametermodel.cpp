@@ -918,6 +918,15 @@ QVector<QPair<QString, QVariant>> AssetParameterModel::getAllParameters() const
     return res;
 }
 
+qint64 AssetParameterModel::paramsSize(const paramVector &params)
+{
+    qint64 size = 0;
+    for (const auto &p : params) {
+        size += (p.first.size() + p.second.toString().size()) * qint64(sizeof(QChar));
+    }
+    return size;
+}
+
 QJsonDocument AssetParameterModel::toJson(QVector<int> selection, bool includeFixed) const
 {
     QJsonArray list;
@@ -1383,7 +1392,7 @@ void AssetParameterModel::setParametersFromTask(const paramVector &params)
             return true;
         };
         redo();
-        pCore->pushUndo(undo, redo, i18n("Update effect"));
+        pCore->pushUndo(undo, redo, i18n("Update effect"), paramsSize(params) + paramsSize(previousParams));
     }
 }
 
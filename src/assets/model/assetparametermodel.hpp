@@ -149,6 +149,8 @@ public:
 
     /** @brief Return all the parameters as pairs (parameter name, parameter value) */
     QVector<QPair<QString, QVariant>> getAllParameters() const;
+    /** @brief Return the approximate memory used by the names and values of a list of parameters, in bytes */
+    static qint64 paramsSize(const paramVector &params);
     /** @brief Get a parameter value from its name */
     const QVariant getParamFromName(const QString &paramName);
     /** @brief Get a parameter index from its name */
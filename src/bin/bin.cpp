@@ -52,6 +52,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "ui_qtextclip_ui.h"
 #include "undohelper.hpp"
 #include "utils/thumbnailcache.hpp"
+#include "widgets/jobstatisticswidget.h"
 #include "xml/xml.hpp"
 
 #include "utils/KMessageBox_KdenliveCompat.h"
@@ -1442,6 +1443,9 @@ Bin::Bin(std::shared_ptr<ProjectItemModel> model, QWidget *parent, bool isMainBi
         m_jobsMenu->addAction(m_cancelJobs);
         m_jobsMenu->addAction(m_discardCurrentClipJobs);
         m_jobsMenu->addAction(m_discardPendingJobs);
+        m_jobsMenu->addSeparator();
+        m_showJobStatistics = new QAction(i18n("Job Statistics…"), this);
+        m_jobsMenu->addAction(m_showJobStatistics);
         m_infoLabel->setMenu(m_jobsMenu);
         m_infoLabel->setAction(infoAction);
 
@@ -1451,10 +1455,14 @@ Bin::Bin(std::shared_ptr<ProjectItemModel> model, QWidget *parent, bool isMainBi
                 pCore->taskManager.discardJobs({ObjectType::BinClip, currentId.toInt()}, AbstractTask::NOJOBTYPE, true);
             }
         });
-        connect(m_cancelJobs, &QAction::triggered, [&]() { pCore->taskManager.slotCancelJobs(); });
-        connect(m_discardPendingJobs, &QAction::triggered, [&]() {
-            // TODO: implement pending only deletion
-            pCore->taskManager.slotCancelJobs();
+        connect(m_cancelJobs, &QAction::triggered, [&]() { pCore->taskManager.discardAllJobs(); });
+        connect(m_discardPendingJobs, &QAction::triggered, [&]() { pCore->taskManager.discardPendingJobs(); });
+        connect(m_showJobStatistics, &QAction::triggered, this, [&]() {
+            if (m_jobStatistics == nullptr) {
+                m_jobStatistics = new JobStatisticsWidget(this);
+            }
+            m_jobStatistics->show();
+            m_jobStatistics->raise();
         });
     }
     // Hack, create toolbar spacer
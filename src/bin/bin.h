@@ -35,6 +35,7 @@ class BinListItemDelegate;
 class ClipController;
 class EffectStackModel;
 class InvalidDialog;
+class JobStatisticsWidget;
 class TranscodeSeek;
 class KdenliveDoc;
 class TagWidget;
@@ -565,6 +566,8 @@ private:
     QAction *m_cancelJobs;
     QAction *m_discardCurrentClipJobs;
     QAction *m_discardPendingJobs;
+    QAction *m_showJobStatistics;
+    JobStatisticsWidget *m_jobStatistics{nullptr};
     QAction *m_upAction;
     QAction *m_tagAction;
     QActionGroup *m_sortGroup;
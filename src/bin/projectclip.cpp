@@ -30,6 +30,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectitemmodel.h"
 #include "projectsubclip.h"
 #include "timeline2/model/snapmodel.hpp"
+#include "utils/probecache.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "utils/timecode.h"
 #include "xml/xml.hpp"
@@ -45,6 +46,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDir>
 #include <QDomElement>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -119,6 +121,9 @@ ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::share
     hash();
     m_boundaryTimer.setSingleShot(true);
     m_boundaryTimer.setInterval(500);
+    m_idleThumbTimer.setSingleShot(true);
+    m_idleThumbTimer.setInterval(IdleThumbProducerTimeout);
+    connect(&m_idleThumbTimer, &QTimer::timeout, this, &ProjectClip::trimThumbProducers);
     if (hasLimitedDuration()) {
         connect(&m_boundaryTimer, &QTimer::timeout, this, &ProjectClip::refreshBounds);
     }
@@ -193,6 +198,9 @@ ProjectClip::ProjectClip(const QString &id, const QDomElement &description, cons
     m_date = QFileInfo(m_temporaryUrl).lastModified();
     m_boundaryTimer.setSingleShot(true);
     m_boundaryTimer.setInterval(500);
+    m_idleThumbTimer.setSingleShot(true);
+    m_idleThumbTimer.setInterval(IdleThumbProducerTimeout);
+    connect(&m_idleThumbTimer, &QTimer::timeout, this, &ProjectClip::trimThumbProducers);
     connect(m_markerModel.get(), &MarkerListModel::modelChanged, this,
             [&]() { setProducerProperty(QStringLiteral("kdenlive:markers"), m_markerModel->toJson()); });
 }
@@ -264,7 +272,7 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
                     st.next();
                     int channels = channelsList.value(st.key());
                     double channelHeight = double(streamHeight) / channels;
-                    const QVector<uint8_t> audioLevels = audioFrameCache(st.key());
+                    const AudioLevels audioLevels = audioFrameCache(st.key());
                     qreal indicesPrPixel = qreal(audioLevels.length()) / img.width();
                     int idx;
                     for (int channel = 0; channel < channels; channel++) {
@@ -301,6 +309,14 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
     }
 }
 
+void ProjectClip::updatePartialAudioThumbnail()
+{
+    Q_EMIT audioThumbReady();
+    if (KdenliveSettings::audiothumbnails()) {
+        updateTimelineClips({TimelineModel::ReloadAudioThumbRole});
+    }
+}
+
 bool ProjectClip::audioThumbCreated() const
 {
     return (m_audioThumbCreated);
@@ -398,38 +414,47 @@ size_t ProjectClip::frameDuration() const
 
 void ProjectClip::resetSequenceThumbnails()
 {
-    QMutexLocker lk(&m_thumbMutex);
-    pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB, true);
-    m_thumbsProducer.reset();
-    ThumbnailCache::get()->invalidateThumbsForClip(m_binId);
-    // Force refeshing thumbs producer
-    lk.unlock();
-    m_uuid = QUuid::createUuid();
-    thumbProducer();
-    // Clips will be replanted so no need to refresh thumbs
-    // updateTimelineClips({TimelineModel::ClipThumbRole});
+    std::weak_ptr<ProjectClip> weakClip = std::static_pointer_cast<ProjectClip>(shared_from_this());
+    // The running tasks may still use the thumbnail producers, reset them once they stopped
+    pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB, true, {}, [weakClip]() {
+        auto clip = weakClip.lock();
+        if (!clip) {
+            return;
+        }
+        QMutexLocker lk(&clip->m_thumbMutex);
+        clip->resetThumbProducers();
+        ThumbnailCache::get()->invalidateThumbsForClip(clip->m_binId);
+        // Force refeshing thumbs producer
+        lk.unlock();
+        clip->m_uuid = QUuid::createUuid();
+        clip->thumbProducer();
+        // Clips will be replanted so no need to refresh thumbs
+        // updateTimelineClips({TimelineModel::ClipThumbRole});
+    });
 }
 
 void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudioReload)
 {
-    // we find if there are some loading job on that clip
-    QMutexLocker lock(&m_thumbMutex);
+    std::weak_ptr<ProjectClip> weakClip = std::static_pointer_cast<ProjectClip>(shared_from_this());
     if (refreshOnly) {
         // In that case, we only want a new thumbnail.
         // We thus set up a thumb job. We must make sure that there is no pending LOADJOB
-        // Clear cache first
-        ThumbnailCache::get()->invalidateThumbsForClip(m_binId);
-        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB, true);
-        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::CACHEJOB);
-        m_thumbsProducer.reset();
-        // Reset uuid to enforce reloading thumbnails from qml cache
-        m_uuid = QUuid::createUuid();
-        updateTimelineClips({TimelineModel::ClipThumbRole});
-        ClipLoadTask::start({ObjectType::BinClip, m_binId.toInt()}, QDomElement(), true, -1, -1, this);
+        // The running tasks may still write thumbnails or use the thumbnail producers, clear them once they stopped
+        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, {AbstractTask::LOADJOB, AbstractTask::CACHEJOB}, true, [weakClip]() {
+            auto clip = weakClip.lock();
+            if (!clip) {
+                return;
+            }
+            ThumbnailCache::get()->invalidateThumbsForClip(clip->m_binId);
+            QMutexLocker lock(&clip->m_thumbMutex);
+            clip->resetThumbProducers();
+            lock.unlock();
+            // Reset uuid to enforce reloading thumbnails from qml cache
+            clip->m_uuid = QUuid::createUuid();
+            clip->updateTimelineClips({TimelineModel::ClipThumbRole});
+            ClipLoadTask::start({ObjectType::BinClip, clip->m_binId.toInt()}, QDomElement(), true, -1, -1, clip.get());
+        });
     } else {
-        // If another load job is running?
-        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB, true);
-        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::CACHEJOB);
         if (QFile::exists(m_path) && (!isProxy && !hasProxy()) && m_properties) {
             clearBackupProperties();
         }
@@ -446,7 +471,6 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
         }
         if (!xml.isNull()) {
             bool hashChanged = false;
-            m_thumbsProducer.reset();
             ClipType::ProducerType type = clipType();
             if (type != ClipType::Color && type != ClipType::Image && type != ClipType::SlideShow) {
                 xml.removeAttribute("out");
@@ -469,8 +493,20 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudio
                 discardAudioThumb();
             }
             m_clipStatus = FileStatus::StatusWaiting;
-            m_thumbsProducer.reset();
-            ClipLoadTask::start({ObjectType::BinClip, m_binId.toInt()}, xml, false, -1, -1, this);
+            // If another load job is running, start the new one once the running tasks stopped using the thumbnail producers
+            pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, {AbstractTask::LOADJOB, AbstractTask::CACHEJOB}, true,
+                                           [weakClip, xml]() {
+                                               auto clip = weakClip.lock();
+                                               if (!clip) {
+                                                   return;
+                                               }
+                                               QMutexLocker lock(&clip->m_thumbMutex);
+                                               clip->resetThumbProducers();
+                                               lock.unlock();
+                                               ClipLoadTask::start({ObjectType::BinClip, clip->m_binId.toInt()}, xml, false, -1, -1, clip.get());
+                                           });
+        } else {
+            pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, {AbstractTask::LOADJOB, AbstractTask::CACHEJOB}, true, nullptr);
         }
     }
 }
@@ -593,7 +629,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
     pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::LOADJOB);
     // Abort thumbnail tasks if any
     m_thumbMutex.lock();
-    m_thumbsProducer.reset();
+    resetThumbProducers();
     updateProducer(producer);
     m_thumbMutex.unlock();
     isReloading = false;
@@ -790,6 +826,7 @@ const QString ProjectClip::getProxyFromOriginal(QString originalPath) const
 void ProjectClip::setThumbProducer(std::shared_ptr<Mlt::Producer> prod)
 {
     QMutexLocker lock(&m_thumbMutex);
+    resetThumbProducers();
     m_thumbsProducer = std::move(prod);
 }
 
@@ -814,30 +851,131 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
         cloneProducerToFile(m_sequenceThumbFile.fileName(), true);
         m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), "consumer", m_sequenceThumbFile.fileName().toUtf8().constData()));
     } else {
-        QString mltService = m_masterProducer->get("mlt_service");
-        const QString mltResource = m_masterProducer->get("resource");
-        if (mltService == QLatin1String("avformat")) {
-            mltService = QStringLiteral("avformat-novalidate");
-        }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+        m_thumbsProducer.reset(openThumbProducer());
     }
     if (m_thumbsProducer->is_valid()) {
-        Mlt::Properties original(m_masterProducer->get_properties());
-        Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
-        cloneProps.pass_list(original, ClipController::getPassPropertiesList());
-        Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
-        Mlt::Filter padder(*pCore->thumbProfile(), "resize");
-        Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-        m_thumbsProducer->set("audio_index", -1);
-        // Required to make get_playtime() return > 1
-        m_thumbsProducer->set("out", m_thumbsProducer->get_length() - 1);
-        m_thumbsProducer->attach(scaler);
-        m_thumbsProducer->attach(padder);
-        m_thumbsProducer->attach(converter);
+        prepareThumbProducer(*m_thumbsProducer.get());
     }
     return m_thumbsProducer;
 }
 
+Mlt::Producer *ProjectClip::openThumbProducer()
+{
+    QString mltService = m_masterProducer->get("mlt_service");
+    const QString mltResource = m_masterProducer->get("resource");
+    if (mltService == QLatin1String("avformat")) {
+        mltService = QStringLiteral("avformat-novalidate");
+    }
+    return new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData());
+}
+
+void ProjectClip::prepareThumbProducer(Mlt::Producer &producer)
+{
+    Mlt::Properties original(m_masterProducer->get_properties());
+    Mlt::Properties cloneProps(producer.get_properties());
+    cloneProps.pass_list(original, ClipController::getPassPropertiesList());
+    Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
+    Mlt::Filter padder(*pCore->thumbProfile(), "resize");
+    Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
+    producer.set("audio_index", -1);
+    // Required to make get_playtime() return > 1
+    producer.set("out", producer.get_length() - 1);
+    producer.attach(scaler);
+    producer.attach(padder);
+    producer.attach(converter);
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::takeThumbProducer()
+{
+    if (KdenliveSettings::gpu_accel() || m_clipType == ClipType::Timeline) {
+        // These share a single producer
+        return nullptr;
+    }
+    if (clipType() == ClipType::Unknown || m_masterProducer == nullptr || m_clipStatus == FileStatus::StatusWaiting) {
+        return nullptr;
+    }
+    QMutexLocker lock(&m_thumbMutex);
+    std::shared_ptr<Mlt::Producer> producer;
+    if (!m_idleThumbProducers.empty()) {
+        producer = m_idleThumbProducers.back();
+        m_idleThumbProducers.pop_back();
+    } else {
+        producer.reset(openThumbProducer());
+        if (!producer->is_valid()) {
+            return nullptr;
+        }
+        prepareThumbProducer(*producer.get());
+    }
+    m_lentThumbProducers.push_back(producer.get());
+    return producer;
+}
+
+void ProjectClip::releaseThumbProducer(const std::shared_ptr<Mlt::Producer> &producer)
+{
+    QMutexLocker lock(&m_thumbMutex);
+    auto it = std::find(m_lentThumbProducers.begin(), m_lentThumbProducers.end(), producer.get());
+    if (it == m_lentThumbProducers.end()) {
+        // The clip was reloaded meanwhile, this producer is outdated
+        return;
+    }
+    m_lentThumbProducers.erase(it);
+    if (m_idleThumbProducers.size() < MaxIdleThumbProducers) {
+        m_idleThumbProducers.push_back(producer);
+        // Close the idle decoders if no thumbnail is requested for a while
+        QMetaObject::invokeMethod(
+            &m_idleThumbTimer, [this]() { m_idleThumbTimer.start(); }, Qt::QueuedConnection);
+    }
+}
+
+void ProjectClip::trimThumbProducers()
+{
+    QMutexLocker lock(&m_thumbMutex);
+    m_idleThumbProducers.clear();
+}
+
+void ProjectClip::resetThumbProducers()
+{
+    m_thumbsProducer.reset();
+    m_idleThumbProducers.clear();
+    m_lentThumbProducers.clear();
+    QMutexLocker lock(&m_keyframesMutex);
+    m_thumbKeyframes.clear();
+    m_thumbKeyframesScanned = false;
+}
+
+void ProjectClip::setThumbKeyframes(const QVector<int> &positions)
+{
+    QMutexLocker lock(&m_keyframesMutex);
+    m_thumbKeyframes = positions;
+    m_thumbKeyframesScanned = true;
+}
+
+bool ProjectClip::hasThumbKeyframes() const
+{
+    QMutexLocker lock(&m_keyframesMutex);
+    return m_thumbKeyframesScanned;
+}
+
+int ProjectClip::thumbSeekPosition(int frame) const
+{
+    const int tolerance = qRound(KdenliveSettings::thumbseektolerance() * pCore->getCurrentFps());
+    QMutexLocker lock(&m_keyframesMutex);
+    if (tolerance <= 0 || m_thumbKeyframes.isEmpty()) {
+        return frame;
+    }
+    int position = frame;
+    int distance = tolerance + 1;
+    auto next = std::lower_bound(m_thumbKeyframes.cbegin(), m_thumbKeyframes.cend(), frame);
+    if (next != m_thumbKeyframes.cend() && *next - frame < distance) {
+        position = *next;
+        distance = *next - frame;
+    }
+    if (next != m_thumbKeyframes.cbegin() && frame - *(next - 1) < distance) {
+        position = *(next - 1);
+    }
+    return position;
+}
+
 void ProjectClip::createDisabledMasterProducer()
 {
     if (!m_disabledProducer) {
@@ -1612,6 +1750,10 @@ const QString ProjectClip::getFileHash()
 
 const QPair<QByteArray, qint64> ProjectClip::calculateHash(const QString &path)
 {
+    const QString cachedHash = ProbeCache::get()->hash(path);
+    if (!cachedHash.isEmpty()) {
+        return {QByteArray::fromHex(cachedHash.toLatin1()), QFileInfo(path).size()};
+    }
     QFile file(path);
     QByteArray fileHash;
     qint64 fSize = 0;
@@ -1632,6 +1774,7 @@ const QPair<QByteArray, qint64> ProjectClip::calculateHash(const QString &path)
         }
         file.close();
         fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
+        ProbeCache::get()->storeHash(path, QString::fromLatin1(fileHash.toHex()));
     }
     return {fileHash, fSize};
 }
@@ -2014,11 +2157,55 @@ void ProjectClip::discardAudioThumb()
     if (!m_audioInfo) {
         return;
     }
-    pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::AUDIOTHUMBJOB);
+    m_audioThumbCreated = false;
+    m_pendingAudioDiscards++;
+    std::weak_ptr<ProjectClip> weakClip = std::static_pointer_cast<ProjectClip>(shared_from_this());
+    // A running task may still store or save levels, delete them once it stopped.
+    // New audio tasks are delayed until then, otherwise their levels would be deleted too
+    pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()}, AbstractTask::AUDIOTHUMBJOB, false, {}, [weakClip]() {
+        auto clip = weakClip.lock();
+        if (!clip) {
+            return;
+        }
+        if (--clip->m_pendingAudioDiscards > 0) {
+            return;
+        }
+        clip->clearAudioThumbData();
+        if (clip->m_delayedAudioTask >= 0) {
+            bool force = clip->m_delayedAudioTask == 1;
+            clip->m_delayedAudioTask = -1;
+            AudioLevelsTask::start({ObjectType::BinClip, clip->m_binId.toInt()}, clip.get(), force);
+        }
+    });
+}
+
+bool ProjectClip::delayAudioThumbTask(bool force)
+{
+    if (m_pendingAudioDiscards == 0) {
+        return false;
+    }
+    m_delayedAudioTask = qMax(m_delayedAudioTask, force ? 1 : 0);
+    return true;
+}
+
+void ProjectClip::clearAudioThumbData()
+{
+    if (!m_audioInfo) {
+        return;
+    }
     QString audioThumbPath;
     QList<int> streams = m_audioInfo->streams().keys();
     // Delete audio thumbnail data
     for (int &st : streams) {
+        // Release the mapped levels before deleting the file
+        if (m_masterProducer) {
+            const QString levelsKey = QString("_kdenlive:audio%1").arg(st);
+            const QString completeKey = QString("_kdenlive:audio_complete%1").arg(st);
+            m_masterProducer->lock();
+            m_masterProducer->clear(levelsKey.toUtf8().constData());
+            m_masterProducer->clear(completeKey.toUtf8().constData());
+            m_masterProducer->unlock();
+        }
         audioThumbPath = getAudioThumbPath(st);
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
@@ -2027,11 +2214,19 @@ void ProjectClip::discardAudioThumb()
         QString key = QString("%1:%2").arg(m_binId).arg(st);
         pCore->audioThumbCache.insert(key, QByteArray("-"));
     }
-    // Delete thumbnail
+    // Delete thumbnails created by previous versions
     for (int &st : streams) {
         audioThumbPath = getAudioThumbPath(st);
         if (!audioThumbPath.isEmpty()) {
-            QFile::remove(audioThumbPath);
+            audioThumbPath.chop(AudioLevels::extension.length());
+            QFile::remove(audioThumbPath + QStringLiteral(".png"));
+            // Delete the audio alignment envelopes of this stream
+            QFileInfo thumbInfo(audioThumbPath);
+            QDir thumbFolder = thumbInfo.absoluteDir();
+            const QStringList envelopes = thumbFolder.entryList({thumbInfo.fileName() + QStringLiteral("_envelope_*")}, QDir::Files);
+            for (const QString &envelope : envelopes) {
+                thumbFolder.remove(envelope);
+            }
         }
     }
 
@@ -2070,7 +2265,7 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     QString audioPath = thumbFolder.absoluteFilePath(clipHash);
     audioPath.append(QLatin1Char('_') + QString::number(stream));
     int roundedFps = int(pCore->getCurrentFps());
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    audioPath.append(QStringLiteral("_%1_audio").arg(roundedFps) + AudioLevels::extension);
     return audioPath;
 }
 
@@ -2299,7 +2494,7 @@ bool ProjectClip::selfSoftDelete(Fun &undo, Fun &redo)
 {
     Fun operation = [this]() {
         // Free audio thumb data and timeline producers
-        pCore->taskManager.discardJobs({ObjectType::BinClip, m_binId.toInt()});
+        pCore->taskManager.discardJobsAndWait({ObjectType::BinClip, m_binId.toInt()});
         m_audioLevels.clear();
         m_disabledProducer.reset();
         m_audioProducers.clear();
@@ -2564,18 +2759,27 @@ int ProjectClip::getAudioMax(int stream)
     if (!m_masterProducer->property_exists(key2.toUtf8().constData())) {
         return 0;
     }
-    const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key2.toUtf8().constData()));
-    if (audioData.isEmpty()) {
+    auto *audioData = static_cast<AudioLevels *>(m_masterProducer->get_data(key2.toUtf8().constData()));
+    if (audioData == nullptr || audioData->isEmpty()) {
         return 0;
     }
-    uint max = *std::max_element(audioData.constBegin(), audioData.constEnd());
-    m_masterProducer->set(key.toUtf8().constData(), int(max));
-    return int(max);
+    int max = audioData->maxLevel();
+    m_masterProducer->set(key.toUtf8().constData(), max);
+    return max;
+}
+
+bool ProjectClip::audioLevelsComplete(int stream) const
+{
+    if (!m_masterProducer) {
+        return false;
+    }
+    const QString key = QString("_kdenlive:audio_complete%1").arg(stream);
+    return m_masterProducer->get_int(key.toUtf8().constData()) == 1;
 }
 
-const QVector<uint8_t> ProjectClip::audioFrameCache(int stream)
+const AudioLevels ProjectClip::audioFrameCache(int stream)
 {
-    QVector<uint8_t> audioLevels;
+    AudioLevels audioLevels;
     if (stream == -1) {
         if (m_audioInfo) {
             stream = m_audioInfo->ffmpeg_audio_index();
@@ -2585,12 +2789,12 @@ const QVector<uint8_t> ProjectClip::audioFrameCache(int stream)
     }
     const QString key = QString("_kdenlive:audio%1").arg(stream);
     if (m_masterProducer->get_data(key.toUtf8().constData())) {
-        const QVector<uint8_t> audioData = *static_cast<QVector<uint8_t> *>(m_masterProducer->get_data(key.toUtf8().constData()));
-        return audioData;
+        // Copying only increases the reference count of the shared levels
+        return *static_cast<AudioLevels *>(m_masterProducer->get_data(key.toUtf8().constData()));
     } else {
         qDebug() << "=== AUDIO NOT FOUND ";
     }
-    return QVector<uint8_t>();
+    return audioLevels;
 
     // TODO
     /*QString key = QString("%1:%2").arg(m_binId).arg(stream);
@@ -10,6 +10,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "abstractprojectitem.h"
 #include "definitions.h"
+#include "lib/audio/audioLevels.h"
 #include "mltcontroller/clipcontroller.h"
 #include "timeline2/model/timelinemodel.hpp"
 
@@ -149,6 +150,18 @@ public:
 
     /** @brief Returns this clip's producer. */
     std::shared_ptr<Mlt::Producer> thumbProducer() override;
+    /** @brief Borrow a thumbnail producer used by no other thread from the clip pool, so that several thumbnails can be decoded in parallel.
+     *  Returns nullptr if the clip can only use the shared thumbProducer(). */
+    std::shared_ptr<Mlt::Producer> takeThumbProducer();
+    /** @brief Give back a producer obtained with takeThumbProducer */
+    void releaseThumbProducer(const std::shared_ptr<Mlt::Producer> &producer);
+    /** @brief Set the sorted positions of the video keyframes, used for approximate thumbnail seeking */
+    void setThumbKeyframes(const QVector<int> &positions);
+    /** @brief Returns true if the video keyframes were already scanned, even if none was found */
+    bool hasThumbKeyframes() const;
+    /** @brief Returns the closest video keyframe within the thumbnail seek tolerance of @p frame, or @p frame itself.
+     *  Seeking a keyframe does not decode the rest of its group of pictures, thumbnails should be stored under the returned position. */
+    int thumbSeekPosition(int frame) const;
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -185,6 +198,8 @@ public:
     QStringList subClipIds() const;
     /** @brief Delete cached audio thumb - needs to be recreated */
     void discardAudioThumb();
+    /** @brief Returns true if the audio thumbnail is being discarded. The new audio thumbnail task is then started once the old levels are deleted */
+    bool delayAudioThumbTask(bool force);
     /** @brief Get path for this clip's audio thumbnail */
     const QString getAudioThumbPath(int stream);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
@@ -225,9 +240,11 @@ public:
     /** @brief Get the frame position used for Bin clip thumbnail
      */
     int getThumbFrame() const;
-    /** @brief Return audio cache for a stream
+    /** @brief Return audio cache for a stream, a shared view that does not copy the levels
      */
-    const QVector <uint8_t> audioFrameCache(int stream = -1);
+    const AudioLevels audioFrameCache(int stream = -1);
+    /** @brief Returns true if the audio levels of the stream are fully generated, and not only published while in progress. */
+    bool audioLevelsComplete(int stream) const;
     /** @brief Return FFmpeg's audio stream index for an MLT audio stream index
      */
     int getAudioStreamFfmpegIndex(int mltStream);
@@ -302,6 +319,8 @@ public Q_SLOTS:
     /** @brief Store the audio thumbnails once computed. Note that the parameter is a value and not a reference, fill free to use it as a sink (use std::move to
      * avoid copy). */
     void updateAudioThumbnail(bool cachedThumb);
+    /** @brief Display the audio levels generated so far, the clip's audio thumbnail is not considered created yet */
+    void updatePartialAudioThumbnail();
     /** @brief Delete the proxy file */
     void deleteProxy(bool reloadClip = true);
     /** @brief A clip job progressed, update display */
@@ -341,8 +360,33 @@ public Q_SLOTS:
 private:
     /** @brief Generate and store file hash if not available. */
     const QString getFileHash();
+    /** @brief Delete the audio levels of all streams, from memory and disk */
+    void clearAudioThumbData();
+    /** @brief Number of discardAudioThumb() calls waiting for the running audio task to stop */
+    int m_pendingAudioDiscards{0};
+    /** @brief An audio thumbnail task was requested while discarding, 1 if it was forced */
+    int m_delayedAudioTask{-1};
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
+    /** @brief Idle thumbnail producers of the pool, and the ones in use */
+    std::vector<std::shared_ptr<Mlt::Producer>> m_idleThumbProducers;
+    std::vector<Mlt::Producer *> m_lentThumbProducers;
+    static const size_t MaxIdleThumbProducers = 4;
+    /** @brief Idle producers are closed after this delay without thumbnail requests, in milliseconds */
+    static const int IdleThumbProducerTimeout = 10000;
+    QTimer m_idleThumbTimer;
+    /** @brief Close the idle producers of the pool */
+    void trimThumbProducers();
+    /** @brief Open a new thumbnail producer on the clip resource */
+    Mlt::Producer *openThumbProducer();
+    /** @brief Pass the clip properties and attach the thumbnail filters */
+    void prepareThumbProducer(Mlt::Producer &producer);
+    /** @brief Positions of the video keyframes, scanned once by the CacheTask */
+    QVector<int> m_thumbKeyframes;
+    bool m_thumbKeyframesScanned{false};
+    mutable QMutex m_keyframesMutex;
+    /** @brief Drop all thumbnail producers, m_thumbMutex must be locked */
+    void resetThumbProducers();
     const QString geometryWithOffset(const QString &data, int offset);
     QMap <QString, QByteArray> m_audioLevels;
     /** @brief If true, all timeline occurrences of this clip will be replaced from a fresh producer on reload. */
@@ -475,7 +475,7 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     return nullptr;
 }
 
-const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
+const AudioLevels ProjectItemModel::getAudioLevelsByBinID(const QString &binId, int stream)
 {
     READ_LOCK();
     for (const auto &clip : m_allItems) {
@@ -484,7 +484,7 @@ const QVector<uint8_t> ProjectItemModel::getAudioLevelsByBinID(const QString &bi
             return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache(stream);
         }
     }
-    return QVector<uint8_t>();
+    return AudioLevels();
 }
 
 double ProjectItemModel::getAudioMaxLevel(const QString &binId, int stream)
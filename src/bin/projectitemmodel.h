@@ -12,6 +12,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "abstractmodel/abstracttreemodel.hpp"
 #include "bin/abstractprojectitem.h"
 #include "definitions.h"
+#include "lib/audio/audioLevels.h"
 #include "undohelper.hpp"
 #include <QDomElement>
 #include <QFileInfo>
@@ -57,7 +58,7 @@ public:
     /** @brief Returns a clip from the hierarchy, given its id */
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
     /** @brief Returns audio levels for a clip from its id */
-    const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
+    const AudioLevels getAudioLevelsByBinID(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId, int stream);
 
     /** @brief Returns a list of clips using the given url */
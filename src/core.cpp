@@ -921,9 +921,9 @@ void Core::profileChanged()
     GenTime::setFps(getCurrentFps());
 }
 
-void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text)
+void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 payloadSize)
 {
-    undoStack()->push(new FunctionalUndoCommand(undo, redo, text));
+    undoStack()->push(new FunctionalUndoCommand(undo, redo, text, payloadSize));
 }
 
 void Core::pushUndo(QUndoCommand *command)
@@ -177,8 +177,9 @@ public:
     void profileChanged();
 
     /** @brief Create and push and undo object based on the corresponding functions
-        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead*/
-    void pushUndo(const Fun &undo, const Fun &redo, const QString &text);
+        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead
+        @param payloadSize the size in bytes of the data kept alive by the functions, like XML or parameter values */
+    void pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 payloadSize = 0);
     void pushUndo(QUndoCommand *command);
     /** @brief display a user info/warning message in statusbar */
     void displayMessage(const QString &message, MessageType type, int timeout = -1);
@@ -18,12 +18,14 @@
 #include <KUrlRequesterDialog>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
+#include <QDirIterator>
 #include <QFile>
 #include <QFileDialog>
 #include <QFontDatabase>
 #include <QStandardPaths>
 #include <QTreeWidgetItem>
+#include <QtConcurrent>
+#include <algorithm>
 #include <kurlrequester.h>
 #include <utility>
 
@@ -154,10 +156,29 @@ bool DocumentChecker::hasErrorInClips()
     m_missingFonts.clear();
     m_changedClips.clear();
     m_fixedSequences.clear();
-    QStringList verifiedPaths;
-    QStringList missingPaths;
+    QSet<QString> verifiedPaths;
+    QSet<QString> missingPaths;
     QStringList serviceToCheck = {QStringLiteral("kdenlivetitle"), QStringLiteral("qimage"), QStringLiteral("pixbuf"), QStringLiteral("timewarp"),
                                   QStringLiteral("framebuffer"),   QStringLiteral("xml"),    QStringLiteral("qtext"),  QStringLiteral("tractor")};
+    // Read the folders containing the clips in parallel instead of checking each file one by one
+    QStringList resources;
+    for (const QDomNodeList &list : {documentProducers, documentChains}) {
+        for (int i = 0; i < list.count(); ++i) {
+            QDomElement e = list.item(i).toElement();
+            for (const QString &name :
+                 {QStringLiteral("resource"), QStringLiteral("warp_resource"), QStringLiteral("kdenlive:proxy"), QStringLiteral("kdenlive:originalurl")}) {
+                QString path = Xml::getXmlProperty(e, name);
+                if (path.length() > 1) {
+                    if (QFileInfo(path).isRelative()) {
+                        path.prepend(root);
+                    }
+                    resources << path;
+                }
+            }
+        }
+    }
+    listFolders(resources);
+    m_hashChecks.clear();
     max = documentProducers.count();
     for (int i = 0; i < max; ++i) {
         QDomElement e = documentProducers.item(i).toElement();
@@ -168,6 +189,7 @@ bool DocumentChecker::hasErrorInClips()
         QDomElement e = documentChains.item(i).toElement();
         verifiedPaths << getMissingProducers(e, entries, verifiedPaths, missingPaths, serviceToCheck, root, storageFolder);
     }
+    checkChangedClips();
 
     // Get list of used Luma files
     QStringList missingLumas;
@@ -199,7 +221,7 @@ bool DocumentChecker::hasErrorInClips()
         if (QFileInfo(filePath).isRelative()) {
             filePath.prepend(root);
         }
-        if (!QFile::exists(filePath)) {
+        if (!fileExists(filePath)) {
             QString lumaName = QFileInfo(filePath).fileName();
             // MLT 7 now generates lumas on the fly for files named luma01.pgm to luma22.pgm, so don't detect these as missing
             if (lumaName.length() == 10 && lumaName.startsWith(QLatin1String("luma")) && lumaName.endsWith(QLatin1String(".pgm"))) {
@@ -281,7 +303,7 @@ bool DocumentChecker::hasErrorInClips()
         if (QFileInfo(filePath).isRelative()) {
             filePath.prepend(root);
         }
-        if (!QFile::exists(filePath)) {
+        if (!fileExists(filePath)) {
             missingAssets << filterfile;
         }
     }
@@ -703,7 +725,7 @@ const QString DocumentChecker::relocateResource(QString sourceResource)
     return QString();
 }
 
-QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList &entries, const QStringList &verifiedPaths, QStringList &missingPaths,
+QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList &entries, const QSet<QString> &verifiedPaths, QSet<QString> &missingPaths,
                                              const QStringList &serviceToCheck, const QString &root, const QString &storageFolder)
 {
     QString service = Xml::getXmlProperty(e, QStringLiteral("mlt_service"));
@@ -740,7 +762,7 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
             if (QFileInfo(resource).isRelative()) {
                 resource.prepend(root);
             }
-            if (QFile::exists(resource)) {
+            if (fileExists(resource)) {
                 // Reset to original service
                 Xml::removeXmlProperty(e, QStringLiteral("text"));
                 QString original_service = Xml::getXmlProperty(e, QStringLiteral("kdenlive:orig_service"));
@@ -843,7 +865,7 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
         if (QFileInfo(proxy).isRelative()) {
             proxy.prepend(root);
         }
-        if (!QFile::exists(proxy)) {
+        if (!fileExists(proxy)) {
             // Missing clip found
             // Check if proxy exists in current storage folder
             bool fixed = false;
@@ -870,7 +892,7 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
         if (slideshow && Xml::hasXmlProperty(e, QStringLiteral("ttl"))) {
             original = QFileInfo(original).absolutePath();
         }
-        if (!QFile::exists(original)) {
+        if (!fileExists(original)) {
             bool resourceFixed = false;
             if (!m_rootReplacement.first.isEmpty()) {
                 QString movedOriginal = relocateResource(original);
@@ -879,7 +901,7 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
                         movedOriginal = QDir(movedOriginal).absoluteFilePath(QFileInfo(original).fileName());
                     }
                     Xml::setXmlProperty(e, QStringLiteral("kdenlive:originalurl"), movedOriginal);
-                    if (!QFile::exists(producerResource)) {
+                    if (!fileExists(producerResource)) {
                         Xml::setXmlProperty(e, QStringLiteral("resource"), movedOriginal);
                     }
                     resourceFixed = true;
@@ -898,7 +920,7 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
                 // clip has proxy but original clip is missing
                 m_missingSources.append(e);
             }
-            missingPaths.append(original);
+            missingPaths.insert(original);
         } else if (!proxyFound) {
             m_missingProxies.append(e);
         }
@@ -923,14 +945,14 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
             slideshow = false;
         }
     }
-    if (!QFile::exists(resource)) {
+    if (!fileExists(resource)) {
         if (service == QLatin1String("timewarp") && proxy == QLatin1String("-")) {
             // In some corrupted cases, clips with speed effect kept a reference to proxy clip in warp_resource
             QString original = Xml::getXmlProperty(e, QStringLiteral("kdenlive:originalurl"));
             if (QFileInfo(original).isRelative()) {
                 original.prepend(root);
             }
-            if (original != resource && QFile::exists(original)) {
+            if (original != resource && fileExists(original)) {
                 // Fix timewarp producer
                 Xml::setXmlProperty(e, QStringLiteral("warp_resource"), original);
                 Xml::setXmlProperty(e, QStringLiteral("resource"), Xml::getXmlProperty(e, QStringLiteral("warp_speed")) + QStringLiteral(":") + original);
@@ -947,34 +969,114 @@ QString DocumentChecker::getMissingProducers(QDomElement &e, const QDomNodeList
                          QLatin1String("timeremap")))) {
             // This is a missing timeline sequence clip with speed effect, trigger recreate on opening
             Xml::setXmlProperty(e, QStringLiteral("_rebuild"), QStringLiteral("1"));
-            missingPaths.append(resource);
+            missingPaths.insert(resource);
         } else {
             m_missingClips.append(e);
-            missingPaths.append(resource);
+            missingPaths.insert(resource);
         }
     } else if (isBinClip &&
                (service.startsWith(QLatin1String("avformat")) || slideshow || service == QLatin1String("qimage") || service == QLatin1String("pixbuf"))) {
-        // Check if file changed
-        const QByteArray hash = Xml::getXmlProperty(e, "kdenlive:file_hash").toLatin1();
-        if (!hash.isEmpty()) {
-            const QByteArray fileData =
-                slideshow ? ProjectClip::getFolderHash(QDir(resource), slidePattern).toHex() : ProjectClip::calculateHash(resource).first.toHex();
-            if (hash != fileData) {
-                // For slideshow clips, silently upgrade hash
-                if (slideshow) {
-                    Xml::setXmlProperty(e, "kdenlive:file_hash", fileData);
-                } else {
-                    // Clip was changed, notify and trigger clip reload
-                    Xml::removeXmlProperty(e, "kdenlive:file_hash");
-                    m_changedClips.append(resource);
-                }
-            }
+        // Check if file changed, the hashes are computed together in checkChangedClips
+        if (!Xml::getXmlProperty(e, QStringLiteral("kdenlive:file_hash")).isEmpty()) {
+            m_hashChecks.append({e, resource, slidePattern, slideshow});
         }
     }
     // Make sure we don't query same path twice
     return producerResource;
 }
 
+static QSet<QString> folderEntries(const QString &folder)
+{
+    QSet<QString> entries;
+    QDirIterator it(folder, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if (info.isSymLink() && !info.exists()) {
+            // A broken link does not make the file available
+            continue;
+        }
+#ifdef Q_OS_WIN
+        entries.insert(it.fileName().toLower());
+#else
+        entries.insert(it.fileName());
+#endif
+    }
+    return entries;
+}
+
+void DocumentChecker::listFolders(const QStringList &paths)
+{
+    QSet<QString> folders;
+    for (const QString &path : paths) {
+        const QString folder = QFileInfo(path).absolutePath();
+        if (!m_folderEntries.contains(folder)) {
+            folders.insert(folder);
+        }
+    }
+    QVector<QPair<QString, QSet<QString>>> listings;
+    listings.reserve(folders.size());
+    for (const QString &folder : qAsConst(folders)) {
+        listings.append({folder, {}});
+    }
+    // Network storage is much faster listing a few folders at once than checking files one by one
+    QtConcurrent::blockingMap(listings, [](QPair<QString, QSet<QString>> &listing) { listing.second = folderEntries(listing.first); });
+    for (const auto &listing : qAsConst(listings)) {
+        m_folderEntries.insert(listing.first, listing.second);
+    }
+}
+
+bool DocumentChecker::fileExists(const QString &path)
+{
+    const QFileInfo info(path);
+    const QString name = info.fileName();
+    if (name.isEmpty()) {
+        return info.exists();
+    }
+    const QString folder = info.absolutePath();
+    auto it = m_folderEntries.constFind(folder);
+    if (it == m_folderEntries.constEnd()) {
+        it = m_folderEntries.insert(folder, folderEntries(folder));
+    }
+#ifdef Q_OS_WIN
+    const QString key = name.toLower();
+#else
+    const QString &key = name;
+#endif
+    if (it->contains(key)) {
+        return true;
+    }
+    // The folder cannot be listed, the name differs by case on a case insensitive volume or the file was created meanwhile
+    return info.exists();
+}
+
+void DocumentChecker::invalidateFolder(const QString &path)
+{
+    m_folderEntries.remove(QFileInfo(path).absolutePath());
+}
+
+void DocumentChecker::checkChangedClips()
+{
+    QtConcurrent::blockingMap(m_hashChecks, [](HashCheck &check) {
+        check.fileHash = QString::fromLatin1(check.slideshow ? ProjectClip::getFolderHash(QDir(check.resource), check.slidePattern).toHex()
+                                                             : ProjectClip::calculateHash(check.resource).first.toHex());
+    });
+    for (HashCheck &check : m_hashChecks) {
+        if (check.fileHash == Xml::getXmlProperty(check.element, QStringLiteral("kdenlive:file_hash"))) {
+            continue;
+        }
+        // For slideshow clips, silently upgrade hash
+        if (check.slideshow) {
+            Xml::setXmlProperty(check.element, QStringLiteral("kdenlive:file_hash"), check.fileHash);
+        } else {
+            // Clip was changed, notify and trigger clip reload
+            Xml::removeXmlProperty(check.element, QStringLiteral("kdenlive:file_hash"));
+            m_changedClips.append(check.resource);
+        }
+    }
+    m_hashChecks.clear();
+}
+
 QString DocumentChecker::getProperty(const QDomElement &effect, const QString &name)
 {
     QDomNodeList params = effect.elementsByTagName(QStringLiteral("property"));
@@ -1042,6 +1144,8 @@ void DocumentChecker::slotCheckClips()
 
 void DocumentChecker::slotSearchClips(const QString &newpath)
 {
+    // Files may have been restored since the folders were listed
+    m_folderEntries.clear();
     int ix = 0;
     bool fixed = false;
     QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
@@ -1284,52 +1388,59 @@ QString DocumentChecker::searchDirRecursively(const QDir &dir, const QString &ma
     return QString();
 }
 
+bool DocumentChecker::indexFolder(const QDir &dir)
+{
+    if (m_indexedFolder == dir.absolutePath()) {
+        return true;
+    }
+    m_indexedFolder.clear();
+    m_sizeIndex.clear();
+    m_indexedHashes.clear();
+    Q_EMIT showScanning(i18n("Scanning %1", dir.absolutePath()));
+    // List the whole tree once, the files are only hashed if their size matches a missing clip
+    QDirIterator it(dir.absolutePath(), QDir::Files | QDir::Readable, QDirIterator::Subdirectories);
+    int count = 0;
+    while (it.hasNext()) {
+        it.next();
+        m_sizeIndex.insert(it.fileInfo().size(), it.filePath());
+        if (++count % 200 == 0) {
+            qApp->processEvents();
+            if (m_abortSearch) {
+                m_sizeIndex.clear();
+                return false;
+            }
+        }
+    }
+    m_indexedFolder = dir.absolutePath();
+    return true;
+}
+
 QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName)
 {
     if (matchSize.isEmpty() && matchHash.isEmpty()) {
         return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
     }
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
+    if (!indexFolder(dir)) {
+        return QString();
+    }
+    QStringList candidates = m_sizeIndex.values(matchSize.toLongLong());
+    // Prefer the files having the same name
+    const QString baseName = QFileInfo(fileName).fileName();
+    std::stable_partition(candidates.begin(), candidates.end(), [&baseName](const QString &path) { return QFileInfo(path).fileName() == baseName; });
+    for (const QString &path : qAsConst(candidates)) {
         qApp->processEvents();
         if (m_abortSearch) {
             return QString();
         }
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-            }
+        auto hash = m_indexedHashes.constFind(path);
+        if (hash == m_indexedHashes.constEnd()) {
+            hash = m_indexedHashes.insert(path, QString::fromLatin1(ProjectClip::calculateHash(path).first.toHex()));
         }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash, fileName);
-        if (!foundFileName.isEmpty()) {
-            break;
+        if (hash.value() == matchHash) {
+            return path;
         }
     }
-    return foundFileName;
+    return QString();
 }
 
 void DocumentChecker::slotEditItem(QTreeWidgetItem *item, int)
@@ -1378,6 +1489,7 @@ void DocumentChecker::slotEditItem(QTreeWidgetItem *item, int)
         return;
     }
     item->setText(1, url.toLocalFile());
+    invalidateFolder(url.toLocalFile());
     bool fixed = false;
     if (type == ClipType::SlideShow && QFile::exists(url.adjusted(QUrl::RemoveFilename).toLocalFile())) {
         fixed = true;
@@ -1919,7 +2031,7 @@ void DocumentChecker::checkMissingImagesAndFonts(const QStringList &images, cons
         if (m_safeImages.contains(img)) {
             continue;
         }
-        if (!QFile::exists(img)) {
+        if (!fileExists(img)) {
             QDomElement e = doc.createElement(QStringLiteral("missingtitle"));
             e.setAttribute(QStringLiteral("type"), TITLE_IMAGE_ELEMENT);
             e.setAttribute(QStringLiteral("resource"), img);
@@ -11,6 +11,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QDir>
 #include <QDomElement>
+#include <QHash>
+#include <QSet>
 #include <QUrl>
 
 class DocumentChecker : public QObject
@@ -54,6 +56,33 @@ private:
     QPair<QString, QString> m_rootReplacement;
     QString searchPathRecursively(const QDir &dir, const QString &fileName, ClipType::ProducerType type = ClipType::Unknown);
     QString searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName);
+    /** @brief Build the index of the files of a folder and its subfolders by size, used by searchFileRecursively */
+    bool indexFolder(const QDir &dir);
+    /** @brief The folder indexed for the recursive search, its files by size and the hashes already computed */
+    QString m_indexedFolder;
+    QMultiHash<qint64, QString> m_sizeIndex;
+    QHash<QString, QString> m_indexedHashes;
+    /** @brief Returns true if a file or folder exists, the content of its parent folder is only read once.
+     *  Names missing from the listing are checked on the file system, for example on case insensitive volumes */
+    bool fileExists(const QString &path);
+    /** @brief Drop the listing of the folder containing @p path, after the user fixed a clip in it */
+    void invalidateFolder(const QString &path);
+    /** @brief Read the content of the folders containing these paths in parallel */
+    void listFolders(const QStringList &paths);
+    /** @brief Content of the folders read by fileExists, an empty set means the folder could not be listed */
+    QHash<QString, QSet<QString>> m_folderEntries;
+    /** @brief A bin clip whose file hash has to be compared with the hash stored in the project */
+    struct HashCheck
+    {
+        QDomElement element;
+        QString resource;
+        QString slidePattern;
+        bool slideshow;
+        QString fileHash;
+    };
+    QList<HashCheck> m_hashChecks;
+    /** @brief Compute the hashes of m_hashChecks in parallel and mark the clips whose file changed */
+    void checkChangedClips();
     QString searchDirRecursively(const QDir &dir, const QString &matchHash, const QString &fullName);
     void checkStatus();
     QMap<QString, QString> m_missingTitleImages;
@@ -87,7 +116,7 @@ private:
     /** @brief Remove _missingsourcec flag in fixed clips */
     void fixMissingSource(const QString &id, const QDomNodeList &producers, const QDomNodeList &chains);
     /** @brief Check for various missing elements */
-    QString getMissingProducers(QDomElement &e, const QDomNodeList &entries, const QStringList &verifiedPaths, QStringList &missingPaths,
+    QString getMissingProducers(QDomElement &e, const QDomNodeList &entries, const QSet<QString> &verifiedPaths, QSet<QString> &missingPaths,
                                 const QStringList &serviceToCheck, const QString &root, const QString &storageFolder);
     /** @brief If project path changed, try to relocate its resources */
     const QString relocateResource(QString sourceResource);
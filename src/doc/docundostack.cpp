@@ -4,9 +4,42 @@
 */
 
 #include "docundostack.hpp"
+#include "kdenlivesettings.h"
+#include "undohelper.hpp"
+
+#include <KLocalizedString>
+#include <QDebug>
 #include <QUndoCommand>
 #include <QUndoGroup>
 
+namespace {
+// Commands that are not based on lambdas keep a few strings and values
+const qint64 plainCommandCost = 1024;
+
+qint64 commandCost(const QUndoCommand *cmd)
+{
+    if (cmd->isObsolete()) {
+        return 0;
+    }
+    auto *functional = dynamic_cast<const FunctionalUndoCommand *>(cmd);
+    qint64 cost = functional ? functional->memoryCost() : plainCommandCost;
+    for (int i = 0; i < cmd->childCount(); ++i) {
+        cost += commandCost(cmd->child(i));
+    }
+    return cost;
+}
+
+void releaseCommand(QUndoCommand *cmd)
+{
+    if (auto *functional = dynamic_cast<FunctionalUndoCommand *>(cmd)) {
+        functional->release();
+    }
+    for (int i = 0; i < cmd->childCount(); ++i) {
+        releaseCommand(const_cast<QUndoCommand *>(cmd->child(i)));
+    }
+}
+} // namespace
+
 DocUndoStack::DocUndoStack(QUndoGroup *parent)
     : QUndoStack(parent)
 {
@@ -17,6 +50,60 @@ void DocUndoStack::push(QUndoCommand *cmd)
 {
     if (index() < count()) {
         Q_EMIT invalidate(index());
+        // The undone steps are deleted by the push
+        for (int i = index(); i < count(); ++i) {
+            m_memoryCost -= commandCost(command(i));
+        }
     }
+    const int previousCount = index();
     QUndoStack::push(cmd);
+    if (count() > previousCount) {
+        // Otherwise the command was merged or obsolete and is already deleted
+        m_memoryCost += commandCost(cmd);
+    }
+    if (KdenliveSettings::undomemorylimit() > 0) {
+        compact(qint64(KdenliveSettings::undomemorylimit()) * 1024 * 1024);
+    }
+}
+
+void DocUndoStack::clear()
+{
+    QUndoStack::clear();
+    m_memoryCost = 0;
+}
+
+qint64 DocUndoStack::memoryCost() const
+{
+    return m_memoryCost;
+}
+
+bool DocUndoStack::hasUndoableStep() const
+{
+    // Discarded steps are always at the bottom of the stack
+    return index() > 0 && !command(index() - 1)->isObsolete();
+}
+
+int DocUndoStack::compact(qint64 budget)
+{
+    if (m_memoryCost <= budget) {
+        return 0;
+    }
+    // Steps are discarded from the oldest one so that the remaining history stays consistent. QUndoStack cannot remove
+    // them, so they are kept as empty obsolete commands and hasUndoableStep() stops the undo above them.
+    int discarded = 0;
+    for (int i = 0; i < index() - 1 && m_memoryCost > budget; ++i) {
+        auto *cmd = const_cast<QUndoCommand *>(command(i));
+        if (cmd->isObsolete()) {
+            continue;
+        }
+        m_memoryCost -= commandCost(cmd);
+        releaseCommand(cmd);
+        cmd->setObsolete(true);
+        cmd->setText(i18n("%1 (discarded)", cmd->text()));
+        discarded++;
+    }
+    if (discarded > 0) {
+        qDebug() << "Undo history over budget, discarded" << discarded << "steps, now using" << m_memoryCost / 1024 << "KiB";
+    }
+    return discarded;
 }
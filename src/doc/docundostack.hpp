@@ -16,6 +16,19 @@ class DocUndoStack : public QUndoStack
 public:
     explicit DocUndoStack(QUndoGroup *parent = Q_NULLPTR);
     void push(QUndoCommand *cmd);
+    void clear();
+    /** @brief Estimated memory used by the undo history, in bytes */
+    qint64 memoryCost() const;
+    /** @brief Returns true if the step before the current index can be undone, which is not the case of discarded steps */
+    bool hasUndoableStep() const;
+    /** @brief Discard the oldest steps until the history fits in the given number of bytes, the current step is always kept
+     *  @returns the number of discarded steps */
+    int compact(qint64 budget);
+
+private:
+    /** @brief Running total of the cost of the commands in the stack */
+    qint64 m_memoryCost{0};
+
 Q_SIGNALS:
     void invalidate(int ix);
 };
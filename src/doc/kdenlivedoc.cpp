@@ -42,12 +42,14 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlive_debug.h"
 #include <QCryptographicHash>
 #include <QDomImplementation>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QSaveFile>
 #include <QStandardPaths>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QtConcurrent>
 #include <memory>
 #include <mlt++/Mlt.h>
 
@@ -172,6 +174,8 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         return result;
     }
 
+    QElapsedTimer timer;
+    timer.start();
     QDomDocument domDoc {};
     int line;
     int col;
@@ -223,7 +227,7 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         }
     }
     file.close();
-
+    qCDebug(KDENLIVE_LOG) << "// project file parsed in" << timer.restart() << "ms";
 
     qCDebug(KDENLIVE_LOG) << "// validating project file";
     DocumentValidator validator(domDoc, url);
@@ -254,6 +258,8 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         return result;
     }
 
+    qCDebug(KDENLIVE_LOG) << "// project file validated in" << timer.restart() << "ms";
+
     // TODO: DocumentChecker is still tightly coupled to the GUI
     DocumentChecker d(url, domDoc);
     success = !d.hasErrorInClips();
@@ -262,6 +268,7 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         result.setAborted();
         return result;
     }
+    qCDebug(KDENLIVE_LOG) << "// project clips checked in" << timer.restart() << "ms";
 
     // create KdenliveDoc object
     auto doc = std::unique_ptr<KdenliveDoc>(new KdenliveDoc(url, domDoc, projectFolder, undoGroup, parent));
@@ -326,6 +333,7 @@ KdenliveDoc::~KdenliveDoc()
     m_commandStack->clear();
     m_timelines.clear();
     // qCDebug(KDENLIVE_LOG) << "// DEL CLP MAN done";
+    waitForAutoSave();
     if (m_autosave) {
         if (!m_autosave->fileName().isEmpty()) {
             m_autosave->remove();
@@ -421,12 +429,65 @@ int KdenliveDoc::clipsCount() const
 
 const QByteArray KdenliveDoc::getAndClearProjectXml()
 {
+    useCachedClipMetadata();
     const QByteArray result = m_document.toString().toUtf8();
     // We don't need the xml data anymore, throw away
     m_document.clear();
     return result;
 }
 
+QStringList KdenliveDoc::takeUnprobedClips()
+{
+    QStringList ids;
+    std::swap(ids, m_unprobedClips);
+    return ids;
+}
+
+void KdenliveDoc::useCachedClipMetadata()
+{
+    m_unprobedClips.clear();
+    if (!KdenliveSettings::projectloading_avformatnovalidate()) {
+        return;
+    }
+    for (const QString &tag : {QStringLiteral("producer"), QStringLiteral("chain")}) {
+        QDomNodeList producers = m_document.elementsByTagName(tag);
+        for (int i = 0; i < producers.count(); ++i) {
+            QDomElement prod = producers.at(i).toElement();
+            const QString service = Xml::getXmlProperty(prod, QStringLiteral("mlt_service"));
+            if (service != QLatin1String("avformat") && service != QLatin1String("avformat-novalidate")) {
+                continue;
+            }
+            // The stream properties are only stored for clips that were probed before saving
+            if (!Xml::hasXmlProperty(prod, QStringLiteral("meta.media.nb_streams")) || !Xml::hasXmlProperty(prod, QStringLiteral("length"))) {
+                continue;
+            }
+            QString resource = Xml::getXmlProperty(prod, QStringLiteral("resource"));
+            if (QFileInfo(resource).isRelative()) {
+                resource.prepend(m_documentRoot);
+            }
+            QFileInfo info(resource);
+            if (!info.isFile()) {
+                continue;
+            }
+            const QString proxy = Xml::getXmlProperty(prod, QStringLiteral("kdenlive:proxy"));
+            const QString fileSize = Xml::getXmlProperty(prod, QStringLiteral("kdenlive:file_size"));
+            if ((proxy.isEmpty() || proxy == QLatin1String("-")) && !fileSize.isEmpty() && fileSize.toLongLong() != info.size()) {
+                // The file was modified since the project was saved, let MLT probe it
+                continue;
+            }
+            if (service == QLatin1String("avformat")) {
+                Xml::setXmlProperty(prod, QStringLiteral("mlt_service"), QStringLiteral("avformat-novalidate"));
+            }
+            const QString binId = Xml::getXmlProperty(prod, QStringLiteral("kdenlive:id"));
+            if (!binId.isEmpty()) {
+                m_unprobedClips << binId;
+            }
+        }
+    }
+    // Timeline clips share the id of their bin clip
+    m_unprobedClips.removeDuplicates();
+}
+
 QDomDocument KdenliveDoc::createEmptyDocument(int videotracks, int audiotracks, bool disableProfile)
 {
     QList<TrackInfo> tracks;
@@ -552,28 +613,57 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            (width < 0 || width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt());
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+void KdenliveDoc::slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements)
 {
     if (m_autosave != nullptr) {
-        if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
+        waitForAutoSave();
+        // Opening the autosave file creates its name and lock, it is then replaced by the background write
+        if (!m_autosave->open(QIODevice::ReadWrite)) {
             // show error: could not open the autosave file
             qCDebug(KDENLIVE_LOG) << "ERROR; CANNOT CREATE AUTOSAVE FILE";
             pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
             return;
         }
+        m_autosave->close();
         if (scene.isEmpty()) {
             // Make sure we don't save if scenelist is corrupted
             KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
             return;
         }
-        m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-        }
-        m_autosave->flush();
+        // The GUI thread only builds the scene, the rest is done in the background
+        const QString fileName = m_autosave->fileName();
+        m_autoSaveTask = QtConcurrent::run([fileName, scene, replacements]() {
+            QString data = scene;
+            QMapIterator<QString, QString> i(replacements);
+            while (i.hasNext()) {
+                i.next();
+                data.replace(i.key(), i.value());
+            }
+            if (!data.contains(QLatin1String("<track "))) {
+                // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
+                pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"),
+                                      ErrorMessage);
+                return;
+            }
+            // Write to a temporary file replacing the autosave once complete, so that a crash never leaves a truncated backup
+            QSaveFile file(fileName);
+            if (!file.open(QIODevice::WriteOnly) || file.write(data.toUtf8()) < 0 || !file.commit()) {
+                pCore->displayMessage(i18n("Cannot create autosave file %1", fileName), ErrorMessage);
+            }
+        });
     }
 }
 
+bool KdenliveDoc::isAutoSaving() const
+{
+    return m_autoSaveTask.isRunning();
+}
+
+void KdenliveDoc::waitForAutoSave()
+{
+    m_autoSaveTask.waitForFinished();
+}
+
 void KdenliveDoc::setZoom(const QUuid &uuid, int horizontal, int vertical)
 {
     setSequenceProperty(uuid, QStringLiteral("zoom"), QString::number(horizontal));
@@ -14,6 +14,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QAction>
 #include <QDir>
+#include <QFuture>
 #include <QList>
 #include <QMap>
 #include <QObject>
@@ -103,11 +104,17 @@ public:
     bool closing;
     /** @brief Get current document's producer. */
     const QByteArray getAndClearProjectXml();
+    /** @brief Returns the bin ids of the clips that were built from the metadata stored in the project, without probing their media */
+    QStringList takeUnprobedClips();
     double fps() const;
     int width() const;
     int height() const;
     QUrl url() const;
     KAutoSaveFile *m_autosave;
+    /** @brief Returns true while the autosave file is being written */
+    bool isAutoSaving() const;
+    /** @brief Wait until the autosave file is written, must be called before touching m_autosave */
+    void waitForAutoSave();
     /** @brief Whether the project folder should be in the same folder as the project file (var is only used for new projects)*/
     bool m_sameProjectFolder;
     Timecode timecode() const;
@@ -302,9 +309,13 @@ private:
      *  @param newDocument true if we are creating a new document, false when opening an existing one
      */
     void initializeProperties(bool newDocument = true);
+    /** @brief Switch the avformat clips having stored metadata to avformat-novalidate so that MLT does not open each file on project loading */
+    void useCachedClipMetadata();
     QUuid m_uuid;
     QDomDocument m_document;
     int m_clipsCount;
+    /** @brief Bin ids of the clips loaded without probing their media, see useCachedClipMetadata() */
+    QStringList m_unprobedClips;
     /** @brief MLT's root (base path) that is stripped from urls in saved xml */
     QString m_documentRoot;
     Timecode m_timecode;
@@ -336,6 +347,8 @@ private:
     QSet<QUuid> m_sequenceThumbsNeedsRefresh;
 
     QString m_modifiedDecimalPoint;
+    /** @brief The background write of the autosave file */
+    QFuture<void> m_autoSaveTask;
     /** @brief A list of guide models for this project (one for each timeline). */
     QMap<QUuid, std::shared_ptr<TimelineItemModel>> m_timelines;
     QString searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const;
@@ -369,8 +382,11 @@ public Q_SLOTS:
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
      *
-     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * The path replacements are applied and the file is written in a background thread.
+     * The autosave files are in ~/.kde/data/stalefiles/kdenlive/
+     * @param scene the project xml
+     * @param replacements strings to replace in the scene, for example when the project folder was moved */
+    void slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements = QMap<QString, QString>());
     void switchProfile(ProfileParam* pf, const QString &clipName);
 
 private Q_SLOTS:
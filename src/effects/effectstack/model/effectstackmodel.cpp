@@ -218,7 +218,8 @@ void EffectStackModel::removeEffect(const std::shared_ptr<EffectItemModel> &effe
         update();
         PUSH_LAMBDA(update, redo);
         PUSH_LAMBDA(update2, undo);
-        PUSH_UNDO(undo, redo, i18n("Delete effect %1", effectName));
+        // The undo keeps the removed effect and its parameter values alive
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Delete effect %1", effectName), AssetParameterModel::paramsSize(effect->getAllParameters()));
     } else {
         qDebug() << "..........FAILED EFFECT DELETION";
     }
@@ -230,7 +231,7 @@ bool EffectStackModel::copyXmlEffect(const QDomElement &effect)
     std::function<bool(void)> redo = []() { return true; };
     bool result = fromXml(effect, undo, redo);
     if (result) {
-        PUSH_UNDO(undo, redo, i18n("Copy effect"));
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Copy effect"), FunctionalUndoCommand::xmlSize(effect));
     }
     return result;
 }
@@ -473,7 +474,7 @@ bool EffectStackModel::copyEffect(const std::shared_ptr<AbstractEffectItem> &sou
         if (logUndo) {
             PUSH_LAMBDA(update, local_redo);
             PUSH_LAMBDA(update, local_undo);
-            pCore->pushUndo(local_undo, local_redo, i18n("Paste effect"));
+            pCore->pushUndo(local_undo, local_redo, i18n("Paste effect"), AssetParameterModel::paramsSize(effect->getAllParameters()));
         }
     }
     return res;
@@ -566,7 +567,8 @@ bool EffectStackModel::appendEffect(const QString &effectId, bool makeCurrent)
         update();
         PUSH_LAMBDA(update, redo);
         PUSH_LAMBDA(update_undo, undo);
-        PUSH_UNDO(undo, redo, i18n("Add effect %1", EffectsRepository::get()->getName(effectId)));
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Add effect %1", EffectsRepository::get()->getName(effectId)),
+                            AssetParameterModel::paramsSize(effect->getAllParameters()));
     } else if (makeCurrent) {
         setActiveEffect(currentActive);
     }
@@ -1393,6 +1395,15 @@ bool EffectStackModel::isStackEnabled() const
     return m_effectStackEnabled;
 }
 
+qint64 EffectStackModel::paramsSize() const
+{
+    qint64 size = 0;
+    for (int i = 0; i < rootItem->childCount(); ++i) {
+        size += AssetParameterModel::paramsSize(std::static_pointer_cast<EffectItemModel>(rootItem->child(i))->getAllParameters());
+    }
+    return size;
+}
+
 bool EffectStackModel::addEffectKeyFrame(int frame, double normalisedVal)
 {
     if (rootItem->childCount() == 0) return false;
@@ -117,6 +117,8 @@ public:
     QStringList externalFiles() const;
 
     bool isStackEnabled() const;
+    /** @brief Returns the approximate memory used by the parameter values of all effects, in bytes */
+    qint64 paramsSize() const;
 
     /** @brief Returns an XML representation of the effect stack with all parameters */
     QDomElement toXml(QDomDocument &document);
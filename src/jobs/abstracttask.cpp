@@ -44,25 +44,23 @@ AbstractTask::AbstractTask(const ObjectId &owner, JOBTYPE type, QObject *object)
     , m_isForce(false)
     , m_running(false)
     , m_type(type)
+    , m_queuedTime(0)
+    , m_startTime(-1)
+    , m_processedFrames(0)
+    , m_bytesRead(0)
+    , m_bytesWritten(0)
 {
     setAutoDelete(false);
     m_uuid = QUuid::createUuid();
     switch (type) {
-    case AbstractTask::LOADJOB:
-        m_priority = 10;
-        break;
     case AbstractTask::TRANSCODEJOB:
     case AbstractTask::PROXYJOB:
-        m_priority = 8;
-        break;
-    case AbstractTask::FILTERCLIPJOB:
-    case AbstractTask::STABILIZEJOB:
-    case AbstractTask::ANALYSECLIPJOB:
-    case AbstractTask::SPEEDJOB:
-        m_priority = 5;
+    case AbstractTask::AUDIOTHUMBJOB:
+    case AbstractTask::CACHEJOB:
+        m_priorityClass = BACKGROUND;
         break;
     default:
-        m_priority = 5;
+        m_priorityClass = VISIBLE;
         break;
     }
 }
@@ -85,6 +83,33 @@ const ObjectId AbstractTask::ownerId() const
 
 AbstractTask::~AbstractTask() {}
 
+const QString AbstractTask::description() const
+{
+    QMutexLocker lk(&m_descriptionMutex);
+    return m_description;
+}
+
+void AbstractTask::setDescription(const QString &description)
+{
+    QMutexLocker lk(&m_descriptionMutex);
+    m_description = description;
+}
+
+void AbstractTask::addProcessedFrames(qint64 frames)
+{
+    m_processedFrames.fetchAndAddRelaxed(frames);
+}
+
+void AbstractTask::addBytesRead(qint64 bytes)
+{
+    m_bytesRead.fetchAndAddRelaxed(bytes);
+}
+
+void AbstractTask::addBytesWritten(qint64 bytes)
+{
+    m_bytesWritten.fetchAndAddRelaxed(bytes);
+}
+
 bool AbstractTask::operator==(const AbstractTask &b)
 {
     return m_owner == b.ownerId();
@@ -18,6 +18,7 @@ class AbstractTask : public QObject, public QRunnable
 {
     Q_OBJECT
     friend class TaskManager;
+    friend class TaskRunner;
 
 public:
     enum JOBTYPE {
@@ -34,12 +35,23 @@ public:
         SPEEDJOB = 10,
         CACHEJOB = 11
     };
+    /** @brief Scheduling classes, tasks of a lower class are started first */
+    enum PRIORITYCLASS {
+        /** The user is waiting for the result, for example jobs of the clip displayed in the monitor */
+        INTERACTIVE = 0,
+        /** The result is displayed, for example clip loading or thumbnails of the clips visible in the timeline */
+        VISIBLE = 1,
+        /** Everything else, like audio thumbnails and thumbnail caching */
+        BACKGROUND = 2
+    };
     AbstractTask(const ObjectId &owner, JOBTYPE type, QObject* object);
     ~AbstractTask() override;
     static void closeAll();
     static void setPreferredPriority(qint64 pid);
     const ObjectId ownerId() const;
     bool operator==(const AbstractTask& b);
+    /** @brief The task description displayed in job progress, can be safely read while the task runs */
+    const QString description() const;
 
 protected:
     ObjectId m_owner;
@@ -55,11 +67,24 @@ protected:
     QUuid m_uuid;
     void run() override;
     void cleanup();
+    /** @brief Update the task description from the task thread */
+    void setDescription(const QString &description);
+    /** @brief Count the work done by the task, reported in the job statistics */
+    void addProcessedFrames(qint64 frames);
+    void addBytesRead(qint64 bytes);
+    void addBytesWritten(qint64 bytes);
 
 private:
     //QString cacheKey();
     JOBTYPE m_type;
-    int m_priority;
+    PRIORITYCLASS m_priorityClass;
+    mutable QMutex m_descriptionMutex;
+    /** @brief Time the task was queued and started in milliseconds of the TaskManager clock, the start time is -1 until it runs */
+    qint64 m_queuedTime;
+    QAtomicInteger<qint64> m_startTime;
+    QAtomicInteger<qint64> m_processedFrames;
+    QAtomicInteger<qint64> m_bytesRead;
+    QAtomicInteger<qint64> m_bytesWritten;
     void cancelJob(bool softDelete = false);
 
 Q_SIGNALS:
@@ -6,6 +6,7 @@
 */
 
 #include "audiolevelstask.h"
+#include "audio/audioLevels.h"
 #include "audio/audioStreamInfo.h"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
@@ -20,16 +21,51 @@
 #include <QMutex>
 #include <QRgb>
 #include <QString>
+#include <QThread>
 #include <QThreadPool>
 #include <QTime>
 #include <QVariantList>
+#include <QtConcurrent>
 
 static QList<AudioLevelsTask *> tasksList;
 static QMutex tasksListMutex;
 
-static void deleteQVariantList(QVector<uint8_t> *list)
+static void deleteAudioLevels(AudioLevels *levels)
 {
-    delete list;
+    delete levels;
+}
+
+static void storeLevels(const std::shared_ptr<Mlt::Producer> &producer, int stream, const AudioLevels &levels, bool complete = true)
+{
+    producer->lock();
+    QString key = QString("_kdenlive:audio%1").arg(stream);
+    producer->set(key.toUtf8().constData(), new AudioLevels(levels), 0, (mlt_destructor)deleteAudioLevels);
+    // Partial levels are only meant for display
+    key = QString("_kdenlive:audio_complete%1").arg(stream);
+    producer->set(key.toUtf8().constData(), complete ? 1 : 0);
+    producer->unlock();
+}
+
+/** @brief Convert an audio thumbnail stored in the PNG format used by previous versions */
+static QVector<uint8_t> convertLegacyThumb(const QString &path, int channels)
+{
+    QVector<uint8_t> mltLevels;
+    QImage image(path);
+    if (image.isNull()) {
+        return mltLevels;
+    }
+    image = image.convertToFormat(QImage::Format_ARGB32);
+    // Pixels were stored column by column, one row per channel
+    int n = image.width() * image.height();
+    mltLevels.reserve(4 * n);
+    for (int i = 0; n > 1 && i < n; i++) {
+        QRgb p = reinterpret_cast<const QRgb *>(image.constScanLine(i % channels))[i / channels];
+        mltLevels << qRed(p);
+        mltLevels << qGreen(p);
+        mltLevels << qBlue(p);
+        mltLevels << qAlpha(p);
+    }
+    return mltLevels;
 }
 
 AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject *object)
@@ -40,6 +76,11 @@ AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject *object)
 
 void AudioLevelsTask::start(const ObjectId &owner, QObject *object, bool force)
 {
+    auto *binClip = qobject_cast<ProjectClip *>(object);
+    if (binClip && binClip->delayAudioThumbTask(force)) {
+        // The previous audio levels are being deleted, the task will be started afterwards
+        return;
+    }
     // See if there is already a task for this MLT service and resource.
     if (pCore->taskManager.hasPendingJob(owner, AbstractTask::AUDIOTHUMBJOB)) {
         qDebug() << "AUDIO LEVELS TASK STARTED TWICE!!!!";
@@ -94,6 +135,9 @@ void AudioLevelsTask::run()
     QMap<int, int> audioChannels = binClip->audioInfo()->streamChannels();
     QMapIterator<int, QString> st(streams);
     bool audioCreated = false;
+    bool failed = false;
+    // Streams that have no valid cached levels
+    QList<StreamInfo> toProcess;
     while (st.hasNext() && !m_isCanceled) {
         st.next();
         int stream = st.key();
@@ -102,142 +146,218 @@ void AudioLevelsTask::run()
         }
         // Generate one thumb per stream
         QString cachePath = binClip->getAudioThumbPath(stream);
-        QVector<uint8_t> mltLevels;
-        if (!m_isForce && QFile::exists(cachePath)) {
-            // Audio thumb already exists
-            QImage image(cachePath);
-            if (!m_isCanceled && !image.isNull()) {
-                // convert cached image
-                int n = image.width() * image.height();
-                for (int i = 0; n > 1 && i < n; i++) {
-                    QRgb p = image.pixel(i / channels, i % channels);
-                    mltLevels << qRed(p);
-                    mltLevels << qGreen(p);
-                    mltLevels << qBlue(p);
-                    mltLevels << qAlpha(p);
-                }
+        if (!m_isForce && !cachePath.isEmpty()) {
+            // Audio thumb already exists, map it without copying
+            AudioLevels cached = AudioLevels::load(cachePath);
+            if (!cached.isEmpty() && cached.channels() == channels) {
+                storeLevels(producer, stream, cached);
+                continue;
+            }
+            // Convert thumbs created by previous versions
+            const QString legacyPath = cachePath.left(cachePath.length() - AudioLevels::extension.length()) + QStringLiteral(".png");
+            if (!m_isCanceled && QFile::exists(legacyPath)) {
+                QVector<uint8_t> mltLevels = convertLegacyThumb(legacyPath, channels);
                 if (mltLevels.size() > 0) {
-                    QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                    producer->lock();
-                    QString key = QString("_kdenlive:audio%1").arg(stream);
-                    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                    producer->unlock();
+                    AudioLevels converted(mltLevels, channels, stream, producer->get_fps());
+                    if (converted.save(cachePath)) {
+                        QFile::remove(legacyPath);
+                    }
+                    storeLevels(producer, stream, converted);
                     continue;
                 }
             }
         }
+        toProcess << StreamInfo{stream, channels, cachePath};
+    }
+    if (!toProcess.isEmpty() && !m_isCanceled) {
+        addBytesRead(QFileInfo(binClip->url()).size());
         QString service = producer->get("mlt_service");
         if (service == QLatin1String("avformat-novalidate")) {
             service = QStringLiteral("avformat");
         } else if (service.startsWith(QLatin1String("xml"))) {
             service = QStringLiteral("xml-nogl");
         }
-        QScopedPointer<Mlt::Producer> audioProducer(new Mlt::Producer(producer->get_profile(), service.toUtf8().constData(), producer->get("resource")));
-        if (!audioProducer->is_valid()) {
-            QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection,
-                                      Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", producer->get("resource"))),
-                                      Q_ARG(int, int(KMessageWidget::Warning)));
-            return;
-        }
-        audioProducer->set("video_index", "-1");
-        audioProducer->set("audio_index", stream);
-        Mlt::Filter chans(producer->get_profile(), "audiochannels");
-        Mlt::Filter converter(producer->get_profile(), "audioconvert");
-        Mlt::Filter levels(producer->get_profile(), "audiolevel");
-        audioProducer->attach(chans);
-        audioProducer->attach(converter);
-        audioProducer->attach(levels);
-
-        double framesPerSecond = audioProducer->get_fps();
-        mlt_audio_format audioFormat = mlt_audio_s16;
-        QStringList keys;
-        keys.reserve(channels);
-        for (int i = 0; i < channels; i++) {
-            keys << "meta.media.audio_level." + QString::number(i);
-        }
-        uint maxLevel = 1;
-        QElapsedTimer updateTime;
-        updateTime.start();
-        for (int z = 0; z < lengthInFrames && !m_isCanceled; ++z) {
-            int val = int(100.0 * z / lengthInFrames);
-            if (m_progress != val) {
-                m_progress = val;
-                QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            }
-            QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
-            if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-                int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
-                mltFrame->get_audio(audioFormat, frequency, channels, samples);
-                for (int channel = 0; channel < channels; ++channel) {
-                    uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                    mltLevels << lev;
-                    // double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                    // mltLevels << lev;
-                    maxLevel = qMax(lev, maxLevel);
-                }
-            } else if (!mltLevels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++) {
-                    mltLevels << mltLevels.last();
-                }
-            }
-            // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3000 && !m_isCanceled) {
-                updateTime.restart();
-                QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                producer->lock();
-                QString key = QString("_kdenlive:audio%1").arg(stream);
-                producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                producer->unlock();
-                QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+        m_framesDone = 0;
+        m_totalFrames = qint64(lengthInFrames) * toProcess.size();
+        m_throughputTimer.start();
+        // Split long streams in ranges so that all cores are used and the first part of each range is quickly available
+        const int minRangeLength = qMax(1000, int(120 * producer->get_fps()));
+        const int maxRanges = qMax(1, QThread::idealThreadCount() / toProcess.size());
+        const int rangesPerStream = qBound(1, lengthInFrames / minRangeLength, maxRanges);
+        const int rangeLength = (lengthInFrames + rangesPerStream - 1) / rangesPerStream;
+        std::vector<std::unique_ptr<StreamState>> states;
+        QList<std::pair<StreamState *, int>> ranges;
+        for (const StreamInfo &info : qAsConst(toProcess)) {
+            states.emplace_back(new StreamState);
+            StreamState *state = states.back().get();
+            state->info = info;
+            state->levels = AudioLevels::allocate(lengthInFrames, info.channels, info.stream, producer->get_fps());
+            state->publishTimer.start();
+            for (int start = 0; start < lengthInFrames; start += rangeLength) {
+                ranges << std::make_pair(state, start);
+                state->pendingRanges++;
             }
         }
-
-        /*// Normalize
-        for (double &v : mltLevels) {
-            m_audioLevels << uchar(255 * v / maxLevel);
-        }*/
-        if (m_isCanceled) {
-            mltLevels.clear();
-            m_progress = 100;
-            QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        // Each range is decoded by its own producer, process them concurrently. The first one runs in this thread.
+        QList<QFuture<void>> futures;
+        for (int i = 1; i < ranges.size(); ++i) {
+            int end = qMin(ranges.at(i).second + rangeLength, lengthInFrames);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+            futures << QtConcurrent::run(this, &AudioLevelsTask::processRange, producer, service, ranges.at(i).first, ranges.at(i).second, end, frequency);
+#else
+            futures << QtConcurrent::run(&AudioLevelsTask::processRange, this, producer, service, ranges.at(i).first, ranges.at(i).second, end, frequency);
+#endif
         }
-        if (mltLevels.size() > 0) {
-            QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-            producer->lock();
-            QString key = QString("_kdenlive:audio%1").arg(stream);
-            QString key2 = QString("kdenlive:audio_max%1").arg(stream);
-            producer->set(key2.toUtf8().constData(), int(maxLevel));
-            producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-            producer->unlock();
-            // qDebug()<<"=== FINISHED PRODUCING AUDIO FOR: "<<key<<", SIZE: "<<levelsCopy->size();
-            m_progress = 100;
-            QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            // Put into an image for caching.
-            int count = mltLevels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(mltLevels.at(4 * i), mltLevels.at(4 * i + 1), mltLevels.at(4 * i + 2), mltLevels.at(4 * i + 3));
-                } else {
-                    int last = mltLevels.last();
-                    int r = (4 * i + 0) < count ? mltLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? mltLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? mltLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / channels, i % channels, p);
-            }
-            image.save(cachePath);
-            audioCreated = true;
-            QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+        processRange(producer, service, ranges.constFirst().first, 0, qMin(rangeLength, lengthInFrames), frequency);
+        for (auto &future : futures) {
+            future.waitForFinished();
+        }
+        for (const auto &state : states) {
+            audioCreated = state->created || audioCreated;
+            failed = state->failed || failed;
         }
     }
+    if (m_isCanceled) {
+        m_progress = 100;
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    } else if (failed) {
+        // Some levels are missing, keep them displayed but let the thumbnail be generated again later
+        QMetaObject::invokeMethod(m_object, "updatePartialAudioThumbnail");
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        return;
+    } else if (audioCreated) {
+        QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+    }
     if (!audioCreated && !m_isCanceled) {
         // Audio was cached, ensure the bin thumbnail is loaded
         QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, true));
     }
     QMetaObject::invokeMethod(m_object, "updateJobProgress");
 }
+
+void AudioLevelsTask::reportProgress(qint64 frames)
+{
+    addProcessedFrames(frames);
+    QMutexLocker lk(&m_progressMutex);
+    m_framesDone += frames;
+    int val = int(100 * m_framesDone / qMax(qint64(1), m_totalFrames));
+    qint64 elapsed = m_throughputTimer.elapsed();
+    if (m_progress != val && elapsed > 0) {
+        m_progress = val;
+        setDescription(i18n("Audio thumbs (%1 frames/s)", m_framesDone * 1000 / elapsed));
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    }
+}
+
+void AudioLevelsTask::processRange(const std::shared_ptr<Mlt::Producer> &producer, const QString &service, StreamState *state, int startFrame, int endFrame,
+                                   int frequency)
+{
+    const int stream = state->info.stream;
+    const int channels = state->info.channels;
+    QScopedPointer<Mlt::Producer> audioProducer(new Mlt::Producer(producer->get_profile(), service.toUtf8().constData(), producer->get("resource")));
+    if (!audioProducer->is_valid()) {
+        QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection,
+                                  Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", producer->get("resource"))),
+                                  Q_ARG(int, int(KMessageWidget::Warning)));
+        QMutexLocker lk(&state->mutex);
+        state->failed = true;
+        state->pendingRanges--;
+        return;
+    }
+    audioProducer->set("video_index", "-1");
+    audioProducer->set("audio_index", stream);
+    Mlt::Filter chans(producer->get_profile(), "audiochannels");
+    Mlt::Filter converter(producer->get_profile(), "audioconvert");
+    Mlt::Filter levels(producer->get_profile(), "audiolevel");
+    audioProducer->attach(chans);
+    audioProducer->attach(converter);
+    audioProducer->attach(levels);
+    if (startFrame > 0) {
+        audioProducer->seek(startFrame);
+    }
+
+    double framesPerSecond = audioProducer->get_fps();
+    mlt_audio_format audioFormat = mlt_audio_s16;
+    // Build the property names only once instead of for each frame
+    std::vector<QByteArray> keys;
+    keys.reserve(size_t(channels));
+    for (int i = 0; i < channels; i++) {
+        keys.push_back(QByteArray("meta.media.audio_level.") + QByteArray::number(i));
+    }
+    // Levels of this range, copied in the stream levels when published
+    QVector<uint8_t> mltLevels;
+    mltLevels.reserve((endFrame - startFrame) * channels);
+    uint maxLevel = 1;
+    int published = 0;
+    int reported = startFrame;
+    QElapsedTimer updateTime;
+    updateTime.start();
+    auto publish = [&]() {
+        QMutexLocker lk(&state->mutex);
+        // Only the new frames are copied, the clip shares the stream levels
+        state->levels.setLevels(startFrame + published / channels, mltLevels.constData() + published, (mltLevels.size() - published) / channels);
+        published = mltLevels.size();
+        state->maxLevel = qMax(state->maxLevel, maxLevel);
+        // Make the ready parts of the stream available to the timeline, at most once per second for all ranges
+        if (state->publishTimer.elapsed() > 1000) {
+            state->publishTimer.restart();
+            storeLevels(producer, stream, state->levels, false);
+            QMetaObject::invokeMethod(m_object, "updatePartialAudioThumbnail");
+        }
+    };
+    for (int z = startFrame; z < endFrame && !m_isCanceled; ++z) {
+        QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
+        if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
+            int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
+            mltFrame->get_audio(audioFormat, frequency, channels, samples);
+            for (int channel = 0; channel < channels; ++channel) {
+                uint lev = 256 * qMin(mltFrame->get_double(keys[size_t(channel)].constData()) * 0.9, 1.0);
+                mltLevels << lev;
+                maxLevel = qMax(lev, maxLevel);
+            }
+        } else if (!mltLevels.isEmpty()) {
+            for (int channel = 0; channel < channels; channel++) {
+                mltLevels << mltLevels.last();
+            }
+        } else {
+            mltLevels.append(QVector<uint8_t>(channels, 0));
+        }
+        if (z - reported >= 25) {
+            reportProgress(z - reported);
+            reported = z;
+        }
+        // Incrementally update the audio levels
+        if (updateTime.elapsed() > 1000 && !m_isCanceled) {
+            updateTime.restart();
+            publish();
+        }
+    }
+    reportProgress(endFrame - reported);
+    if (m_isCanceled) {
+        QMutexLocker lk(&state->mutex);
+        state->pendingRanges--;
+        return;
+    }
+    publish();
+    QMutexLocker lk(&state->mutex);
+    if (--state->pendingRanges > 0 || state->failed) {
+        // Other ranges of this stream are still running
+        return;
+    }
+    // Last range of the stream, save the levels
+    AudioLevels levelsData = state->levels;
+    producer->lock();
+    QString key2 = QString("kdenlive:audio_max%1").arg(stream);
+    producer->set(key2.toUtf8().constData(), int(state->maxLevel));
+    producer->unlock();
+    // Cache the levels in the binary peak format, then map them so that the heap buffer can be released
+    if (levelsData.save(state->info.cachePath)) {
+        addBytesWritten(QFileInfo(state->info.cachePath).size());
+        AudioLevels mapped = AudioLevels::load(state->info.cachePath);
+        if (!mapped.isEmpty()) {
+            levelsData = mapped;
+        }
+    }
+    storeLevels(producer, stream, levelsData);
+    state->created = true;
+}
@@ -9,9 +9,18 @@
 #pragma once
 
 #include "abstracttask.h"
+#include "audio/audioLevels.h"
 
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QRunnable>
 #include <QObject>
+#include <QVector>
+#include <memory>
+
+namespace Mlt {
+class Producer;
+}
 
 class AudioLevelsTask : public AbstractTask
 {
@@ -22,4 +31,34 @@ public:
 protected:
     void run() override;
 
+private:
+    struct StreamInfo
+    {
+        int stream;
+        int channels;
+        QString cachePath;
+    };
+    /** @brief Levels of a stream, filled concurrently by several ranges */
+    struct StreamState
+    {
+        StreamInfo info;
+        QMutex mutex;
+        /** Levels of the whole stream, filled by the ranges as they are decoded */
+        AudioLevels levels;
+        QElapsedTimer publishTimer;
+        uint maxLevel{1};
+        int pendingRanges{0};
+        bool failed{false};
+        bool created{false};
+    };
+    /** @brief Decode a range of frames of an audio stream. Ready parts are published to the clip while processing
+        and the last finished range of a stream saves its levels */
+    void processRange(const std::shared_ptr<Mlt::Producer> &producer, const QString &service, StreamState *state, int startFrame, int endFrame,
+                      int frequency);
+    /** @brief Add processed frames to the progress, can be called from several threads */
+    void reportProgress(qint64 frames);
+    QMutex m_progressMutex;
+    QElapsedTimer m_throughputTimer;
+    qint64 m_framesDone{0};
+    qint64 m_totalFrames{0};
 };
@@ -17,8 +17,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <KLocalizedString>
 #include <QFile>
 #include <QImage>
+#include <QProcess>
 #include <QString>
 #include <QtMath>
+#include <algorithm>
 #include <set>
 
 CacheTask::CacheTask(const ObjectId &owner, int thumbsCount, int in, int out, QObject *object)
@@ -47,22 +49,95 @@ void CacheTask::start(const ObjectId &owner, int thumbsCount, int in, int out, Q
     pCore->taskManager.startTask(owner.second, task);
 }
 
+QVector<int> CacheTask::scanKeyframes(const std::shared_ptr<ProjectClip> &binClip)
+{
+    QVector<int> keyframes;
+    if (KdenliveSettings::ffprobepath().isEmpty()) {
+        return keyframes;
+    }
+    // Only the packet flags are read, no frame is decoded
+    const int videoIndex = binClip->getProducerIntProperty(QStringLiteral("video_index"));
+    QStringList parameters = {QStringLiteral("-v"),
+                              QStringLiteral("error"),
+                              QStringLiteral("-select_streams"),
+                              videoIndex >= 0 ? QString::number(videoIndex) : QStringLiteral("v:0"),
+                              QStringLiteral("-show_entries"),
+                              QStringLiteral("packet=pts_time,flags"),
+                              QStringLiteral("-of"),
+                              QStringLiteral("csv=p=0"),
+                              binClip->url()};
+    QProcess probe;
+    probe.start(KdenliveSettings::ffprobepath(), parameters, QIODevice::ReadOnly);
+    while (!probe.waitForFinished(100)) {
+        if (probe.state() == QProcess::NotRunning) {
+            return keyframes;
+        }
+        if (m_isCanceled || pCore->taskManager.isBlocked()) {
+            probe.kill();
+            probe.waitForFinished();
+            return keyframes;
+        }
+    }
+    if (probe.exitStatus() != QProcess::NormalExit || probe.exitCode() != 0) {
+        return keyframes;
+    }
+    // Packet times include the stream start time, MLT positions start at the first packet
+    std::vector<double> times;
+    double start = -1;
+    const QList<QByteArray> lines = probe.readAllStandardOutput().split('\n');
+    for (const QByteArray &line : lines) {
+        const QList<QByteArray> fields = line.trimmed().split(',');
+        if (fields.size() < 2) {
+            continue;
+        }
+        bool ok;
+        double time = fields.at(0).toDouble(&ok);
+        if (!ok) {
+            continue;
+        }
+        if (start < 0 || time < start) {
+            start = time;
+        }
+        if (fields.at(1).contains('K')) {
+            times.push_back(time);
+        }
+    }
+    const double fps = pCore->getCurrentFps();
+    for (double time : times) {
+        keyframes << qRound((time - start) * fps);
+    }
+    std::sort(keyframes.begin(), keyframes.end());
+    keyframes.erase(std::unique(keyframes.begin(), keyframes.end()), keyframes.end());
+    return keyframes;
+}
+
 void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
 {
     // Fetch thumbnail
     if (binClip->clipType() != ClipType::Audio) {
+        if (KdenliveSettings::thumbseektolerance() > 0 && (binClip->clipType() == ClipType::AV || binClip->clipType() == ClipType::Video) &&
+            !binClip->hasThumbKeyframes()) {
+            const QVector<int> keyframes = scanKeyframes(binClip);
+            if (m_isCanceled) {
+                return;
+            }
+            binClip->setThumbKeyframes(keyframes);
+        }
         std::shared_ptr<Mlt::Producer> thumbProd(nullptr);
+        bool pooled = false;
         int duration = m_out > 0 ? m_out - m_in : binClip->getFramePlaytime();
         std::set<int> frames;
         int steps = qCeil(qMax(pCore->getCurrentFps(), double(duration) / m_thumbsCount));
         int pos = m_in;
         for (int i = 1; i <= m_thumbsCount && pos <= m_in + duration; ++i) {
-            frames.insert(pos);
+            // With keyframes known, only keyframes are decoded and thumbnails are stored under their position
+            frames.insert(binClip->thumbSeekPosition(pos));
             pos = m_in + (steps * i);
         }
         int size = int(frames.size());
         int count = 0;
         const QString clipId = QString::number(m_owner.second);
+        std::vector<std::pair<int, QImage>> generated;
         for (int i : frames) {
             m_progress = 100 * count / size;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
@@ -74,7 +149,12 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
                 continue;
             }
             if (thumbProd == nullptr) {
-                thumbProd = binClip->thumbProducer();
+                // Borrow a producer so that the timeline thumbnails are not blocked meanwhile
+                thumbProd = binClip->takeThumbProducer();
+                pooled = thumbProd != nullptr;
+                if (!pooled) {
+                    thumbProd = binClip->thumbProducer();
+                }
             }
             if (thumbProd == nullptr) {
                 // Thumb producer not available
@@ -89,10 +169,17 @@ void CacheTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip)
                 QImage result = KThumb::getFrame(frame.data(), 0, 0, m_fullWidth);
                 if (!result.isNull() && !m_isCanceled) {
                     qDebug() << "==== CACHING FRAME: " << i;
-                    ThumbnailCache::get()->storeThumbnail(clipId, i, result, true);
+                    ThumbnailCache::get()->storeThumbnail(clipId, i, result, false);
+                    generated.push_back({i, result});
+                    addProcessedFrames(1);
                 }
             }
         }
+        if (pooled) {
+            binClip->releaseThumbProducer(thumbProd);
+        }
+        // Write all generated thumbnails to the persistent cache in one batch, the volatile cache may already have evicted some
+        ThumbnailCache::get()->saveThumbnails(clipId, generated);
     }
 }
 
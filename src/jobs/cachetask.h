@@ -16,6 +16,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDomElement>
 #include <QObject>
 #include <QList>
+#include <QVector>
 
 class ProjectClip;
 
@@ -37,4 +38,6 @@ private:
     std::function<void()> m_readyCallBack;
     QString m_errorMessage;
     void generateThumbnail(std::shared_ptr<ProjectClip>binClip);
+    /** @brief Read the positions of the video keyframes of the clip with ffprobe */
+    QVector<int> scanKeyframes(const std::shared_ptr<ProjectClip> &binClip);
 };
@@ -14,6 +14,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/probecache.hpp"
 #include "utils/thumbnailcache.hpp"
 
 #include "xml/xml.hpp"
@@ -228,6 +229,29 @@ void ClipLoadTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip, std::
             QMetaObject::invokeMethod(binClip.get(), "setThumbnail", Qt::QueuedConnection, Q_ARG(QImage, thumb), Q_ARG(int, m_in), Q_ARG(int, m_out),
                                       Q_ARG(bool, true));
         } else {
+            // The first frame of unchanged media files is shared by all projects
+            const bool sharedThumb = frameNumber == 0 && (binClip->clipType() == ClipType::AV || binClip->clipType() == ClipType::Video);
+            const int imageHeight(pCore->thumbProfile()->height());
+            const int fullWidth(qRound(imageHeight * pCore->getCurrentDar()));
+            QString thumbVariant;
+            if (sharedThumb) {
+                // The thumbnail producer gets the pass list properties of the clip (stream, rotation, aspect ratio...), they are part of the key
+                const QStringList passList = QString::fromLatin1(ClipController::getPassPropertiesList(false)).split(QLatin1Char(','));
+                QStringList variant;
+                for (const QString &name : passList) {
+                    if (!name.startsWith(QLatin1String("kdenlive:")) && name != QLatin1String("file_hash")) {
+                        variant << QStringLiteral("%1=%2").arg(name, binClip->getProducerProperty(name));
+                    }
+                }
+                thumbVariant = variant.join(QLatin1Char(','));
+                thumb = ProbeCache::get()->thumbnail(binClip->url(), thumbVariant);
+                if (thumb.size() == QSize(fullWidth, imageHeight)) {
+                    QMetaObject::invokeMethod(binClip.get(), "setThumbnail", Qt::QueuedConnection, Q_ARG(QImage, thumb), Q_ARG(int, m_in),
+                                              Q_ARG(int, m_out), Q_ARG(bool, false));
+                    ThumbnailCache::get()->storeThumbnail(QString::number(m_owner.second), frameNumber, thumb, false);
+                    return;
+                }
+            }
             std::shared_ptr<Mlt::Producer> thumbProd = binClip->thumbProducer();
             if (thumbProd && thumbProd->is_valid()) {
                 if (frameNumber > 0) {
@@ -238,9 +262,7 @@ void ClipLoadTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip, std::
                     frame->set("consumer.deinterlacer", "onefield");
                     frame->set("consumer.top_field_first", -1);
                     frame->set("consumer.rescale", "nearest");
-                    int imageHeight(pCore->thumbProfile()->height());
                     int imageWidth(pCore->thumbProfile()->width());
-                    int fullWidth(qRound(imageHeight * pCore->getCurrentDar()));
                     if (m_isCanceled.loadAcquire() || pCore->taskManager.isBlocked()) {
                         return;
                     }
@@ -260,6 +282,10 @@ void ClipLoadTask::generateThumbnail(std::shared_ptr<ProjectClip> binClip, std::
                         QMetaObject::invokeMethod(binClip.get(), "setThumbnail", Qt::QueuedConnection, Q_ARG(QImage, result), Q_ARG(int, m_in),
                                                   Q_ARG(int, m_out), Q_ARG(bool, false));
                         ThumbnailCache::get()->storeThumbnail(QString::number(m_owner.second), frameNumber, result, false);
+                        if (sharedThumb) {
+                            ProbeCache::get()->storeThumbnail(binClip->url(), thumbVariant, result);
+                        }
+                        addProcessedFrames(1);
                     }
                 }
             }
@@ -658,6 +684,11 @@ void ClipLoadTask::run()
             }
         }
 
+        // Remember the media properties for the next projects using this file
+        if (!m_isCanceled.loadAcquire() && !producer->property_exists("force_fps")) {
+            ProbeCache::get()->storeMedia(resource, *producer.get());
+        }
+
         // Check for variable frame rate
         isVariableFrameRate = producer->get_int("meta.media.variable_frame_rate");
         if (isVariableFrameRate && seekable) {
@@ -0,0 +1,79 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "clipprobetask.h"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "utils/probecache.hpp"
+
+#include <KLocalizedString>
+#include <QApplication>
+#include <QDebug>
+#include <mlt++/MltProducer.h>
+
+ClipProbeTask::ClipProbeTask(const ObjectId &owner, QObject *object)
+    : AbstractTask(owner, AbstractTask::LOADJOB, object)
+{
+    m_description = i18n("Checking clip");
+}
+
+void ClipProbeTask::start(const ObjectId &owner, QObject *object, const std::function<void()> &readyCallBack)
+{
+    auto *task = new ClipProbeTask(owner, object);
+    connect(task, &ClipProbeTask::taskDone, [readyCallBack]() { QMetaObject::invokeMethod(qApp, [readyCallBack] { readyCallBack(); }); });
+    pCore->taskManager.startTask(owner.second, task);
+}
+
+void ClipProbeTask::run()
+{
+    AbstractTaskDone whenFinished(m_owner.second, this);
+    if (m_isCanceled.loadAcquire() == 1 || pCore->taskManager.isBlocked()) {
+        Q_EMIT taskDone();
+        return;
+    }
+    QMutexLocker lock(&m_runMutex);
+    m_running = true;
+    std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(QString::number(m_owner.second));
+    if (!binClip || !binClip->statusReady()) {
+        Q_EMIT taskDone();
+        return;
+    }
+    const QString resource = binClip->getProducerProperty(QStringLiteral("resource"));
+    const bool forcedFps = !binClip->getProducerProperty(QStringLiteral("force_fps")).isEmpty();
+    // Unchanged files were already probed by this or another project
+    QMap<QString, QString> media = ProbeCache::get()->properties(resource);
+    bool changed = false;
+    if (media.isEmpty()) {
+        Mlt::Producer probe(*pCore->getProjectProfile(), "avformat", resource.toUtf8().constData());
+        changed = !probe.is_valid();
+        if (!changed) {
+            ProbeCache::get()->storeMedia(resource, probe);
+            for (const char *property : {"meta.media.nb_streams", "meta.media.width", "meta.media.height"}) {
+                media.insert(QString::fromLatin1(property), QString::fromUtf8(probe.get(property)));
+            }
+            media.insert(QStringLiteral("duration"), QString::number(probe.get_length() / pCore->getCurrentFps(), 'f', 6));
+        }
+    }
+    if (!changed) {
+        // Compare the stored stream layout with the actual media
+        for (const QString &property : {QStringLiteral("meta.media.nb_streams"), QStringLiteral("meta.media.width"), QStringLiteral("meta.media.height")}) {
+            if (binClip->getProducerProperty(property) != media.value(property)) {
+                changed = true;
+                break;
+            }
+        }
+        // The length of clips with a forced frame rate does not match the media duration
+        const int length = qRound(media.value(QStringLiteral("duration")).toDouble() * pCore->getCurrentFps());
+        if (!forcedFps && binClip->getProducerIntProperty(QStringLiteral("length")) != length) {
+            changed = true;
+        }
+    }
+    if (changed && m_isCanceled.loadAcquire() == 0 && !pCore->taskManager.isBlocked()) {
+        qDebug() << "::: CLIP" << resource << "DOES NOT MATCH ITS STORED METADATA, RELOADING";
+        QMetaObject::invokeMethod(binClip.get(), [binClip]() { binClip->reloadProducer(); }, Qt::QueuedConnection);
+    }
+    Q_EMIT taskDone();
+}
@@ -0,0 +1,29 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "abstracttask.h"
+#include "definitions.h"
+
+#include <QObject>
+#include <functional>
+
+/** @class ClipProbeTask
+    @brief Opens the media of a clip that was loaded from the metadata stored in the project, and reloads the clip if the media does not match anymore
+ */
+class ClipProbeTask : public AbstractTask
+{
+    Q_OBJECT
+public:
+    ClipProbeTask(const ObjectId &owner, QObject *object);
+    static void start(const ObjectId &owner, QObject *object, const std::function<void()> &readyCallBack = []() {});
+
+protected:
+    void run() override;
+
+Q_SIGNALS:
+    void taskDone();
+};
@@ -23,6 +23,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 ProxyTask::ProxyTask(const ObjectId &owner, QObject *object)
     : AbstractTask(owner, AbstractTask::PROXYJOB, object)
     , m_jobDuration(0)
+    , m_framesReported(0)
     , m_isFfmpegJob(true)
     , m_jobProcess(nullptr)
 {
@@ -351,6 +352,8 @@ void ProxyTask::run()
     }
     // remove temporary playlist if it exists
     m_progress = 100;
+    addBytesRead(QFileInfo(source).size());
+    addBytesWritten(QFileInfo(dest).size());
     if (result && !m_isCanceled) {
         if (QFileInfo(dest).size() == 0) {
             QFile::remove(dest);
@@ -395,6 +398,12 @@ void ProxyTask::processLogInfo()
                 }
             }
         } else if (buffer.contains(QLatin1String("time="))) {
+            // Processed frames are reported as "frame=  123"
+            const qint64 frame = buffer.section(QStringLiteral("frame="), -1).simplified().section(QLatin1Char(' '), 0, 0).toLongLong();
+            if (frame > m_framesReported) {
+                addProcessedFrames(frame - m_framesReported);
+                m_framesReported = frame;
+            }
             int progress = 0;
             QString time = buffer.section(QStringLiteral("time="), 1, 1).simplified().section(QLatin1Char(' '), 0, 0);
             if (!time.isEmpty()) {
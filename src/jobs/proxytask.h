@@ -24,6 +24,7 @@ private Q_SLOTS:
 
 private:
     int m_jobDuration;
+    qint64 m_framesReported;
     bool m_isFfmpegJob;
     std::unique_ptr<QProcess> m_jobProcess;
     QString m_errorMessage;
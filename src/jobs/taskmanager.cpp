@@ -16,17 +16,96 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <KMessageWidget>
 #include <QFuture>
+#include <QJsonObject>
+#include <QRunnable>
 #include <QThread>
 
+namespace {
+// How long a clip stays visible after it was last marked, in milliseconds
+const qint64 visibleTimeout = 5000;
+
+bool isTranscodeJob(AbstractTask::JOBTYPE type)
+{
+    return type == AbstractTask::TRANSCODEJOB || type == AbstractTask::PROXYJOB;
+}
+
+const QString jobTypeName(AbstractTask::JOBTYPE type)
+{
+    switch (type) {
+    case AbstractTask::PROXYJOB:
+        return QStringLiteral("proxy");
+    case AbstractTask::CUTJOB:
+        return QStringLiteral("cut");
+    case AbstractTask::STABILIZEJOB:
+        return QStringLiteral("stabilize");
+    case AbstractTask::TRANSCODEJOB:
+        return QStringLiteral("transcode");
+    case AbstractTask::FILTERCLIPJOB:
+        return QStringLiteral("filter");
+    case AbstractTask::THUMBJOB:
+        return QStringLiteral("thumbnail");
+    case AbstractTask::ANALYSECLIPJOB:
+        return QStringLiteral("analyse");
+    case AbstractTask::LOADJOB:
+        return QStringLiteral("load");
+    case AbstractTask::AUDIOTHUMBJOB:
+        return QStringLiteral("audiothumb");
+    case AbstractTask::SPEEDJOB:
+        return QStringLiteral("speed");
+    case AbstractTask::CACHEJOB:
+        return QStringLiteral("cache");
+    default:
+        return QStringLiteral("other");
+    }
+}
+} // namespace
+
+/** @class TaskRunner
+    @brief Runs a task picked by the TaskManager, then lets it start the next pending tasks
+ */
+class TaskRunner : public QRunnable
+{
+public:
+    TaskRunner(TaskManager *manager, AbstractTask *task, bool background)
+        : owner(task->m_owner)
+        , type(task->m_type)
+        , transcode(isTranscodeJob(task->m_type))
+        , background(background)
+        , m_manager(manager)
+        , m_task(task)
+    {
+    }
+    void run() override
+    {
+        m_task->m_startTime.storeRelaxed(m_manager->m_clock.elapsed());
+        // The task is deleted once done, don't access it after this
+        m_task->run();
+        m_manager->runnerDone(this);
+    }
+    const ObjectId owner;
+    const AbstractTask::JOBTYPE type;
+    const bool transcode;
+    const bool background;
+
+private:
+    TaskManager *m_manager;
+    AbstractTask *m_task;
+};
+
 TaskManager::TaskManager(QObject *parent)
     : QObject(parent)
     , displayedClip(-1)
     , m_tasksListLock(QReadWriteLock::Recursive)
     , m_blockUpdates(false)
+    , m_runningTasks(0)
+    , m_runningTranscodes(0)
+    , m_runningBackground(0)
+    , m_statisticsStart(0)
 {
-    int maxThreads = qMin(4, QThread::idealThreadCount() - 1);
-    m_taskPool.setMaxThreadCount(qMax(maxThreads, 1));
+    // Background tasks cannot take all threads, so there is no reason to keep the pool small
+    m_taskPool.setMaxThreadCount(qMax(QThread::idealThreadCount() - 1, 1));
     m_transcodePool.setMaxThreadCount(KdenliveSettings::proxythreads());
+    m_clock.start();
 }
 
 TaskManager::~TaskManager()
@@ -42,9 +121,164 @@ bool TaskManager::isBlocked() const
 void TaskManager::updateConcurrency()
 {
     m_transcodePool.setMaxThreadCount(KdenliveSettings::proxythreads());
+    scheduleTasks();
+}
+
+void TaskManager::markVisible(int binId)
+{
+    QMutexLocker lk(&m_queueMutex);
+    const qint64 now = m_clock.elapsed();
+    if (m_visibleClips.size() > 256) {
+        // Forget the clips that scrolled out of view long ago
+        for (auto it = m_visibleClips.begin(); it != m_visibleClips.end();) {
+            if (now - it.value() > visibleTimeout) {
+                it = m_visibleClips.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    m_visibleClips.insert(binId, now);
+}
+
+AbstractTask::PRIORITYCLASS TaskManager::effectiveClass(const AbstractTask *task) const
+{
+    if (task->m_owner.first != ObjectType::BinClip) {
+        return task->m_priorityClass;
+    }
+    if (task->m_owner.second == displayedClip) {
+        // The user is looking at this clip in the monitor
+        return AbstractTask::INTERACTIVE;
+    }
+    if (task->m_priorityClass == AbstractTask::BACKGROUND) {
+        auto it = m_visibleClips.constFind(task->m_owner.second);
+        if (it != m_visibleClips.constEnd() && m_clock.elapsed() - it.value() < visibleTimeout) {
+            return AbstractTask::VISIBLE;
+        }
+    }
+    return task->m_priorityClass;
 }
 
-void TaskManager::discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type, bool softDelete, const QVector<AbstractTask::JOBTYPE> exceptions)
+void TaskManager::scheduleTasks()
+{
+    QMutexLocker lk(&m_queueMutex);
+    if (m_blockUpdates) {
+        return;
+    }
+    // Drop the tasks canceled before they got a thread
+    std::vector<AbstractTask *> canceled;
+    for (auto it = m_pendingTasks.begin(); it != m_pendingTasks.end();) {
+        if (it->second->m_isCanceled) {
+            canceled.push_back(it->second);
+            it = m_pendingTasks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (!canceled.empty()) {
+        lk.unlock();
+        for (AbstractTask *task : canceled) {
+            // The task only goes through its cancel branch (for example to mark a clip that was loading as missing), then removes itself
+            task->run();
+        }
+        lk.relock();
+        if (m_blockUpdates) {
+            return;
+        }
+    }
+    const int maxTasks = m_taskPool.maxThreadCount();
+    const int maxTranscodes = m_transcodePool.maxThreadCount();
+    // Always leave a thread for interactive and visible tasks
+    const int maxBackground = qMax(1, maxTasks - 1);
+    while (!m_pendingTasks.empty()) {
+        // Pick the first task of the best class that can start now
+        int best = -1;
+        AbstractTask::PRIORITYCLASS bestClass = AbstractTask::BACKGROUND;
+        for (size_t i = 0; i < m_pendingTasks.size(); ++i) {
+            const AbstractTask *t = m_pendingTasks.at(i).second;
+            const bool transcode = isTranscodeJob(t->m_type);
+            if (transcode ? m_runningTranscodes >= maxTranscodes : m_runningTasks >= maxTasks) {
+                continue;
+            }
+            if (isRunning(t->m_owner, t->m_type)) {
+                // Cancellation does not wait, a canceled task may still be running: never overlap it with its replacement
+                continue;
+            }
+            const AbstractTask::PRIORITYCLASS taskClass = effectiveClass(t);
+            if (!transcode && taskClass == AbstractTask::BACKGROUND && m_runningBackground >= maxBackground) {
+                continue;
+            }
+            if (best < 0 || taskClass < bestClass) {
+                best = int(i);
+                bestClass = taskClass;
+                if (bestClass == AbstractTask::INTERACTIVE) {
+                    break;
+                }
+            }
+        }
+        if (best < 0) {
+            // All threads are busy
+            break;
+        }
+        AbstractTask *task = m_pendingTasks.at(size_t(best)).second;
+        m_pendingTasks.erase(m_pendingTasks.begin() + best);
+        const bool transcode = isTranscodeJob(task->m_type);
+        auto *runner = new TaskRunner(this, task, !transcode && bestClass == AbstractTask::BACKGROUND);
+        m_runningJobs.emplace_back(runner->owner, runner->type);
+        if (transcode) {
+            // We only want a limited concurrent jobs for those as for example GPU usually only accept 2 concurrent encoding jobs
+            m_runningTranscodes++;
+            m_transcodePool.start(runner);
+        } else {
+            m_runningTasks++;
+            if (runner->background) {
+                m_runningBackground++;
+            }
+            m_taskPool.start(runner);
+        }
+    }
+}
+
+bool TaskManager::isRunning(const ObjectId &owner, AbstractTask::JOBTYPE type) const
+{
+    return std::find(m_runningJobs.begin(), m_runningJobs.end(), std::make_pair(owner, type)) != m_runningJobs.end();
+}
+
+void TaskManager::runnerDone(const TaskRunner *runner)
+{
+    m_queueMutex.lock();
+    if (runner->transcode) {
+        m_runningTranscodes--;
+    } else {
+        m_runningTasks--;
+        if (runner->background) {
+            m_runningBackground--;
+        }
+    }
+    auto it = std::find(m_runningJobs.begin(), m_runningJobs.end(), std::make_pair(runner->owner, runner->type));
+    if (it != m_runningJobs.end()) {
+        m_runningJobs.erase(it);
+    }
+    m_queueMutex.unlock();
+    scheduleTasks();
+}
+
+void TaskManager::discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type, bool softDelete, const QVector<AbstractTask::JOBTYPE> exceptions,
+                              const std::function<void()> &whenDone)
+{
+    discardMatchingJobs(
+        owner, [type, exceptions](AbstractTask::JOBTYPE t) { return (type == AbstractTask::NOJOBTYPE || type == t) && !exceptions.contains(t); }, softDelete,
+        whenDone);
+}
+
+void TaskManager::discardJobs(const ObjectId &owner, const QVector<AbstractTask::JOBTYPE> &types, bool softDelete, const std::function<void()> &whenDone)
+{
+    discardMatchingJobs(
+        owner, [types](AbstractTask::JOBTYPE t) { return types.contains(t); }, softDelete, whenDone);
+}
+
+void TaskManager::discardMatchingJobs(const ObjectId &owner, const std::function<bool(AbstractTask::JOBTYPE)> &matches, bool softDelete,
+                                      const std::function<void()> &whenDone)
 {
     qDebug() << "========== READY FOR TASK DISCARD ON: " << owner.second;
     if (m_blockUpdates) {
@@ -55,23 +289,47 @@ void TaskManager::discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type,
     // See if there is already a task for this MLT service and resource.
     if (m_taskList.find(owner.second) == m_taskList.end()) {
         m_tasksListLock.unlock();
+        if (whenDone) {
+            whenDone();
+        }
         return;
     }
     std::vector<AbstractTask *> taskList = m_taskList.at(owner.second);
     m_tasksListLock.unlock();
+    std::vector<AbstractTask *> canceled;
     for (AbstractTask *t : taskList) {
-        if ((type == AbstractTask::NOJOBTYPE || type == t->m_type) && t->m_progress < 100) {
-            // If so, then just add ourselves to be notified upon completion.
-            if (exceptions.contains(t->m_type)) {
-                // Don't abort
-                continue;
-            }
+        if (matches(t->m_type) && t->m_progress < 100) {
+            // Don't wait for the task, it checks the cancel flag and removes itself from the list when it stops
+            t->cancelJob(softDelete);
+            canceled.push_back(t);
+        }
+    }
+    if (whenDone) {
+        notifyWhenDone(owner.second, canceled, whenDone);
+    }
+    // Canceled tasks that did not start yet are dropped
+    scheduleTasks();
+}
+
+void TaskManager::discardJobsAndWait(const ObjectId &owner, bool softDelete)
+{
+    if (m_blockUpdates) {
+        // We are already deleting all tasks
+        return;
+    }
+    std::vector<AbstractTask *> canceled;
+    m_tasksListLock.lockForRead();
+    auto it = m_taskList.find(owner.second);
+    if (it != m_taskList.end()) {
+        for (AbstractTask *t : it->second) {
             t->cancelJob(softDelete);
-            qDebug() << "========== DELETING JOB!!!!";
-            // Block until the task is finished
-            t->m_runMutex.lock();
+            canceled.push_back(t);
         }
     }
+    m_tasksListLock.unlock();
+    // Canceled tasks that did not start yet are dropped
+    scheduleTasks();
+    waitForTasks(canceled);
 }
 
 void TaskManager::discardJob(const ObjectId &owner, const QUuid &uuid)
@@ -91,10 +349,103 @@ void TaskManager::discardJob(const ObjectId &owner, const QUuid &uuid)
     for (AbstractTask *t : taskList) {
         if ((t->m_uuid == uuid) && t->m_progress < 100) {
             t->cancelJob();
-            // Block until the task is finished
-            t->m_runMutex.lock();
         }
     }
+    scheduleTasks();
+}
+
+void TaskManager::discardAllJobs(const QVector<AbstractTask::JOBTYPE> &exceptions)
+{
+    if (m_blockUpdates) {
+        return;
+    }
+    // Don't wait for the running tasks, they remove themselves from the list once they noticed the cancellation
+    m_tasksListLock.lockForRead();
+    for (const auto &task : m_taskList) {
+        for (AbstractTask *t : task.second) {
+            if (!exceptions.contains(t->m_type)) {
+                t->cancelJob();
+            }
+        }
+    }
+    m_tasksListLock.unlock();
+    // Drop the pending ones
+    scheduleTasks();
+}
+
+void TaskManager::discardAllJobsAndWait(const QVector<AbstractTask::JOBTYPE> &exceptions)
+{
+    if (m_blockUpdates) {
+        return;
+    }
+    std::vector<AbstractTask *> canceled;
+    m_tasksListLock.lockForRead();
+    for (const auto &task : m_taskList) {
+        for (AbstractTask *t : task.second) {
+            if (!exceptions.contains(t->m_type)) {
+                t->cancelJob();
+                canceled.push_back(t);
+            }
+        }
+    }
+    m_tasksListLock.unlock();
+    scheduleTasks();
+    waitForTasks(canceled);
+}
+
+void TaskManager::waitForTasks(const std::vector<AbstractTask *> &tasks)
+{
+    for (AbstractTask *t : tasks) {
+        m_tasksListLock.lockForRead();
+        bool listed = false;
+        for (const auto &task : m_taskList) {
+            if (std::find(task.second.begin(), task.second.end(), t) != task.second.end()) {
+                listed = true;
+                break;
+            }
+        }
+        m_tasksListLock.unlock();
+        if (!listed) {
+            // Already stopped
+            continue;
+        }
+        // The task holds its run mutex while running. It was canceled, so a task that did not start yet returns right away.
+        t->m_runMutex.lock();
+        t->m_runMutex.unlock();
+    }
+}
+
+void TaskManager::discardPendingJobs()
+{
+    m_queueMutex.lock();
+    for (const auto &task : m_pendingTasks) {
+        task.second->cancelJob();
+    }
+    m_queueMutex.unlock();
+    scheduleTasks();
+}
+
+void TaskManager::notifyWhenDone(int cid, const std::vector<AbstractTask *> &tasks, const std::function<void()> &callback)
+{
+    CancelWaiter waiter;
+    waiter.callback = callback;
+    m_tasksListLock.lockForWrite();
+    // Some tasks may already have stopped
+    auto it = m_taskList.find(cid);
+    if (it != m_taskList.end()) {
+        for (AbstractTask *t : tasks) {
+            if (std::find(it->second.begin(), it->second.end(), t) != it->second.end()) {
+                waiter.tasks.push_back(t);
+            }
+        }
+    }
+    if (waiter.tasks.empty()) {
+        m_tasksListLock.unlock();
+        callback();
+        return;
+    }
+    m_cancelWaiters.push_back(waiter);
+    m_tasksListLock.unlock();
 }
 
 bool TaskManager::hasPendingJob(const ObjectId &owner, AbstractTask::JOBTYPE type) const
@@ -150,6 +501,7 @@ void TaskManager::taskDone(int cid, AbstractTask *task)
         // We are closing, tasks will be handled on close
         return;
     }
+    recordStatistics(task);
     m_tasksListLock.lockForWrite();
     Q_ASSERT(m_taskList.find(cid) != m_taskList.end());
     m_taskList[cid].erase(std::remove(m_taskList[cid].begin(), m_taskList[cid].end(), task), m_taskList[cid].end());
@@ -157,6 +509,16 @@ void TaskManager::taskDone(int cid, AbstractTask *task)
         m_taskList.erase(cid);
     }
     task->deleteLater();
+    for (auto it = m_cancelWaiters.begin(); it != m_cancelWaiters.end();) {
+        it->tasks.erase(std::remove(it->tasks.begin(), it->tasks.end(), task), it->tasks.end());
+        if (it->tasks.empty()) {
+            // Run the callback in the GUI thread
+            QMetaObject::invokeMethod(this, it->callback, Qt::QueuedConnection);
+            it = m_cancelWaiters.erase(it);
+        } else {
+            ++it;
+        }
+    }
     m_tasksListLock.unlock();
     QMetaObject::invokeMethod(this, "updateJobCount");
 }
@@ -167,28 +529,29 @@ void TaskManager::slotCancelJobs(const QVector<AbstractTask::JOBTYPE> exceptions
         // Already canceling
         return;
     }
+    if (!exceptions.isEmpty()) {
+        // The producers are reloaded after the profile switch, so the canceled tasks must be stopped
+        discardAllJobsAndWait(exceptions);
+        return;
+    }
+    // We are closing, all tasks must be stopped before the project is released
     m_blockUpdates = true;
+    m_queueMutex.lock();
+    m_pendingTasks.clear();
+    m_queueMutex.unlock();
     m_tasksListLock.lockForWrite();
     for (const auto &task : m_taskList) {
         for (AbstractTask *t : task.second) {
-            if (m_taskList.find(task.first) != m_taskList.end()) {
-                if (!exceptions.contains(t->m_type)) {
-                    // If so, then just add ourselves to be notified upon completion.
-                    t->cancelJob();
-                    t->m_runMutex.lock();
-                    t->m_runMutex.unlock();
-                    t->deleteLater();
-                }
-            }
+            t->cancelJob();
+            t->deleteLater();
         }
     }
     m_tasksListLock.unlock();
-    if (exceptions.isEmpty()) {
-        m_taskPool.waitForDone();
-        m_transcodePool.waitForDone();
-        m_taskList.clear();
-        m_taskPool.clear();
-    }
+    m_taskPool.waitForDone();
+    m_transcodePool.waitForDone();
+    m_taskList.clear();
+    m_cancelWaiters.clear();
+    m_taskPool.clear();
     m_blockUpdates = false;
     updateJobCount();
 }
@@ -207,16 +570,138 @@ void TaskManager::startTask(int ownerId, AbstractTask *task)
     } else {
         m_taskList[ownerId].emplace_back(task);
     }
-    if (task->m_type == AbstractTask::TRANSCODEJOB || task->m_type == AbstractTask::PROXYJOB) {
-        // We only want a limited concurrent jobs for those as for example GPU usually only accept 2 concurrent encoding jobs
-        m_transcodePool.start(task, task->m_priority);
-    } else {
-        m_taskPool.start(task, task->m_priority);
-    }
     m_tasksListLock.unlock();
+    m_queueMutex.lock();
+    task->m_queuedTime = m_clock.elapsed();
+    m_pendingTasks.emplace_back(ownerId, task);
+    m_queueMutex.unlock();
+    scheduleTasks();
     updateJobCount();
 }
 
+void TaskManager::recordStatistics(const AbstractTask *task)
+{
+    const qint64 now = m_clock.elapsed();
+    const qint64 started = task->m_startTime.loadRelaxed();
+    QMutexLocker lk(&m_statisticsMutex);
+    if (task->m_queuedTime < m_statisticsStart) {
+        // Queued before the last reset
+        return;
+    }
+    JobStatistics &stats = m_statistics[task->m_type];
+    if (task->m_isCanceled) {
+        stats.canceled++;
+    } else {
+        stats.finished++;
+    }
+    if (started < 0) {
+        // Dropped before it started
+        stats.waitTime += now - task->m_queuedTime;
+        return;
+    }
+    stats.waitTime += started - task->m_queuedTime;
+    stats.runTime += now - started;
+    stats.frames += task->m_processedFrames.loadRelaxed();
+    stats.bytesRead += task->m_bytesRead.loadRelaxed();
+    stats.bytesWritten += task->m_bytesWritten.loadRelaxed();
+}
+
+void TaskManager::resetStatistics()
+{
+    QMutexLocker lk(&m_statisticsMutex);
+    m_statistics.clear();
+    m_statisticsStart = m_clock.elapsed();
+}
+
+QJsonObject TaskManager::statistics() const
+{
+    const qint64 now = m_clock.elapsed();
+    // Add the running and pending tasks to the finished ones
+    std::map<AbstractTask::JOBTYPE, JobStatistics> stats;
+    std::map<AbstractTask::JOBTYPE, std::pair<int, int>> active;
+    qint64 start = 0;
+    {
+        QMutexLocker lk(&m_statisticsMutex);
+        stats = m_statistics;
+        start = m_statisticsStart;
+    }
+    const qint64 period = qMax(qint64(1), now - start);
+    QReadLocker lk(&m_tasksListLock);
+    for (const auto &task : m_taskList) {
+        for (AbstractTask *t : task.second) {
+            const qint64 started = t->m_startTime.loadRelaxed();
+            if (started < 0) {
+                active[t->m_type].second++;
+                continue;
+            }
+            active[t->m_type].first++;
+            JobStatistics &current = stats[t->m_type];
+            current.waitTime += qMax(qint64(0), started - qMax(start, t->m_queuedTime));
+            current.runTime += now - qMax(start, started);
+            current.frames += t->m_processedFrames.loadRelaxed();
+            current.bytesRead += t->m_bytesRead.loadRelaxed();
+            current.bytesWritten += t->m_bytesWritten.loadRelaxed();
+        }
+    }
+    lk.unlock();
+    const int taskThreads = m_taskPool.maxThreadCount();
+    const int transcodeThreads = m_transcodePool.maxThreadCount();
+    QJsonObject jobs;
+    qint64 taskPoolTime = 0;
+    qint64 transcodePoolTime = 0;
+    int runningTasks = 0;
+    int pendingTasks = 0;
+    int runningTranscodes = 0;
+    int pendingTranscodes = 0;
+    for (const auto &type : stats) {
+        const JobStatistics &s = type.second;
+        const bool transcode = isTranscodeJob(type.first);
+        const std::pair<int, int> counts = active.count(type.first) ? active.at(type.first) : std::make_pair(0, 0);
+        const int done = s.finished + s.canceled;
+        QJsonObject job;
+        job.insert(QStringLiteral("finished"), s.finished);
+        job.insert(QStringLiteral("canceled"), s.canceled);
+        job.insert(QStringLiteral("running"), counts.first);
+        job.insert(QStringLiteral("pending"), counts.second);
+        job.insert(QStringLiteral("queueWaitMs"), s.waitTime);
+        job.insert(QStringLiteral("averageQueueWaitMs"), s.waitTime / qMax(1, done + counts.first));
+        job.insert(QStringLiteral("runTimeMs"), s.runTime);
+        job.insert(QStringLiteral("averageRunTimeMs"), s.runTime / qMax(1, done + counts.first));
+        job.insert(QStringLiteral("frames"), s.frames);
+        job.insert(QStringLiteral("framesPerSecond"), s.runTime > 0 ? 1000. * s.frames / s.runTime : 0.);
+        job.insert(QStringLiteral("bytesRead"), s.bytesRead);
+        job.insert(QStringLiteral("bytesWritten"), s.bytesWritten);
+        // Share of the pool threads used by this job type over the period
+        job.insert(QStringLiteral("poolUtilization"), double(s.runTime) / period / qMax(1, transcode ? transcodeThreads : taskThreads));
+        jobs.insert(jobTypeName(type.first), job);
+        if (transcode) {
+            transcodePoolTime += s.runTime;
+            runningTranscodes += counts.first;
+            pendingTranscodes += counts.second;
+        } else {
+            taskPoolTime += s.runTime;
+            runningTasks += counts.first;
+            pendingTasks += counts.second;
+        }
+    }
+    auto poolObject = [period](int threads, int running, int pending, qint64 busyTime) {
+        QJsonObject pool;
+        pool.insert(QStringLiteral("threads"), threads);
+        pool.insert(QStringLiteral("running"), running);
+        pool.insert(QStringLiteral("pending"), pending);
+        pool.insert(QStringLiteral("utilization"), double(busyTime) / period / qMax(1, threads));
+        return pool;
+    };
+    QJsonObject pools;
+    pools.insert(QStringLiteral("tasks"), poolObject(taskThreads, runningTasks, pendingTasks, taskPoolTime));
+    pools.insert(QStringLiteral("transcode"), poolObject(transcodeThreads, runningTranscodes, pendingTranscodes, transcodePoolTime));
+    QJsonObject result;
+    result.insert(QStringLiteral("periodMs"), period);
+    result.insert(QStringLiteral("pools"), pools);
+    result.insert(QStringLiteral("jobs"), jobs);
+    return result;
+}
+
 int TaskManager::getJobProgressForClip(const ObjectId &owner)
 {
     QReadLocker lk(&m_tasksListLock);
@@ -240,7 +725,7 @@ int TaskManager::getJobProgressForClip(const ObjectId &owner)
             // Don't show progress for load task
             cnt--;
         } else if (owner.second == displayedClip) {
-            jobNames << t->m_description;
+            jobNames << t->description();
             jobsProgress << t->m_progress;
             jobsUuids << t->m_uuid.toString();
         }
@@ -12,38 +12,64 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "definitions.h"
 
 #include <QAbstractListModel>
+#include <QElapsedTimer>
 #include <QFutureWatcher>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
 #include <QObject>
 #include <QReadWriteLock>
 #include <QThreadPool>
 #include <QUuid>
+#include <functional>
 #include <map>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
 class AbstractTask;
+class TaskRunner;
 
 enum class TaskManagerStatus { NoJob, Pending, Running, Finished, Canceled };
 Q_DECLARE_METATYPE(TaskManagerStatus)
 
 /** @class TaskManager
     @brief This class is responsible for clip jobs management.
+
+    Tasks are not pushed directly on the thread pools, they wait in a pending list
+    and a task is only picked when a thread becomes available. The choice is then made on
+    the task priority class, boosted for the clip displayed in the Clip Monitor and
+    the clips visible in the timeline, so that a new interactive job never waits behind
+    a long queue of background jobs. Tasks canceled while pending don't take a thread, they only run their cancel branch.
  */
 class TaskManager : public QObject
 {
     Q_OBJECT
+    friend class TaskRunner;
 
 public:
     explicit TaskManager(QObject *parent);
     ~TaskManager() override;
 
-    /** @brief Discard specific job type for a clip.
+    /** @brief Discard specific job type for a clip. This does not wait for the running tasks to stop.
      *  @param owner the owner item for this task
      *  @param type The type of job that you want to abort, leave to NOJOBTYPE to abort all jobs
+     *  @param whenDone if set, called in the GUI thread once all the discarded tasks stopped
      */
-    void discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type = AbstractTask::NOJOBTYPE, bool softDelete = false, const QVector<AbstractTask::JOBTYPE> exceptions = {});
+    void discardJobs(const ObjectId &owner, AbstractTask::JOBTYPE type = AbstractTask::NOJOBTYPE, bool softDelete = false,
+                     const QVector<AbstractTask::JOBTYPE> exceptions = {}, const std::function<void()> &whenDone = nullptr);
+    /** @brief Discard several job types for a clip at once, @p whenDone is called in the GUI thread once all of them stopped */
+    void discardJobs(const ObjectId &owner, const QVector<AbstractTask::JOBTYPE> &types, bool softDelete, const std::function<void()> &whenDone);
+    /** @brief Discard the jobs of a clip and block until the running ones stopped.
+     *  Only use it when the data used by the tasks is released right away, for example when the owner is deleted */
+    void discardJobsAndWait(const ObjectId &owner, bool softDelete = false);
     void discardJob(const ObjectId &owner, const QUuid &uuid);
+    /** @brief Discard all jobs except the @p exceptions types, without waiting for the running tasks to stop */
+    void discardAllJobs(const QVector<AbstractTask::JOBTYPE> &exceptions = {});
+    /** @brief Discard all jobs except the @p exceptions types and block until the running ones stopped, for example before switching the project profile */
+    void discardAllJobsAndWait(const QVector<AbstractTask::JOBTYPE> &exceptions);
+    /** @brief Discard the tasks that did not start yet */
+    void discardPendingJobs();
 
     /** @brief Check if there is a pending / running job a clip.
      *  @param owner the owner item for this task
@@ -68,11 +94,22 @@ public:
     /** @brief We are aborting all tasks and don't want them to send any updates */
     bool isBlocked() const;
 
+    /** @brief Statistics of the jobs since the last reset, per job type, as JSON.
+     *  It includes the queue wait and run times, processed frames, bytes read and written and the pool utilization */
+    QJsonObject statistics() const;
+    /** @brief Restart the statistics collection */
+    void resetStatistics();
+
+    /** @brief Mark a bin clip as visible in the timeline, its background tasks are started before the others for a few seconds.
+     *  Can be called from any thread */
+    void markVisible(int binId);
+
     /** @brief The clip currently opened in Clip Monitor (to display clip jobs) */
     int displayedClip;
 
 public Q_SLOTS:
-    /** @brief Discard all running jobs. */
+    /** @brief Discard all running jobs and wait until they stopped. Without exceptions, all pending tasks are dropped and this should only be used when
+     * closing a project, with exceptions it is used before switching the project profile. */
     void slotCancelJobs(const QVector<AbstractTask::JOBTYPE> exceptions = {});
 
 private Q_SLOTS:
@@ -85,6 +122,56 @@ private:
     std::unordered_map<int, std::vector<AbstractTask*> > m_taskList;
     mutable QReadWriteLock m_tasksListLock;
     bool m_blockUpdates;
+    /** @brief Tasks waiting for a thread, in submission order */
+    std::vector<std::pair<int, AbstractTask *>> m_pendingTasks;
+    /** @brief Number of tasks running on the task pool, on the transcode pool, and background tasks on the task pool */
+    int m_runningTasks;
+    int m_runningTranscodes;
+    int m_runningBackground;
+    /** @brief Owner and type of the running tasks */
+    std::vector<std::pair<ObjectId, AbstractTask::JOBTYPE>> m_runningJobs;
+    /** @brief Bin clips visible in the timeline, with the time they were last marked */
+    QHash<int, qint64> m_visibleClips;
+    /** @brief Time reference for the visible clips and the job statistics */
+    QElapsedTimer m_clock;
+    /** @brief Protects the pending list, the running counters and the visible clips */
+    QMutex m_queueMutex;
+    /** @brief The priority class of a task, taking into account the displayed and visible clips */
+    AbstractTask::PRIORITYCLASS effectiveClass(const AbstractTask *task) const;
+    /** @brief Start pending tasks, best class first, as long as threads are available */
+    void scheduleTasks();
+    /** @brief Returns true if a task of this type is running for the owner */
+    bool isRunning(const ObjectId &owner, AbstractTask::JOBTYPE type) const;
+    /** @brief Called by a runner when its task returned */
+    void runnerDone(const TaskRunner *runner);
+    /** @brief Discarded tasks, the callback is invoked when the last one stopped. Protected by m_tasksListLock */
+    struct CancelWaiter
+    {
+        std::vector<AbstractTask *> tasks;
+        std::function<void()> callback;
+    };
+    std::vector<CancelWaiter> m_cancelWaiters;
+    void notifyWhenDone(int cid, const std::vector<AbstractTask *> &tasks, const std::function<void()> &callback);
+    /** @brief Block until the canceled @p tasks returned. Must be called from the GUI thread, so that the stopped tasks are not deleted meanwhile */
+    void waitForTasks(const std::vector<AbstractTask *> &tasks);
+    void discardMatchingJobs(const ObjectId &owner, const std::function<bool(AbstractTask::JOBTYPE)> &matches, bool softDelete,
+                             const std::function<void()> &whenDone);
+    /** @brief Accumulated statistics of the finished tasks of a job type */
+    struct JobStatistics
+    {
+        int finished{0};
+        int canceled{0};
+        qint64 waitTime{0};
+        qint64 runTime{0};
+        qint64 frames{0};
+        qint64 bytesRead{0};
+        qint64 bytesWritten{0};
+    };
+    std::map<AbstractTask::JOBTYPE, JobStatistics> m_statistics;
+    qint64 m_statisticsStart;
+    mutable QMutex m_statisticsMutex;
+    /** @brief Add a finished task to the statistics */
+    void recordStatistics(const AbstractTask *task);
 
 Q_SIGNALS:
     void jobCount(int);
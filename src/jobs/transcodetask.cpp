@@ -224,6 +224,8 @@ void TranscodeTask::run()
     // remove temporary playlist if it exists
     m_progress = 100;
     QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    addBytesRead(QFileInfo(source).size());
+    addBytesWritten(QFileInfo(destUrl).size());
     if (result) {
         if (QFileInfo(destUrl).size() == 0) {
             QFile::remove(destUrl);
@@ -9,9 +9,14 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlive_debug.h"
 #include "klocalizedstring.h"
 #include <QElapsedTimer>
+#include <QtConcurrent>
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
+const size_t AudioCorrelation::CoarseFactor;
+const size_t AudioCorrelation::CoarseSearchThreshold;
+
 AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvelope)
     : m_mainTrackEnvelope(std::move(mainTrackEnvelope))
 {
@@ -22,6 +27,13 @@ AudioCorrelation::AudioCorrelation(std::unique_ptr<AudioEnvelope> mainTrackEnvel
 
 AudioCorrelation::~AudioCorrelation()
 {
+    for (QFuture<void> &future : m_running) {
+        future.waitForFinished();
+    }
+    for (const auto &finished : qAsConst(m_finished)) {
+        delete finished.first;
+        delete finished.second;
+    }
     for (AudioEnvelope *envelope : qAsConst(m_children)) {
         delete envelope;
     }
@@ -47,35 +59,154 @@ void AudioCorrelation::addChild(AudioEnvelope *envelope)
     envelope->startComputeEnvelope();
 }
 
+void AudioCorrelation::addChildren(const QList<AudioEnvelope *> &envelopes)
+{
+    size_t maxSize = 0;
+    for (AudioEnvelope *envelope : envelopes) {
+        maxSize = std::max(maxSize, envelope->envelopeSize());
+    }
+    m_mutex.lock();
+    m_expectedChildSize = std::max(m_expectedChildSize, maxSize);
+    m_mutex.unlock();
+    for (AudioEnvelope *envelope : envelopes) {
+        addChild(envelope);
+    }
+}
+
 void AudioCorrelation::slotProcessChild(AudioEnvelope *envelope)
 {
-    // Note that at this point the computation of the envelope of the
-    // main track might not be finished. envelope() will block until
-    // the computation is done.
-    const size_t sizeMain = m_mainTrackEnvelope->envelope().size();
-    const size_t sizeSub = envelope->envelope().size();
+    // The main envelope might not be ready yet and the correlation can take
+    // a while on long clips, so this is done on the thread pool
+    m_running.erase(std::remove_if(m_running.begin(), m_running.end(), [](const QFuture<void> &future) { return future.isFinished(); }), m_running.end());
+    m_running << QtConcurrent::run([this, envelope]() { correlateChild(envelope); });
+}
 
-    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
-    qint64 *correlation = info->correlationVector();
+std::shared_ptr<const FFTCorrelation::Reference> AudioCorrelation::reference(size_t childSize, bool coarse)
+{
+    QMutexLocker lock(&m_mutex);
+    std::shared_ptr<const FFTCorrelation::Reference> &reference = coarse ? m_coarseReference : m_reference;
+    if (!reference || reference->maxRightSize() < childSize) {
+        // Note that at this point the computation of the envelope of the
+        // main track might not be finished. envelope() will block until
+        // the computation is done.
+        const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
+        if (coarse) {
+            const size_t maxSize = std::max(childSize, (m_expectedChildSize + CoarseFactor - 1) / CoarseFactor);
+            const std::vector<qint64> coarseMain = decimate(envMain);
+            reference = std::make_shared<const FFTCorrelation::Reference>(coarseMain.data(), coarseMain.size(), maxSize);
+        } else {
+            const size_t maxSize = std::max(childSize, m_expectedChildSize);
+            reference = std::make_shared<const FFTCorrelation::Reference>(envMain.data(), envMain.size(), maxSize);
+        }
+    }
+    return reference;
+}
 
+void AudioCorrelation::correlateChild(AudioEnvelope *envelope)
+{
     const std::vector<qint64> &envMain = m_mainTrackEnvelope->envelope();
     const std::vector<qint64> &envSub = envelope->envelope();
-    qint64 max = 0;
+    const size_t sizeMain = envMain.size();
+    const size_t sizeSub = envSub.size();
 
-    if (sizeSub > 200) {
-        FFTCorrelation::correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation);
-    } else {
+    auto *info = new AudioCorrelationInfo(sizeMain, sizeSub);
+    qint64 *correlation = info->correlationVector();
+
+    if (sizeMain == 0 || sizeSub == 0) {
+        std::fill(correlation, correlation + info->size(), 0);
+    } else if (sizeSub <= 200) {
+        qint64 max = 0;
         correlate(&envMain[0], sizeMain, &envSub[0], sizeSub, correlation, &max);
         info->setMax(max);
+    } else if (std::min(sizeMain, sizeSub) > CoarseSearchThreshold) {
+        const size_t coarseSize = (sizeSub + CoarseFactor - 1) / CoarseFactor;
+        correlateCoarseToFine(envMain, envSub, correlation, reference(coarseSize, true).get());
+    } else {
+        reference(sizeSub, false)->correlate(&envSub[0], sizeSub, correlation);
     }
 
-    m_children.append(envelope);
-    m_correlations.append(info);
+    QMutexLocker lock(&m_mutex);
+    m_finished.append({envelope, info});
+    QMetaObject::invokeMethod(this, [this]() { announceFinished(); }, Qt::QueuedConnection);
+}
+
+void AudioCorrelation::announceFinished()
+{
+    m_mutex.lock();
+    const QList<QPair<AudioEnvelope *, AudioCorrelationInfo *>> finished = m_finished;
+    m_finished.clear();
+    m_mutex.unlock();
+    for (const auto &child : finished) {
+        m_children.append(child.first);
+        m_correlations.append(child.second);
+        Q_ASSERT(m_correlations.size() == m_children.size());
+        int shift = getShift(m_children.size() - 1);
+        Q_EMIT gotAudioAlignData(child.first->clipId(), shift);
+    }
+}
 
-    Q_ASSERT(m_correlations.size() == m_children.size());
-    int index = m_children.indexOf(envelope);
-    int shift = getShift(index);
-    Q_EMIT gotAudioAlignData(envelope->clipId(), shift);
+std::vector<qint64> AudioCorrelation::decimate(const std::vector<qint64> &envelope)
+{
+    std::vector<qint64> result((envelope.size() + CoarseFactor - 1) / CoarseFactor, 0);
+    for (size_t i = 0; i < envelope.size(); ++i) {
+        result[i / CoarseFactor] += envelope[i];
+    }
+    return result;
+}
+
+void AudioCorrelation::correlateCoarseToFine(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub, qint64 *correlation,
+                                             const FFTCorrelation::Reference *coarseMain)
+{
+    QElapsedTimer t;
+    t.start();
+    const auto sizeMain = qint64(envMain.size());
+    const auto sizeSub = qint64(envSub.size());
+    std::fill(correlation, correlation + sizeMain + sizeSub + 1, 0);
+    if (sizeMain == 0 || sizeSub == 0) {
+        return;
+    }
+
+    // Find the best shift on the decimated envelopes
+    const std::vector<qint64> coarseSub = decimate(envSub);
+    std::unique_ptr<FFTCorrelation::Reference> localReference;
+    if (coarseMain == nullptr || coarseMain->maxRightSize() < coarseSub.size()) {
+        const std::vector<qint64> decimatedMain = decimate(envMain);
+        localReference.reset(new FFTCorrelation::Reference(decimatedMain.data(), decimatedMain.size(), coarseSub.size()));
+        coarseMain = localReference.get();
+    }
+    std::vector<qint64> coarseCorrelation(coarseMain->size() + coarseSub.size() + 1);
+    coarseMain->correlate(coarseSub.data(), coarseSub.size(), coarseCorrelation.data());
+    const auto coarseIndex = qint64(std::max_element(coarseCorrelation.begin(), coarseCorrelation.end()) - coarseCorrelation.begin());
+    const qint64 coarseShift = (coarseIndex - qint64(coarseSub.size())) * qint64(CoarseFactor);
+
+    // Refine at full resolution around it, shift being the position of the child start in the main envelope
+    const qint64 margin = 2 * qint64(CoarseFactor);
+    const qint64 firstShift = std::max(-sizeSub, coarseShift - margin);
+    const qint64 lastShift = std::min(sizeMain, coarseShift + margin);
+    // Products of long envelopes do not fit in integers, sum them as doubles and scale the results
+    std::vector<double> sums(size_t(lastShift - firstShift + 1), 0.);
+    for (qint64 shift = firstShift; shift <= lastShift; ++shift) {
+        const qint64 first = std::max(qint64(0), -shift);
+        const qint64 last = std::min(sizeSub, sizeMain - shift);
+        double sum = 0.;
+        for (qint64 i = first; i < last; ++i) {
+            sum += double(envSub[size_t(i)]) * double(envMain[size_t(shift + i)]);
+        }
+        sums[size_t(shift - firstShift)] = sum;
+    }
+    const double maxSum = *std::max_element(sums.begin(), sums.end());
+    if (maxSum <= 0.) {
+        // The coarse peak missed the match, for example with very short sounds that vanish in the decimation.
+        // Fall back to the full resolution correlation
+        FFTCorrelation::Reference fullMain(envMain.data(), envMain.size(), envSub.size());
+        fullMain.correlate(envSub.data(), envSub.size(), correlation);
+        qCDebug(KDENLIVE_LOG) << "Coarse correlation found no match, full correlation calculated. Time taken: " << t.elapsed() << " ms.";
+        return;
+    }
+    for (qint64 shift = firstShift; shift <= lastShift; ++shift) {
+        correlation[sizeSub + shift] = qint64(sums[size_t(shift - firstShift)] / maxSum * double(1LL << 40));
+    }
+    qCDebug(KDENLIVE_LOG) << "Coarse to fine correlation calculated. Time taken: " << t.elapsed() << " ms.";
 }
 
 int AudioCorrelation::getShift(int childIndex) const
@@ -10,7 +10,11 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "audioCorrelationInfo.h"
 #include "audioEnvelope.h"
 #include "definitions.h"
+#include "fftCorrelation.h"
+#include <QFuture>
 #include <QList>
+#include <QMutex>
+#include <memory>
 
 /**
   This class does the correlation between two tracks
@@ -18,6 +22,11 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
   It uses one main track (used in the initializer); further tracks will be
   aligned relative to this main track.
+
+  The spectrum of the main track is computed once and shared by all the
+  children, which are correlated in parallel on the global thread pool.
+  Long envelopes are first aligned on a decimated version, the full
+  resolution correlation being only computed around the coarse result.
   */
 class AudioCorrelation : public QObject
 {
@@ -48,6 +57,12 @@ public:
       This object will take ownership of the passed envelope.
       */
     void addChild(AudioEnvelope *envelope);
+    /**
+      Adds several children at once, for example all the angles of a
+      multicam shoot. The spectrum of the main envelope is then computed
+      only once, at the size required by the longest child.
+      */
+    void addChildren(const QList<AudioEnvelope *> &envelopes);
 
     const AudioCorrelationInfo *info(int childIndex) const;
     int getShift(int childIndex) const;
@@ -58,12 +73,43 @@ public:
       */
     static void correlate(const qint64 *envMain, size_t sizeMain, const qint64 *envSub, size_t sizeSub, qint64 *correlation, qint64 *out_max = nullptr);
 
+    /** Number of envelope frames summed in one frame of the coarse search */
+    static const size_t CoarseFactor = 16;
+    /** Correlations between envelopes both longer than this start with a coarse search */
+    static const size_t CoarseSearchThreshold = 1 << 15;
+
+    /** Returns the envelope with each CoarseFactor frames summed in one */
+    static std::vector<qint64> decimate(const std::vector<qint64> &envelope);
+    /**
+      Correlates the two envelopes on their decimated versions first, then at full resolution
+      around the best coarse shift only. Other entries of \c correlation are set to 0.
+      \c correlation must be a pre-allocated vector of size sizeMain+sizeSub+1.
+      @param coarseMain the reference spectrum of the decimated main envelope if already computed
+      */
+    static void correlateCoarseToFine(const std::vector<qint64> &envMain, const std::vector<qint64> &envSub, qint64 *correlation,
+                                      const FFTCorrelation::Reference *coarseMain = nullptr);
+
 private:
     std::unique_ptr<AudioEnvelope> m_mainTrackEnvelope;
 
     QList<AudioEnvelope *> m_children;
     QList<AudioCorrelationInfo *> m_correlations;
 
+    /** Protects the reference spectra and the correlations computed but not yet announced */
+    QMutex m_mutex;
+    std::shared_ptr<const FFTCorrelation::Reference> m_reference;
+    std::shared_ptr<const FFTCorrelation::Reference> m_coarseReference;
+    size_t m_expectedChildSize{0};
+    QList<QPair<AudioEnvelope *, AudioCorrelationInfo *>> m_finished;
+    QList<QFuture<void>> m_running;
+
+    /** Returns the spectrum of the (decimated if @p coarse) main envelope, able to correlate a child of @p childSize */
+    std::shared_ptr<const FFTCorrelation::Reference> reference(size_t childSize, bool coarse);
+    /** Computes the correlation of a child with the main envelope, run in a worker thread */
+    void correlateChild(AudioEnvelope *envelope);
+    /** Announces the correlations computed by the worker threads */
+    void announceFinished();
+
 private Q_SLOTS:
     /**
      This is invoked when the child envelope is computed. This
@@ -13,10 +13,50 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kdenlive_debug.h"
 #include <KLocalizedString>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QImage>
+#include <QSaveFile>
 #include <QtConcurrent>
+#include <QtEndian>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+
+namespace {
+const char envelopeMagic[4] = {'K', 'D', 'A', 'E'};
+const quint32 envelopeVersion = 1;
+// magic, version, count
+const qint64 envelopeHeaderSize = 4 + 4 + 4;
+
+/** @brief Linear amplitudes (relative to full scale) of the 256 audio thumbnail levels.
+    The levels are 256 * 0.9 * the IEC 268-18 scaled dB value computed by MLT's audiolevel filter, this inverts the scale. */
+const std::vector<double> &levelAmplitudes()
+{
+    static const std::vector<double> amplitudes = [] {
+        std::vector<double> result(256, 0.);
+        for (int level = 1; level < 256; ++level) {
+            const double scale = level / 256. / 0.9;
+            double dB;
+            if (scale < 0.025) {
+                dB = scale / 0.0025 - 70.;
+            } else if (scale < 0.075) {
+                dB = (scale - 0.025) / 0.005 - 60.;
+            } else if (scale < 0.15) {
+                dB = (scale - 0.075) / 0.0075 - 50.;
+            } else if (scale < 0.3) {
+                dB = (scale - 0.15) / 0.015 - 40.;
+            } else if (scale < 0.5) {
+                dB = (scale - 0.3) / 0.02 - 30.;
+            } else {
+                dB = (scale - 0.5) / 0.025 - 20.;
+            }
+            result[size_t(level)] = pow(10., qMin(0., dB) / 20.);
+        }
+        return result;
+    }();
+    return amplitudes;
+}
+} // namespace
 
 AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, size_t length, size_t startPos)
     : m_offset(offset)
@@ -28,9 +68,22 @@ AudioEnvelope::AudioEnvelope(const QString &binId, int clipId, size_t offset, si
     if (length > 2000) {
         // Analyse on timeline clip zone only
         m_offset = 0;
+        m_envelopeStart = int(offset);
         m_producer->set_in_and_out(int(offset), int(offset + length));
     }
     m_envelopeSize = size_t(m_producer->get_playtime());
+    if (clip->audioInfo()) {
+        const int stream = clip->audioInfo()->ffmpeg_audio_index();
+        if (clip->audioLevelsComplete(stream)) {
+            // Levels are published progressively while they are generated, only use complete ones
+            m_levels = clip->audioFrameCache(stream);
+        }
+        const QString thumbPath = clip->getAudioThumbPath(stream);
+        if (!thumbPath.isEmpty()) {
+            m_cachePath = thumbPath.left(thumbPath.length() - AudioLevels::extension.length()) +
+                          QStringLiteral("_envelope_%1_%2.envelope").arg(m_envelopeStart).arg(m_envelopeSize);
+        }
+    }
 
     m_producer->set("set.test_image", 1);
     connect(&m_watcher, &QFutureWatcherBase::finished, this, [this] { Q_EMIT envelopeReady(this); });
@@ -89,47 +142,155 @@ size_t AudioEnvelope::offset()
     return m_offset;
 }
 
+size_t AudioEnvelope::envelopeSize() const
+{
+    return m_envelopeSize;
+}
+
 const std::vector<qint64> &AudioEnvelope::envelope()
 {
     // Blocks until the summary is available.
     return audioSummary().audioAmplitudes;
 }
 
-AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+bool AudioEnvelope::envelopeFromLevels(std::vector<qint64> &amplitudes) const
+{
+    const int channels = m_levels.channels();
+    if (m_levels.isEmpty() || channels <= 0 || !m_info || m_info->size() < 1 || !qFuzzyCompare(m_levels.fps(), m_producer->get_fps())) {
+        return false;
+    }
+    const int frames = m_levels.length() / channels;
+    // The playtime includes the out point, which may be one frame past the last level
+    if (m_envelopeStart + int(amplitudes.size()) > frames + 1) {
+        return false;
+    }
+    // The levels are per channel loudness, approximate the sum of the absolute samples of the frame from them
+    const std::vector<double> &linear = levelAmplitudes();
+    const double frameSamples = m_info->info(0)->samplingRate() / m_producer->get_fps();
+    const uint8_t *levels = m_levels.constData();
+    for (size_t i = 0; i < amplitudes.size(); ++i) {
+        const int frame = qMin(m_envelopeStart + int(i), frames - 1);
+        double amplitude = 0.;
+        for (int c = 0; c < channels; ++c) {
+            amplitude += linear[levels[frame * channels + c]];
+        }
+        amplitudes[i] = qint64(amplitude / channels * 32767. * frameSamples);
+    }
+    return true;
+}
+
+bool AudioEnvelope::loadCachedEnvelope(std::vector<qint64> &amplitudes) const
+{
+    if (m_cachePath.isEmpty()) {
+        return false;
+    }
+    QFile file(m_cachePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    const qint64 count = qint64(amplitudes.size());
+    if (data.size() != envelopeHeaderSize + count * qint64(sizeof(qint64))) {
+        return false;
+    }
+    const auto *header = reinterpret_cast<const uchar *>(data.constData());
+    if (memcmp(header, envelopeMagic, 4) != 0 || qFromLittleEndian<quint32>(header + 4) != envelopeVersion ||
+        qFromLittleEndian<quint32>(header + 8) != quint32(count)) {
+        return false;
+    }
+    const uchar *values = header + envelopeHeaderSize;
+    for (size_t i = 0; i < amplitudes.size(); ++i) {
+        amplitudes[i] = qFromLittleEndian<qint64>(values + i * sizeof(qint64));
+    }
+    return true;
+}
+
+void AudioEnvelope::saveCachedEnvelope(const std::vector<qint64> &amplitudes) const
+{
+    if (m_cachePath.isEmpty()) {
+        return;
+    }
+    QByteArray data(int(envelopeHeaderSize + qint64(amplitudes.size()) * qint64(sizeof(qint64))), Qt::Uninitialized);
+    auto *header = reinterpret_cast<uchar *>(data.data());
+    memcpy(header, envelopeMagic, 4);
+    qToLittleEndian<quint32>(envelopeVersion, header + 4);
+    qToLittleEndian<quint32>(quint32(amplitudes.size()), header + 8);
+    uchar *values = header + envelopeHeaderSize;
+    for (size_t i = 0; i < amplitudes.size(); ++i) {
+        qToLittleEndian<qint64>(amplitudes[i], values + i * sizeof(qint64));
+    }
+    QSaveFile file(m_cachePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KDENLIVE_LOG) << "// Cannot write audio envelope" << m_cachePath << file.errorString();
+        return;
+    }
+    file.write(data);
+    file.commit();
+}
+
+bool AudioEnvelope::decodeEnvelope(std::vector<qint64> &amplitudes) const
 {
-    qCDebug(KDENLIVE_LOG) << "Loading envelope …";
-    AudioSummary summary(m_envelopeSize);
     if (!m_info || m_info->size() < 1) {
-        return summary;
+        return false;
     }
     int samplingRate = m_info->info(0)->samplingRate();
     mlt_audio_format format_s16 = mlt_audio_s16;
     int channels = 1;
 
-    QElapsedTimer t;
-    t.start();
     m_producer->seek(0);
-    size_t max = summary.audioAmplitudes.size();
+    size_t max = amplitudes.size();
+    // Progress is reported at most a few times per second, each message crosses threads
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+    int reportedProgress = -1;
     for (size_t i = 0; i < max; ++i) {
         std::unique_ptr<Mlt::Frame> frame(m_producer->get_frame(int(i)));
         qint64 position = mlt_frame_get_position(frame->get_frame());
         int samples = mlt_audio_calculate_frame_samples(float(m_producer->get_fps()), samplingRate, position);
         auto *data = static_cast<qint16 *>(frame->get_audio(format_s16, samplingRate, channels, samples));
 
-        summary.audioAmplitudes[i] = 0;
+        qint64 sum = 0;
         for (int k = 0; k < samples; ++k) {
-            summary.audioAmplitudes[i] += abs(data[k]);
+            sum += abs(data[k]);
+        }
+        amplitudes[i] = sum;
+        const int progress = int(100 * i / max);
+        if (progress != reportedProgress && progressTimer.elapsed() > 200) {
+            progressTimer.restart();
+            reportedProgress = progress;
+            pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, progress);
         }
-        pCore->displayMessage(i18n("Processing data analysis"), ProcessingJobMessage, int(100 * i / max));
     }
-    qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << m_envelopeSize << " frames) took " << t.elapsed() << " ms.";
+    return true;
+}
+
+AudioEnvelope::AudioSummary AudioEnvelope::loadAndNormalizeEnvelope() const
+{
+    qCDebug(KDENLIVE_LOG) << "Loading envelope …";
+    AudioSummary summary(m_envelopeSize);
+    if (summary.audioAmplitudes.empty()) {
+        return summary;
+    }
+
+    QElapsedTimer t;
+    t.start();
+    if (envelopeFromLevels(summary.audioAmplitudes)) {
+        qCDebug(KDENLIVE_LOG) << "Derived the envelope (" << m_envelopeSize << " frames) from the audio levels in " << t.elapsed() << " ms.";
+    } else if (loadCachedEnvelope(summary.audioAmplitudes)) {
+        qCDebug(KDENLIVE_LOG) << "Loaded the cached envelope (" << m_envelopeSize << " frames) in " << t.elapsed() << " ms.";
+    } else if (decodeEnvelope(summary.audioAmplitudes)) {
+        saveCachedEnvelope(summary.audioAmplitudes);
+        qCDebug(KDENLIVE_LOG) << "Calculating the envelope (" << m_envelopeSize << " frames) took " << t.elapsed() << " ms.";
+    } else {
+        return summary;
+    }
     qCDebug(KDENLIVE_LOG) << "Normalizing envelope …";
     const qint64 meanBeforeNormalization =
         std::accumulate(summary.audioAmplitudes.begin(), summary.audioAmplitudes.end(), 0LL) / qint64(summary.audioAmplitudes.size());
 
     // Normalize the envelope.
     summary.amplitudeMax = 0;
-    for (size_t i = 0; i < max; ++i) {
+    for (size_t i = 0; i < summary.audioAmplitudes.size(); ++i) {
         summary.audioAmplitudes[i] -= meanBeforeNormalization;
         summary.amplitudeMax = std::max(summary.amplitudeMax, qAbs(summary.audioAmplitudes[i]));
     }
@@ -8,6 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #pragma once
 
 #include "audioInfo.h"
+#include "audioLevels.h"
 #include <QFutureWatcher>
 #include <QObject>
 #include <memory>
@@ -22,6 +23,10 @@ class QImage;
   of the absolute values of all samples in the current frame.
 
   See also: http://web.archive.org/web/20180626235917/http://bemasc.net/wordpress/2011/07/26/an-auto-aligner-for-pitivi/
+
+  Decoding the audio is only done once per clip stream and range: the envelope is
+  derived from the audio thumbnail levels when they are available, otherwise the
+  decoded envelope is cached on disk next to the audio thumbnails.
   */
 class AudioEnvelope : public QObject
 {
@@ -52,6 +57,8 @@ public:
     QImage drawEnvelope();
 
     size_t offset();
+    /** Number of frames of the envelope, known before it is computed */
+    size_t envelopeSize() const;
 
     void dumpInfo();
 
@@ -84,6 +91,13 @@ private:
      Actually computes the envelope data, synchronously.
     */
     AudioSummary loadAndNormalizeEnvelope() const;
+    /** Approximate the envelope from the audio thumbnail levels, returns false if they do not cover the range */
+    bool envelopeFromLevels(std::vector<qint64> &amplitudes) const;
+    /** Read the envelope cached by a previous decoding of the same clip stream and range */
+    bool loadCachedEnvelope(std::vector<qint64> &amplitudes) const;
+    void saveCachedEnvelope(const std::vector<qint64> &amplitudes) const;
+    /** Decode the audio to compute the envelope, returns false if the producer cannot be read */
+    bool decodeEnvelope(std::vector<qint64> &amplitudes) const;
 
     std::shared_ptr<Mlt::Producer> m_producer;
     std::unique_ptr<AudioInfo> m_info;
@@ -94,6 +108,11 @@ private:
     const int m_clipId;
     const size_t m_startpos;
     size_t m_envelopeSize;
+    // First frame of the clip covered by the envelope
+    int m_envelopeStart{0};
+    // Audio thumbnail levels of the analysed stream, may be empty
+    AudioLevels m_levels;
+    QString m_cachePath;
 
 Q_SIGNALS:
     void envelopeReady(AudioEnvelope *envelope);
@@ -0,0 +1,275 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "audioLevels.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+const QString AudioLevels::extension = QStringLiteral(".levels");
+
+namespace {
+const char levelsMagic[4] = {'K', 'D', 'A', 'L'};
+const quint32 levelsVersion = 1;
+// magic, version, channels, stream, fps, count, max
+const qint64 headerSize = 4 + 4 + 4 + 4 + 8 + 4 + 4;
+} // namespace
+
+class AudioLevels::Storage
+{
+public:
+    ~Storage()
+    {
+        if (map) {
+            file.unmap(map);
+        }
+    }
+    /** @brief Build the max peak pyramid, each level reducing the number of frames by 4 */
+    void buildPyramid()
+    {
+        pyramid.clear();
+        if (channels <= 0) {
+            return;
+        }
+        const uint8_t *source = data;
+        int frames = length / channels;
+        while (frames > 1) {
+            int buckets = (frames + 3) / 4;
+            std::vector<uint8_t> peaks(size_t(buckets) * size_t(channels), 0);
+            for (int b = 0; b < buckets; ++b) {
+                int last = qMin(4 * b + 4, frames);
+                for (int f = 4 * b; f < last; ++f) {
+                    for (int c = 0; c < channels; ++c) {
+                        uint8_t &peak = peaks[size_t(b) * channels + c];
+                        peak = qMax(peak, source[size_t(f) * channels + c]);
+                    }
+                }
+            }
+            pyramid.push_back(std::move(peaks));
+            source = pyramid.back().data();
+            frames = buckets;
+        }
+    }
+    // Either the mapped file or the vector holds the data
+    QFile file;
+    uchar *map{nullptr};
+    QVector<uint8_t> levels;
+    const uint8_t *data{nullptr};
+    int length{0};
+    int channels{0};
+    int stream{-1};
+    double fps{0.};
+    int maxLevel{0};
+    // pyramid[n] holds the max of 4^(n+1) frames for each channel, channels interleaved
+    std::vector<std::vector<uint8_t>> pyramid;
+};
+
+AudioLevels::AudioLevels(QVector<uint8_t> levels, int channels, int stream, double fps)
+{
+    auto d = std::make_shared<Storage>();
+    d->levels = std::move(levels);
+    d->data = d->levels.constData();
+    d->length = d->levels.size();
+    d->channels = channels;
+    d->stream = stream;
+    d->fps = fps;
+    d->maxLevel = d->levels.isEmpty() ? 0 : *std::max_element(d->levels.constBegin(), d->levels.constEnd());
+    d->buildPyramid();
+    m_d = d;
+}
+
+AudioLevels AudioLevels::allocate(int frames, int channels, int stream, double fps)
+{
+    return AudioLevels(QVector<uint8_t>(qMax(0, frames) * qMax(0, channels), 0), channels, stream, fps);
+}
+
+void AudioLevels::setLevels(int startFrame, const uint8_t *levels, int frames)
+{
+    if (isEmpty() || frames <= 0) {
+        return;
+    }
+    // The levels are only shared with readers, which see zero levels until the frames are set
+    auto d = std::const_pointer_cast<Storage>(m_d);
+    Q_ASSERT(d->map == nullptr);
+    const int channels = d->channels;
+    const int totalFrames = d->length / channels;
+    const int endFrame = qMin(startFrame + frames, totalFrames);
+    if (startFrame < 0 || startFrame >= endFrame) {
+        return;
+    }
+    auto *data = const_cast<uint8_t *>(d->data);
+    const size_t count = size_t(endFrame - startFrame) * size_t(channels);
+    memcpy(data + size_t(startFrame) * channels, levels, count);
+    d->maxLevel = qMax(d->maxLevel, int(*std::max_element(levels, levels + count)));
+    // Update the buckets covering the new frames, level by level
+    const uint8_t *source = data;
+    int sourceFrames = totalFrames;
+    int first = startFrame;
+    int last = endFrame - 1;
+    for (auto &peaks : d->pyramid) {
+        first /= 4;
+        last /= 4;
+        for (int b = first; b <= last; ++b) {
+            const int end = qMin(4 * b + 4, sourceFrames);
+            for (int c = 0; c < channels; ++c) {
+                uint8_t peak = 0;
+                for (int f = 4 * b; f < end; ++f) {
+                    peak = qMax(peak, source[size_t(f) * channels + c]);
+                }
+                peaks[size_t(b) * channels + c] = peak;
+            }
+        }
+        source = peaks.data();
+        sourceFrames = (sourceFrames + 3) / 4;
+    }
+}
+
+AudioLevels AudioLevels::load(const QString &path)
+{
+    AudioLevels result;
+    auto d = std::make_shared<Storage>();
+    d->file.setFileName(path);
+    if (!d->file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+    qint64 fileSize = d->file.size();
+    if (fileSize <= headerSize) {
+        return result;
+    }
+    d->map = d->file.map(0, fileSize);
+    if (d->map == nullptr) {
+        qDebug() << "// Cannot map audio levels" << path << d->file.errorString();
+        return result;
+    }
+    const uchar *header = d->map;
+    if (memcmp(header, levelsMagic, 4) != 0 || qFromLittleEndian<quint32>(header + 4) != levelsVersion) {
+        return result;
+    }
+    d->channels = int(qFromLittleEndian<quint32>(header + 8));
+    d->stream = qFromLittleEndian<qint32>(header + 12);
+    quint64 fpsBits = qFromLittleEndian<quint64>(header + 16);
+    memcpy(&d->fps, &fpsBits, sizeof(double));
+    d->length = int(qFromLittleEndian<quint32>(header + 24));
+    d->maxLevel = int(qFromLittleEndian<quint32>(header + 28));
+    if (d->channels <= 0 || headerSize + d->length > fileSize) {
+        // Truncated file
+        return result;
+    }
+    d->data = reinterpret_cast<const uint8_t *>(d->map + headerSize);
+    // The file descriptor is not needed anymore, the mapping stays valid until unmapped
+    d->file.close();
+    d->buildPyramid();
+    result.m_d = d;
+    return result;
+}
+
+bool AudioLevels::save(const QString &path) const
+{
+    if (isEmpty()) {
+        return false;
+    }
+    uchar header[headerSize];
+    memcpy(header, levelsMagic, 4);
+    qToLittleEndian<quint32>(levelsVersion, header + 4);
+    qToLittleEndian<quint32>(quint32(m_d->channels), header + 8);
+    qToLittleEndian<qint32>(m_d->stream, header + 12);
+    quint64 fpsBits;
+    memcpy(&fpsBits, &m_d->fps, sizeof(double));
+    qToLittleEndian<quint64>(fpsBits, header + 16);
+    qToLittleEndian<quint32>(quint32(m_d->length), header + 24);
+    qToLittleEndian<quint32>(quint32(m_d->maxLevel), header + 28);
+    // Write to a temporary file first so that a mapped previous version is never truncated
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "// Cannot write audio levels" << path << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(header), headerSize);
+    file.write(reinterpret_cast<const char *>(m_d->data), m_d->length);
+    return file.commit();
+}
+
+bool AudioLevels::isEmpty() const
+{
+    return m_d == nullptr || m_d->length == 0;
+}
+
+int AudioLevels::length() const
+{
+    return m_d ? m_d->length : 0;
+}
+
+const uint8_t *AudioLevels::constData() const
+{
+    return m_d ? m_d->data : nullptr;
+}
+
+int AudioLevels::channels() const
+{
+    return m_d ? m_d->channels : 0;
+}
+
+int AudioLevels::stream() const
+{
+    return m_d ? m_d->stream : -1;
+}
+
+double AudioLevels::fps() const
+{
+    return m_d ? m_d->fps : 0.;
+}
+
+int AudioLevels::maxLevel() const
+{
+    return m_d ? m_d->maxLevel : 0;
+}
+
+int AudioLevels::pyramidDepth() const
+{
+    return m_d ? int(m_d->pyramid.size()) + 1 : 0;
+}
+
+uint8_t AudioLevels::peak(int channel, int startFrame, int endFrame) const
+{
+    if (isEmpty() || channel >= m_d->channels) {
+        return 0;
+    }
+    const int channels = m_d->channels;
+    const int frames = m_d->length / channels;
+    if (frames == 0) {
+        return 0;
+    }
+    startFrame = qBound(0, startFrame, frames - 1);
+    endFrame = qBound(startFrame + 1, endFrame, frames);
+    const int depth = int(m_d->pyramid.size());
+    const int firstChannel = channel < 0 ? 0 : channel;
+    const int lastChannel = channel < 0 ? channels - 1 : channel;
+    uint8_t result = 0;
+    int frame = startFrame;
+    while (frame < endFrame) {
+        // Take the coarsest bucket starting at this frame that does not go past the range end,
+        // bucket sizes grow towards the middle of the range and shrink again at its end
+        int level = 0;
+        while (level < depth) {
+            const int bucketSize = 1 << (2 * (level + 1));
+            if ((frame & (bucketSize - 1)) != 0 || frame + bucketSize > endFrame) {
+                break;
+            }
+            level++;
+        }
+        const uint8_t *peaks = level == 0 ? m_d->data : m_d->pyramid.at(size_t(level - 1)).data();
+        const size_t bucket = size_t(frame >> (2 * level));
+        for (int c = firstChannel; c <= lastChannel; ++c) {
+            result = qMax(result, peaks[bucket * channels + c]);
+        }
+        frame += 1 << (2 * level);
+    }
+    return result;
+}
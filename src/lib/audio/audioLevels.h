@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <memory>
+
+/** @class AudioLevels
+    @brief Read-only, implicitly shared view on the per-frame audio levels of a clip stream.
+    Levels are stored as one uint8_t per channel per frame, channels interleaved.
+    The data either lives in memory (while it is being generated) or is memory-mapped from the
+    binary peak file stored in the audio cache folder, so that copies never duplicate the buffer.
+
+    A max peak pyramid (each level aggregating 4 times more frames than the previous one) is built once
+    when the levels are created or loaded, so that drawing a zoomed out waveform costs the same as a zoomed in one.
+
+    The peak file starts with a fixed size little endian header:
+    magic "KDAL", format version, channel count, stream index, fps (as IEEE double), level count and max level,
+    followed by the raw level bytes.
+ */
+class AudioLevels
+{
+public:
+    AudioLevels() = default;
+    /** @brief Build levels from an in-memory buffer */
+    AudioLevels(QVector<uint8_t> levels, int channels, int stream, double fps);
+    /** @brief Create zero filled levels for @p frames frames, filled with setLevels() while they are generated.
+        Copies share the buffer, so that they see the frames as they are set without copying the levels */
+    static AudioLevels allocate(int frames, int channels, int stream, double fps);
+    /** @brief Set the levels of @p frames frames from startFrame, only updating the pyramid buckets of these frames.
+        Only for levels created by allocate(), and not from several threads at the same time */
+    void setLevels(int startFrame, const uint8_t *levels, int frames);
+
+    /** @brief Memory-map a peak file. Returns empty levels if the file is missing or invalid */
+    static AudioLevels load(const QString &path);
+    /** @brief Write the levels to a peak file */
+    bool save(const QString &path) const;
+
+    bool isEmpty() const;
+    int length() const;
+    uint8_t at(int ix) const { return constData()[ix]; }
+    const uint8_t *constData() const;
+    const uint8_t *constBegin() const { return constData(); }
+    const uint8_t *constEnd() const { return constData() + length(); }
+
+    int channels() const;
+    int stream() const;
+    double fps() const;
+    /** @brief Highest level over all channels and frames */
+    int maxLevel() const;
+
+    /** @brief Highest level of a channel between startFrame (included) and endFrame (excluded)
+        @param channel the channel index, or -1 to get the highest level over all channels
+        The range is split into the largest pyramid buckets it fully covers, so that no frame outside of it is read
+        and the cost only grows with the logarithm of the range length.
+    */
+    uint8_t peak(int channel, int startFrame, int endFrame) const;
+    /** @brief Number of pyramid levels, level 0 being the per frame levels */
+    int pyramidDepth() const;
+
+    /** @brief File extension of the peak files */
+    static const QString extension;
+
+private:
+    class Storage;
+    std::shared_ptr<const Storage> m_d;
+};
@@ -15,16 +15,8 @@ extern "C" {
 
 void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated)
 {
-    auto *correlatedFloat = new float[leftSize + rightSize + 1];
-    correlate(left, leftSize, right, rightSize, correlatedFloat);
-
-    // The correlation vector will have entries up to N (number of entries
-    // of the vector), so converting to integers will not lose that much
-    // of precision.
-    for (size_t i = 0; i < leftSize + rightSize + 1; ++i) {
-        out_correlated[i] = qint64(correlatedFloat[i]);
-    }
-    delete[] correlatedFloat;
+    Reference reference(left, leftSize, rightSize);
+    reference.correlate(right, rightSize, out_correlated);
 }
 
 void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated)
@@ -32,41 +24,142 @@ void FFTCorrelation::correlate(const qint64 *left, const size_t leftSize, const
     QElapsedTimer t;
     t.start();
 
-    auto *leftF = new float[leftSize];
-    auto *rightF = new float[rightSize];
+    Reference reference(left, leftSize, rightSize);
+    reference.correlate(right, rightSize, out_correlated);
+
+    qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
+}
+
+namespace {
+/** @brief Size of the transformation for a correlation between vectors of these sizes */
+size_t transformSize(size_t leftSize, size_t rightSize)
+{
+    // To avoid issues with repetition (we are dealing with cosine waves
+    // in the fourier domain) we need to pad the vectors to at least twice their size,
+    // otherwise convolution would convolve with the repeated pattern as well
+    size_t largestSize = std::max(leftSize, rightSize);
+
+    // The vectors must have the same size (same frequency resolution!) and should
+    // be a power of 2 (for FFT).
+    size_t size = 64;
+    while (size / 2 < largestSize) {
+        size = size << 1;
+    }
+    return size;
+}
+
+// Dividing by the max value is maybe not the best solution, but the
+// maximum value after correlation should not be larger than the longest
+// vector since each value should be at most 1
+qint64 maxAmplitude(const qint64 *data, size_t size)
+{
+    qint64 max = 1;
+    for (size_t i = 0; i < size; ++i) {
+        max = std::max(max, qAbs(data[i]));
+    }
+    return max;
+}
+} // namespace
 
+FFTCorrelation::Reference::Reference(const qint64 *left, const size_t leftSize, const size_t maxRightSize)
+    : m_size(leftSize)
+    , m_maxRightSize(maxRightSize)
+    , m_fftSize(transformSize(leftSize, maxRightSize))
+    , m_spectrum(m_fftSize / 2 + 1)
+{
     // First the qint64 values need to be normalized to floats
-    // Dividing by the max value is maybe not the best solution, but the
-    // maximum value after correlation should not be larger than the longest
-    // vector since each value should be at most 1
-    qint64 maxLeft = 1;
-    qint64 maxRight = 1;
+    const qint64 maxLeft = maxAmplitude(left, leftSize);
+    std::vector<float> leftData(m_fftSize, 0);
     for (size_t i = 0; i < leftSize; ++i) {
-        if (qAbs(left[i]) > maxLeft) {
-            maxLeft = qAbs(left[i]);
-        }
+        leftData[i] = float(left[i]) / maxLeft;
     }
-    for (size_t i = 0; i < rightSize; ++i) {
-        if (qAbs(right[i]) > maxRight) {
-            maxRight = qAbs(right[i]);
-        }
+    Configs configs = acquireConfigs();
+    kiss_fftr(configs.forward, &leftData[0], &m_spectrum[0]);
+    releaseConfigs(configs);
+}
+
+FFTCorrelation::Reference::~Reference()
+{
+    for (const Configs &configs : m_configs) {
+        kiss_fftr_free(configs.forward);
+        kiss_fftr_free(configs.inverse);
+    }
+}
+
+size_t FFTCorrelation::Reference::size() const
+{
+    return m_size;
+}
+
+size_t FFTCorrelation::Reference::maxRightSize() const
+{
+    return m_maxRightSize;
+}
+
+FFTCorrelation::Reference::Configs FFTCorrelation::Reference::acquireConfigs() const
+{
+    QMutexLocker lock(&m_configsMutex);
+    if (m_configs.empty()) {
+        return {kiss_fftr_alloc(int(m_fftSize), 0, nullptr, nullptr), kiss_fftr_alloc(int(m_fftSize), 1, nullptr, nullptr)};
+    }
+    Configs configs = m_configs.back();
+    m_configs.pop_back();
+    return configs;
+}
+
+void FFTCorrelation::Reference::releaseConfigs(const Configs &configs) const
+{
+    QMutexLocker lock(&m_configsMutex);
+    m_configs.push_back(configs);
+}
+
+void FFTCorrelation::Reference::correlate(const qint64 *right, const size_t rightSize, qint64 *out_correlated) const
+{
+    std::vector<float> correlatedFloat(m_size + rightSize + 1);
+    correlate(right, rightSize, correlatedFloat.data());
+
+    // The correlation vector will have entries up to N (number of entries
+    // of the vector), so converting to integers will not lose that much
+    // of precision.
+    for (size_t i = 0; i < correlatedFloat.size(); ++i) {
+        out_correlated[i] = qint64(correlatedFloat[i]);
     }
+}
+
+void FFTCorrelation::Reference::correlate(const qint64 *right, const size_t rightSize, float *out_correlated) const
+{
+    Q_ASSERT(rightSize <= m_maxRightSize);
+    const size_t fft_size = m_fftSize / 2 + 1;
+    std::vector<kiss_fft_cpx> rightFFT(fft_size);
+    std::vector<float> rightData(m_fftSize, 0);
+    std::vector<float> convolved(m_fftSize);
 
     // One side needs to be reversed, since multiplication in frequency domain (fourier space)
     // calculates the convolution: \sum l[x]r[N-x] and not the correlation: \sum l[x]r[x]
-    for (size_t i = 0; i < leftSize; ++i) {
-        leftF[i] = float(left[i]) / maxLeft;
-    }
+    const qint64 maxRight = maxAmplitude(right, rightSize);
     for (size_t i = 0; i < rightSize; ++i) {
-        rightF[rightSize - 1 - i] = float(right[i]) / maxRight;
+        rightData[rightSize - 1 - i] = float(right[i]) / maxRight;
     }
 
-    // Now we can convolve to get the correlation
-    convolve(leftF, leftSize, rightF, rightSize, out_correlated);
+    Configs configs = acquireConfigs();
+    kiss_fftr(configs.forward, &rightData[0], &rightFFT[0]);
 
-    qCDebug(KDENLIVE_LOG) << "Correlation (FFT based) computed in " << t.elapsed() << " ms.";
-    delete[] leftF;
-    delete[] rightF;
+    // Convolution in spacial domain is a multiplication in fourier domain. O(n).
+    for (size_t i = 0; i < fft_size; ++i) {
+        const kiss_fft_cpx value = rightFFT[i];
+        rightFFT[i].r = m_spectrum[i].r * value.r - m_spectrum[i].i * value.i;
+        rightFFT[i].i = m_spectrum[i].r * value.i + m_spectrum[i].i * value.r;
+    }
+
+    // Inverse fourier transformation to get the convolved data.
+    kiss_fftri(configs.inverse, &rightFFT[0], &convolved[0]);
+    releaseConfigs(configs);
+
+    // Insert one element at the beginning to obtain the same result
+    // that we also get with the nested for loop correlation.
+    *out_correlated = 0;
+    size_t out_size = m_size + rightSize + 1;
+    std::copy(convolved.begin(), convolved.begin() + int(out_size) - 1, out_correlated + 1);
 }
 
 void FFTCorrelation::convolve(const float *left, const size_t leftSize, const float *right, const size_t rightSize, float *out_convolved)
@@ -74,18 +167,7 @@ void FFTCorrelation::convolve(const float *left, const size_t leftSize, const fl
     QElapsedTimer time;
     time.start();
 
-    // To avoid issues with repetition (we are dealing with cosine waves
-    // in the fourier domain) we need to pad the vectors to at least twice their size,
-    // otherwise convolution would convolve with the repeated pattern as well
-    size_t largestSize = std::max(leftSize, rightSize);
-
-    // The vectors must have the same size (same frequency resolution!) and should
-    // be a power of 2 (for FFT).
-    size_t size = 64;
-    while (size / 2 < largestSize) {
-        size = size << 1;
-    }
-
+    const size_t size = transformSize(leftSize, rightSize);
     const size_t fft_size = size / 2 + 1;
     kiss_fftr_cfg fftConfig = kiss_fftr_alloc(int(size), 0, nullptr, nullptr);
     kiss_fftr_cfg ifftConfig = kiss_fftr_alloc(int(size), 1, nullptr, nullptr);
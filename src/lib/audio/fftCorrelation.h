@@ -5,7 +5,11 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include "../external/kiss_fft/tools/kiss_fftr.h"
+#include <QMutex>
 #include <QtGlobal>
+#include <vector>
+
 /** @class FFTCorrelation
     @brief This class provides methods to calculate convolution
     and correlation of two vectors by means of FFT, which
@@ -30,4 +34,51 @@ public:
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, float *out_correlated);
 
     static void correlate(const qint64 *left, const size_t leftSize, const qint64 *right, const size_t rightSize, qint64 *out_correlated);
+
+    /** @class Reference
+        @brief The normalized spectrum of a reference vector, computed once and
+        correlated with any number of vectors up to a maximum size.
+        Correlating with a Reference gives the same result as correlate() with the
+        reference as \c left, and can be done from several threads at the same time.
+      */
+    class Reference
+    {
+    public:
+        /**
+          @param maxRightSize size of the largest vector that will be correlated with the reference,
+                              it determines the size of the transformation
+          */
+        Reference(const qint64 *left, const size_t leftSize, const size_t maxRightSize);
+        ~Reference();
+        Reference(const Reference &) = delete;
+        Reference &operator=(const Reference &) = delete;
+
+        size_t size() const;
+        size_t maxRightSize() const;
+
+        /**
+          Computes the correlation between the reference and \c right.
+          \c out_correlated must be a pre-allocated vector of size
+          size() + \c rightSize + 1, \c rightSize must not exceed maxRightSize().
+          */
+        void correlate(const qint64 *right, const size_t rightSize, float *out_correlated) const;
+        void correlate(const qint64 *right, const size_t rightSize, qint64 *out_correlated) const;
+
+    private:
+        struct Configs
+        {
+            kiss_fftr_cfg forward;
+            kiss_fftr_cfg inverse;
+        };
+        /** kiss_fftr configurations hold scratch buffers, so each thread needs its own pair */
+        Configs acquireConfigs() const;
+        void releaseConfigs(const Configs &configs) const;
+
+        size_t m_size;
+        size_t m_maxRightSize;
+        size_t m_fftSize;
+        std::vector<kiss_fft_cpx> m_spectrum;
+        mutable QMutex m_configsMutex;
+        mutable std::vector<Configs> m_configs;
+    };
 };
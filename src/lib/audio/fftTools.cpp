@@ -7,7 +7,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "fftTools.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 
 #include <QString>
@@ -105,19 +107,21 @@ const QVector<float> FFTTools::window(const WindowType windowType, const int siz
     return QVector<float>();
 }
 
-void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum, const WindowType windowType,
-                             const uint windowSize, const float param)
+namespace {
+/** @brief Returns the first element of the storage aligned on 32 bytes, the storage being over-allocated for it */
+template <typename T> T *alignedData(std::vector<T> &storage)
 {
-#ifdef DEBUG_FFTTOOLS
-    QTime start = QTime::currentTime();
-#endif
-
-    const uint numSamples = uint(audioFrame.size()) / numChannels;
+    static_assert(32 % sizeof(T) == 0, "Elements must fit evenly in the alignment");
+    const auto address = reinterpret_cast<uintptr_t>(storage.data());
+    return reinterpret_cast<T *>((address + 31) & ~uintptr_t(31));
+}
+} // namespace
 
-    if (((windowSize & 1) != 0u) || windowSize < 2) {
-        return;
+const FFTTools::Plan &FFTTools::plan(const WindowType windowType, const uint windowSize, const float param)
+{
+    if (m_plan.cfg != nullptr && m_plan.windowSize == windowSize && m_plan.windowType == windowType && qFuzzyCompare(1.f + m_plan.param, 1.f + param)) {
+        return m_plan;
     }
-
     const QString cfgSig = cfgSignature(int(windowSize));
     const QString winSig = windowSignature(windowType, int(windowSize), param);
 
@@ -142,7 +146,6 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
     QVector<float> window;
     float windowScaleFactor = 1;
     if (windowType != FFTTools::Window_Rect) {
-
         if (m_windowFunctions.contains(winSig)) {
 #ifdef DEBUG_FFTTOOLS
             qCDebug(KDENLIVE_LOG) << "Re-using window function with signature " << winSig;
@@ -152,46 +155,74 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 #ifdef DEBUG_FFTTOOLS
             qCDebug(KDENLIVE_LOG) << "Building new window function with signature " << winSig;
 #endif
-            window = FFTTools::window(windowType, int(windowSize), 0);
+            window = FFTTools::window(windowType, int(windowSize), param);
             m_windowFunctions.insert(winSig, window);
         }
         windowScaleFactor = 1.0f / window[int(windowSize)];
     }
 
-    // Prepare frequency space vector. The resulting FFT vector is only half as long.
-    auto *freqData = new kiss_fft_cpx[size_t(windowSize) / 2];
-    auto *data = new float[size_t(windowSize)];
-
-    // Copy the first channel's audio into a vector for the FFT display;
-    // Fill the data vector indices that cannot be covered with sample data with 0
-    if (numSamples < windowSize) {
-        std::fill(&data[numSamples], &data[windowSize - 1], 0);
-    }
+    m_plan.cfg = myCfg;
+    m_plan.windowType = windowType;
+    m_plan.windowSize = windowSize;
+    m_plan.param = param;
     // Normalize signals to [0,1] to get correct dB values later on
-    for (uint i = 0; i < numSamples && i < windowSize; ++i) {
-        // Performance note: Benchmarking has shown that using the if/else inside the loop
-        // does not do noticeable worse than keeping it outside (perhaps the branch predictor
-        // is good enough), so it remains in there for better readability.
-        if (windowType != FFTTools::Window_Rect) {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f * window[int(i)];
-        } else {
-            data[i] = float(audioFrame.data()[i * numChannels + channel]) / 32767.0f;
+    m_plan.window = QVector<float>(int(windowSize), 1.0f / 32767.0f);
+    if (!window.isEmpty()) {
+        for (int i = 0; i < int(windowSize); ++i) {
+            m_plan.window[i] *= window.at(i);
         }
     }
+    // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
+    // with N = FFT size (after FFT, 1/2 window size), which is 10 * log(r² + i²) plus a constant
+    m_plan.dbOffset = 20 * log10f(windowScaleFactor / (float(windowSize) / 2.0f));
+    return m_plan;
+}
+
+void FFTTools::reserveBuffers(const uint windowSize)
+{
+    // kiss_fftr writes windowSize/2 + 1 frequencies, the extra elements leave room for the alignment
+    const size_t inputSize = size_t(windowSize) + 8;
+    const size_t outputSize = size_t(windowSize) / 2 + 1 + 4;
+    if (m_inputStorage.size() < inputSize) {
+        m_inputStorage.resize(inputSize);
+        m_input = alignedData(m_inputStorage);
+    }
+    if (m_outputStorage.size() < outputSize) {
+        m_outputStorage.resize(outputSize);
+        m_output = alignedData(m_outputStorage);
+    }
+}
+
+void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint channel, const uint numChannels, float *freqSpectrum, const WindowType windowType,
+                             const uint windowSize, const float param)
+{
+#ifdef DEBUG_FFTTOOLS
+    QTime start = QTime::currentTime();
+#endif
+
+    if (((windowSize & 1) != 0u) || windowSize < 2 || channel >= numChannels) {
+        return;
+    }
+    const Plan &myPlan = plan(windowType, windowSize, param);
+    reserveBuffers(windowSize);
+
+    const uint numSamples = qMin(uint(audioFrame.size()) / numChannels, windowSize);
+    const qint16 *samples = audioFrame.constData() + channel;
+    const float *window = myPlan.window.constData();
+
+    // Copy the channel into the work buffer, applying the window function and the normalization at the same time
+    for (uint i = 0; i < numSamples; ++i) {
+        m_input[i] = float(samples[size_t(i) * numChannels]) * window[i];
+    }
+    // Fill the data vector indices that cannot be covered with sample data with 0
+    std::fill(m_input + numSamples, m_input + windowSize, 0.f);
 
     // Calculate the Fast Fourier Transform for the input data
-    kiss_fftr(myCfg, data, freqData);
+    kiss_fftr(myPlan.cfg, m_input, m_output);
 
-    // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-    // with N = FFT size (after FFT, 1/2 window size)
     for (uint i = 0; i < windowSize / 2; ++i) {
-        // Logarithmic scale: 20 * log ( 2 * magnitude / N ) with magnitude = sqrt(r² + i²)
-        // with N = FFT size (after FFT, 1/2 window size)
-        freqSpectrum[i] =
-            20 *
-            logf(powf(powf(fabs(freqData[i].r * windowScaleFactor), 2) + powf(fabs(freqData[i].i * windowScaleFactor), 2), .5) / (float(windowSize) / 2.0f)) /
-            logf(10);
-        ;
+        const float power = m_output[i].r * m_output[i].r + m_output[i].i * m_output[i].i;
+        freqSpectrum[i] = 10 * log10f(power) + myPlan.dbOffset;
     }
 
 #ifdef DEBUG_FFTTOOLS
@@ -202,14 +233,14 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
     } else {
         mFile << "val = [ ";
 
-        for (int sample = 0; sample < 256; ++sample) {
-            mFile << data[sample] << ' ';
+        for (uint sample = 0; sample < 256 && sample < windowSize; ++sample) {
+            mFile << m_input[sample] << ' ';
         }
         mFile << " ];\n";
 
         mFile << "freq = [ ";
-        for (int sample = 0; sample < 256; ++sample) {
-            mFile << freqData[sample].r << '+' << freqData[sample].i << "*i ";
+        for (uint sample = 0; sample < 256 && sample <= windowSize / 2; ++sample) {
+            mFile << m_output[sample].r << '+' << m_output[sample].i << "*i ";
         }
         mFile << " ];\n";
 
@@ -221,8 +252,6 @@ void FFTTools::fftNormalized(const audioShortVector &audioFrame, const uint chan
 #ifdef DEBUG_FFTTOOLS
     qCDebug(KDENLIVE_LOG) << "Calculated FFT in " << start.elapsed() << " ms.";
 #endif
-    delete[] freqData;
-    delete[] data;
 }
 
 const QVector<float> FFTTools::interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left, uint right, float fill)
@@ -11,12 +11,15 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "../external/kiss_fft/tools/kiss_fftr.h"
 #include <QHash>
 #include <QVector>
+#include <vector>
 
 class FFTTools
 {
 public:
     FFTTools();
     ~FFTTools();
+    FFTTools(const FFTTools &) = delete;
+    FFTTools &operator=(const FFTTools &) = delete;
 
     enum WindowType { Window_Rect, Window_Triangle, Window_Hamming };
 
@@ -70,6 +73,29 @@ public:
     static const QVector<float> interpolatePeakPreserving(const QVector<float> &in, const uint targetSize, uint left = 0, uint right = 0, float fill = 0.0);
 
 private:
+    /** A FFT configuration together with the matching window function, ready to be applied to 16 bit samples */
+    struct Plan
+    {
+        kiss_fftr_cfg cfg{nullptr};
+        WindowType windowType{Window_Rect};
+        uint windowSize{0};
+        float param{0};
+        /** The window function divided by 32767, so that windowing also normalizes the samples */
+        QVector<float> window;
+        /** Offset in dB compensating for the window area and the FFT size */
+        float dbOffset{0};
+    };
+    /** Returns the plan for the given window, from the caches if possible */
+    const Plan &plan(const WindowType windowType, const uint windowSize, const float param);
+    /** Resize the work buffers if needed, they are never shrunk */
+    void reserveBuffers(const uint windowSize);
+
     QHash<QString, kiss_fftr_cfg> m_fftCfgs;          // FFT cfg cache
     QHash<QString, QVector<float>> m_windowFunctions; // Window function cache
+    Plan m_plan;                                      // Last used plan, avoids looking up the caches for each frame
+    // Preallocated work buffers, over-allocated so that the data starts on a 32 bytes boundary
+    std::vector<float> m_inputStorage;
+    std::vector<kiss_fft_cpx> m_outputStorage;
+    float *m_input{nullptr};
+    kiss_fft_cpx *m_output{nullptr};
 };
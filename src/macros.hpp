@@ -47,9 +47,14 @@ reading a Read-protected property. In that case, we try to write lock it first (
  * The lambdas are transformed to make sure they lock access to the class they operate on.
  * Then they are added on the undoStack
  */
-#define PUSH_UNDO(undo, redo, text)                                                                                                                            \
+#define PUSH_UNDO(undo, redo, text) PUSH_UNDO_WITH_SIZE(undo, redo, text, 0)
+
+/** @brief Same as PUSH_UNDO for operations whose lambdas keep alive a known amount of data, like XML or parameter values.
+ * payloadSize is its size in bytes, used by the undo stack to estimate its memory use
+ */
+#define PUSH_UNDO_WITH_SIZE(undo, redo, text, payloadSize)                                                                                                     \
     if (auto ptr = m_undoStack.lock()) {                                                                                                                       \
-        ptr->push(new FunctionalUndoCommand(undo, redo, text));                                                                                                \
+        ptr->push(new FunctionalUndoCommand(undo, redo, text, payloadSize));                                                                                   \
     } else {                                                                                                                                                   \
         qDebug() << "ERROR : unable to access undo stack";                                                                                                     \
         Q_ASSERT(false);                                                                                                                                       \
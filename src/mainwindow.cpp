@@ -63,6 +63,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "titler/titlewidget.h"
 #include "transitions/transitionlist/view/transitionlistwidget.hpp"
 #include "transitions/transitionsrepository.hpp"
+#include "utils/probecache.hpp"
 #include "utils/thememanager.h"
 #include "widgets/progressbutton.h"
 #include <config-kdenlive.h>
@@ -98,6 +99,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDesktopServices>
 #include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QJsonDocument>
 #include <QMenu>
 #include <QMenuBar>
 #include <QPushButton>
@@ -1914,10 +1916,18 @@ void MainWindow::setupActions()
 
     QAction *undo = KStandardAction::undo(m_commandStack, SLOT(undo()), actionCollection());
     undo->setEnabled(false);
-    connect(m_commandStack, &QUndoGroup::canUndoChanged, undo, &QAction::setEnabled);
+    // Steps discarded to limit the undo history memory cannot be undone. canUndo stays true when the index moves
+    // down to a discarded step, so the index changes are also checked
+    auto updateUndo = [this, undo]() {
+        auto *stack = qobject_cast<DocUndoStack *>(m_commandStack->activeStack());
+        undo->setEnabled(stack && stack->hasUndoableStep());
+    };
+    connect(m_commandStack, &QUndoGroup::canUndoChanged, undo, updateUndo);
+    connect(m_commandStack, &QUndoGroup::indexChanged, undo, updateUndo);
     connect(this, &MainWindow::enableUndo, this, [this, undo](bool enable) {
         if (enable) {
-            enable = m_commandStack->activeStack()->canUndo();
+            auto *stack = qobject_cast<DocUndoStack *>(m_commandStack->activeStack());
+            enable = stack && stack->hasUndoableStep();
         }
         undo->setEnabled(enable);
     });
@@ -2339,6 +2349,11 @@ void MainWindow::scriptRender(const QString &url)
     m_renderWidget->slotPrepareExport(true, url);
 }
 
+QString MainWindow::jobStatistics() const
+{
+    return QString::fromUtf8(QJsonDocument(pCore->taskManager.statistics()).toJson(QJsonDocument::Compact));
+}
+
 #ifndef NODBUS
 void MainWindow::exitApp()
 {
@@ -4695,6 +4710,8 @@ void MainWindow::checkMaxCacheSize()
         return;
     }
     KdenliveSettings::setLastCacheCheck(QDateTime::currentDateTime());
+    // Drop the old entries of the media information shared by all projects
+    ProbeCache::get()->prune(QDateTime::currentDateTime().addMonths(-KdenliveSettings::cleanCacheMonths()));
     bool ok;
     KIO::filesize_t total = 0;
     QDir cacheDir = pCore->currentDoc()->getCacheDir(SystemCacheRoot, &ok);
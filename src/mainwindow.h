@@ -331,6 +331,8 @@ public Q_SLOTS:
     Q_SCRIPTABLE void addTimelineClip(const QString &url);
     Q_SCRIPTABLE void addEffect(const QString &effectId);
     Q_SCRIPTABLE void scriptRender(const QString &url);
+    /** @brief Statistics of the background jobs as a JSON document, see TaskManager::statistics */
+    Q_SCRIPTABLE QString jobStatistics() const;
 #ifndef NODBUS
     Q_NOREPLY void exitApp();
 #endif
@@ -28,6 +28,7 @@
 #include <QQmlContext>
 #include <QQuickItem>
 #include <memory>
+#include <vector>
 
 #include "bin/model/markersortmodel.h"
 #include "core.h"
@@ -70,6 +71,7 @@ using namespace Mlt;
 GLWidget::GLWidget(int id, QWidget *parent)
     : QQuickWidget(parent)
     , sendFrameForAnalysis(false)
+    , sendFullSizeFrame(false)
     , m_glslManager(nullptr)
     , m_consumer(nullptr)
     , m_producer(nullptr)
@@ -437,6 +439,65 @@ static void uploadTextures(QOpenGLContext *context, const SharedFrame &frame, GL
     check_error(f);
 }
 
+/** @brief Convert the sampled pixels of a yuv420p frame to a RGB32 image of the given size
+ *  Only the pixels read by the scopes are converted, instead of rendering and reading back the whole frame.
+ */
+static QImage sampleAnalysisFrame(const SharedFrame &frame, const QSize &size, int colorSpace)
+{
+    const int width = frame.get_image_width();
+    const int height = frame.get_image_height();
+    const uint8_t *image = frame.get_image(mlt_image_yuv420p);
+    if (image == nullptr || width < 2 || height < 2 || size.isEmpty()) {
+        return QImage();
+    }
+    const uint8_t *yPlane = image;
+    const uint8_t *uPlane = image + width * height;
+    const uint8_t *vPlane = uPlane + width / 2 * height / 2;
+    const int chromaWidth = width / 2;
+    const int chromaHeight = height / 2;
+    // Same coefficients as the display shader, in 16 bits fixed point
+    const int yFactor = 76304;
+    const int rv = colorSpace == 601 ? 104582 : 117506;
+    const int gu = colorSpace == 601 ? -25672 : -13959;
+    const int gv = colorSpace == 601 ? -53274 : -34931;
+    const int bu = colorSpace == 601 ? 132186 : 138412;
+
+    QImage result(size, QImage::Format_RGB32);
+    std::vector<int> columns(size_t(size.width()));
+    for (int x = 0; x < size.width(); ++x) {
+        columns[size_t(x)] = int((qint64(2 * x + 1) * width) / (2 * size.width()));
+    }
+    for (int y = 0; y < size.height(); ++y) {
+        const int row = int((qint64(2 * y + 1) * height) / (2 * size.height()));
+        const uint8_t *yLine = yPlane + qint64(row) * width;
+        const int chromaRow = qMin(row / 2, chromaHeight - 1);
+        const uint8_t *uLine = uPlane + qint64(chromaRow) * chromaWidth;
+        const uint8_t *vLine = vPlane + qint64(chromaRow) * chromaWidth;
+        auto *line = reinterpret_cast<QRgb *>(result.scanLine(y));
+        for (int x = 0; x < size.width(); ++x) {
+            const int column = columns[size_t(x)];
+            const int chromaColumn = qMin(column / 2, chromaWidth - 1);
+            const int luma = yFactor * (yLine[column] - 16);
+            const int u = uLine[chromaColumn] - 128;
+            const int v = vLine[chromaColumn] - 128;
+            const int r = qBound(0, (luma + rv * v + 32768) >> 16, 255);
+            const int g = qBound(0, (luma + gu * u + gv * v + 32768) >> 16, 255);
+            const int b = qBound(0, (luma + bu * u + 32768) >> 16, 255);
+            line[x] = qRgb(r, g, b);
+        }
+    }
+    return result;
+}
+
+QSize GLWidget::analysisSize() const
+{
+    const int maxWidth = KdenliveSettings::scopes_analysis_width();
+    if (sendFullSizeFrame || maxWidth <= 0 || m_profileSize.width() <= maxWidth) {
+        return m_profileSize;
+    }
+    return QSize(maxWidth, qMax(1, qRound(double(m_profileSize.height()) * maxWidth / m_profileSize.width())));
+}
+
 void GLWidget::clear()
 {
     stopGlsl();
@@ -652,29 +713,35 @@ void GLWidget::paintGL()
     check_error(f);
 
     if (m_sendFrame && m_analyseSem.tryAcquire(1)) {
-        // Render RGB frame for analysis
-        if (!qFuzzyCompare(m_zoom, 1.0f)) {
-            // Disable monitor zoom to render frame
-            modelView = QMatrix4x4();
-            m_shader->setUniformValue(m_modelViewLocation, modelView);
-        }
-        if ((m_fbo == nullptr) || m_fbo->size() != m_profileSize) {
-            delete m_fbo;
-            QOpenGLFramebufferObjectFormat fmt;
-            fmt.setSamples(1);
-            m_fbo = new QOpenGLFramebufferObject(m_profileSize.width(), m_profileSize.height(), fmt); // GL_TEXTURE_2D);
-        }
-        m_fbo->bind();
-        glViewport(0, 0, m_profileSize.width(), m_profileSize.height());
+        const QSize frameSize = analysisSize();
+        if (m_glslManager == nullptr && frameSize != m_profileSize) {
+            // Sample the reduced frame directly from the yuv buffer instead of rendering and reading back the full frame
+            Q_EMIT analyseFrame(sampleAnalysisFrame(m_sharedFrame, frameSize, m_colorSpace));
+        } else {
+            // Render RGB frame for analysis, the viewport scales it to the analysis size
+            if (!qFuzzyCompare(m_zoom, 1.0f)) {
+                // Disable monitor zoom to render frame
+                modelView = QMatrix4x4();
+                m_shader->setUniformValue(m_modelViewLocation, modelView);
+            }
+            if ((m_fbo == nullptr) || m_fbo->size() != frameSize) {
+                delete m_fbo;
+                QOpenGLFramebufferObjectFormat fmt;
+                fmt.setSamples(1);
+                m_fbo = new QOpenGLFramebufferObject(frameSize.width(), frameSize.height(), fmt); // GL_TEXTURE_2D);
+            }
+            m_fbo->bind();
+            glViewport(0, 0, frameSize.width(), frameSize.height());
 
-        QMatrix4x4 projection2;
-        projection2.scale(2.0f / width, 2.0f / height);
-        m_shader->setUniformValue(m_projectionLocation, projection2);
+            QMatrix4x4 projection2;
+            projection2.scale(2.0f / width, 2.0f / height);
+            m_shader->setUniformValue(m_projectionLocation, projection2);
 
-        glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
-        check_error(f);
-        m_fbo->release();
-        Q_EMIT analyseFrame(m_fbo->toImage());
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
+            check_error(f);
+            m_fbo->release();
+            Q_EMIT analyseFrame(m_fbo->toImage());
+        }
         m_sendFrame = false;
     }
     // Cleanup
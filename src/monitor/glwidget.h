@@ -90,6 +90,8 @@ public:
     QRect displayRect() const;
     /** @brief set to true if we want to emit a QImage of the frame for analysis */
     bool sendFrameForAnalysis;
+    /** @brief set to true if the next analysed frame must keep the profile size, for example when it is saved */
+    bool sendFullSizeFrame;
     /** @brief delete and rebuild consumer, for example when external display is switched */
     void resetConsumer(bool fullReset);
     void lockMonitor();
@@ -234,6 +236,8 @@ private:
     static void on_gl_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data);
     static void on_gl_nosync_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data);
     QOpenGLFramebufferObject *m_fbo;
+    /** @brief Size of the frames sent for analysis, the profile size reduced to the scopes analysis width */
+    QSize analysisSize() const;
     void refreshSceneLayout();
     void resetZoneMode();
     /** @brief Restart consumer, keeping preview scaling settings */
@@ -511,6 +511,8 @@ void Monitor::setOffsetY(int y)
 void Monitor::slotGetCurrentImage(bool request)
 {
     m_glMonitor->sendFrameForAnalysis = request;
+    // The requested frame is displayed, not only analysed, so it must not be downscaled for the scopes
+    m_glMonitor->sendFullSizeFrame = request;
     if (request) {
         slotActivateMonitor();
         refreshMonitor(true);
@@ -1241,6 +1243,7 @@ void Monitor::slotExtractCurrentFrame(QString frameName, bool addToProject)
                     disconnect(m_glMonitor, &GLWidget::analyseFrame, this, &Monitor::frameUpdated);
                     bool analysisStatus = m_glMonitor->sendFrameForAnalysis;
                     m_glMonitor->sendFrameForAnalysis = true;
+                    m_glMonitor->sendFullSizeFrame = true;
                     if (m_captureConnection) {
                         QObject::disconnect(m_captureConnection);
                     }
@@ -1248,6 +1251,7 @@ void Monitor::slotExtractCurrentFrame(QString frameName, bool addToProject)
                         connect(m_glMonitor, &GLWidget::analyseFrame, this,
                                 [this, proxiedClips, selectedFile, existingProxies, addToProject, analysisStatus, previewScale](const QImage &img) {
                                     m_glMonitor->sendFrameForAnalysis = analysisStatus;
+                                    m_glMonitor->sendFullSizeFrame = false;
                                     m_glMonitor->releaseAnalyse();
                                     if (pCore->getCurrentSar() != 1.) {
                                         QImage scaled = img.scaled(pCore->getCurrentFrameDisplaySize());
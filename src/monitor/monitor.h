@@ -338,7 +338,7 @@ public Q_SLOTS:
     void slotSwitchRec(bool enable);
     /** @brief Display or hide the trimming toolbar and monitor scene*/
     void slotSwitchTrimming(bool enable);
-    /** @brief Request QImage of current frame */
+    /** @brief Request QImage of current frame, at the full profile resolution */
     void slotGetCurrentImage(bool request);
     /** @brief Enable/disable display of monitor's audio levels widget */
     void slotSwitchAudioMonitor();
@@ -10,6 +10,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "core.h"
 #include "doc/kdenlivedoc.h"
 #include "kdenlivesettings.h"
+#include "utils/probecache.hpp"
+#include "utils/thumbnailcache.hpp"
 
 #include <KDiskFreeSpaceInfo>
 #include <KLocalizedString>
@@ -252,11 +254,8 @@ void TemporaryData::updateDataInfo()
         KIO::DirectorySizeJob *job = KIO::directorySize(QUrl::fromLocalFile(preview.absolutePath()));
         connect(job, &KIO::DirectorySizeJob::result, this, &TemporaryData::gotSequenceSize);
     }
-    preview = m_doc->getCacheDir(CacheThumbs, &ok);
-    if (ok) {
-        KIO::DirectorySizeJob *job = KIO::directorySize(QUrl::fromLocalFile(preview.absolutePath()));
-        connect(job, &KIO::DirectorySizeJob::result, this, &TemporaryData::gotThumbSize);
-    }
+    // Thumbnails are packed in one file per clip, no need to walk the folder
+    gotThumbSize(KIO::filesize_t(ThumbnailCache::get()->persistentCacheSize()));
     if (!m_currentProjectOnly) {
         updateGlobalInfo();
     }
@@ -299,13 +298,8 @@ void TemporaryData::gotAudioSize(KJob *job)
     updateTotal();
 }
 
-void TemporaryData::gotThumbSize(KJob *job)
+void TemporaryData::gotThumbSize(KIO::filesize_t total)
 {
-    auto *sourceJob = static_cast<KIO::DirectorySizeJob *>(job);
-    KIO::filesize_t total = sourceJob->totalSize();
-    if (sourceJob->totalFiles() == 0) {
-        total = 0;
-    }
     delThumb->setEnabled(total > 0);
     m_totalCurrent += total;
     m_currentSizes[3] = total;
@@ -410,6 +404,9 @@ void TemporaryData::cleanBackup()
 
 void TemporaryData::cleanCache()
 {
+    // The shared media information is cleaned by entry, the folder date does not reflect their use
+    QDateTime current = QDateTime::currentDateTime();
+    const bool prunedProbes = ProbeCache::get()->prune(current.addMonths(-KdenliveSettings::cleanCacheMonths())) > 0;
     // Find empty dirs
     QList<QTreeWidgetItem *> emptyDirs = listWidget->findItems(KIO::convertSize(0), Qt::MatchExactly, 2);
     // Find old dirs
@@ -419,11 +416,10 @@ void TemporaryData::cleanCache()
     }
     // Find old backup data ( older than x months ), or very small (that can be quickly recreated)
     size_t total = 0;
-    QDateTime current = QDateTime::currentDateTime();
     int max = root->childCount();
     for (int i = 0; i < max; i++) {
         QTreeWidgetItem *child = root->child(i);
-        if (emptyDirs.contains(child)) {
+        if (emptyDirs.contains(child) || child->data(0, Qt::UserRole).toString() == QLatin1String("probes")) {
             continue;
         }
         size_t childSize = size_t(child->data(1, Qt::UserRole).toLongLong());
@@ -438,7 +434,11 @@ void TemporaryData::cleanCache()
         folders << item->data(0, Qt::UserRole).toString();
     }
     if (folders.isEmpty()) {
-        KMessageBox::information(this, i18n("No cache data older than %1 months was found.", KdenliveSettings::cleanCacheMonths()));
+        if (prunedProbes) {
+            updateGlobalInfo();
+        } else {
+            KMessageBox::information(this, i18n("No cache data older than %1 months was found.", KdenliveSettings::cleanCacheMonths()));
+        }
         return;
     }
 
@@ -447,6 +447,9 @@ void TemporaryData::cleanCache()
                                                     "%2 months. All cached data can be recreated from the source files on project opening.",
                                                     KIO::convertSize(total), KdenliveSettings::cleanCacheMonths()),
                                                folders) != KMessageBox::Continue) {
+        if (prunedProbes) {
+            updateGlobalInfo();
+        }
         return;
     }
     deleteCache(folders);
@@ -511,6 +514,8 @@ void TemporaryData::deleteThumbs()
         return;
     }
     if (dir.dirName() == QLatin1String("videothumbs")) {
+        // Close the opened thumbnail packs before deleting the folder
+        ThumbnailCache::get()->clearPersistentCache();
         dir.removeRecursively();
         dir.mkpath(QStringLiteral("."));
         updateDataInfo();
@@ -532,6 +537,7 @@ void TemporaryData::deleteCurrentCacheData(bool warn)
     if (dir.dirName() == m_doc->getDocumentProperty(QStringLiteral("documentid"))) {
         Q_EMIT disablePreview();
         Q_EMIT disableProxies();
+        ThumbnailCache::get()->clearPersistentCache();
         dir.removeRecursively();
         m_doc->initCacheDirs();
         if (warn) {
@@ -648,6 +654,8 @@ void TemporaryData::gotFolderSize(KJob *job)
         } else {
             item->setIcon(0, QIcon::fromTheme(QStringLiteral("dialog-close")));
         }
+    } else if (m_processingDirectory == QLatin1String("probes")) {
+        item->setText(0, i18n("%1 (media information shared by all projects)", m_processingDirectory));
     } else {
         item->setText(0, m_processingDirectory);
         if (m_processingDirectory == QLatin1String("proxy")) {
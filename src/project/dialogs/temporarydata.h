@@ -112,7 +112,7 @@ private Q_SLOTS:
     void gotProxySize(KIO::filesize_t total);
     void gotAudioSize(KJob *job);
     void gotSequenceSize(KJob *job);
-    void gotThumbSize(KJob *job);
+    void gotThumbSize(KIO::filesize_t total);
     void gotFolderSize(KJob *job);
     void gotBackupSize(KJob *job);
     void gotProjectProxySize(KJob *job);
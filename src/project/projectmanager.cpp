@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "jobs/clipprobetask.h"
 #include "kdenlivesettings.h"
 #include "mainwindow.h"
 #include "monitor/monitormanager.h"
@@ -358,6 +359,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 {
     // Disable autosave
     m_autoSaveTimer.stop();
+    m_autoSavePending = false;
     if ((m_project != nullptr) && m_project->isModified() && saveChanges) {
         QString message;
         if (m_project->url().fileName().isEmpty()) {
@@ -412,6 +414,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 bool ProjectManager::saveFileAs(const QString &outputFileName, bool saveACopy)
 {
     pCore->monitorManager()->pauseActiveMonitor();
+    m_project->waitForAutoSave();
     QString oldProjectFolder =
         m_project->url().isEmpty() ? QString() : QFileInfo(m_project->url().toLocalFile()).absolutePath() + QStringLiteral("/cachefiles");
     // this was the old project folder in case the "save in project file location" setting was active
@@ -553,6 +556,7 @@ bool ProjectManager::saveFile()
         return saveFileAs();
     }
     bool result = saveFileAs(m_project->url().toLocalFile());
+    m_project->waitForAutoSave();
     m_project->m_autosave->resize(0);
     return result;
 }
@@ -697,6 +701,8 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
     }
     m_notesPlugin->clear();
 
+    QElapsedTimer loadTimer;
+    loadTimer.start();
     DocOpenResult openResult = KdenliveDoc::Open(stale ? QUrl::fromLocalFile(stale->fileName()) : url,
         QString(), pCore->window()->m_commandStack, false, pCore->window());
 
@@ -789,6 +795,7 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
         newFile(false);
         return;
     }
+    qCDebug(KDENLIVE_LOG) << "// project timeline ready in" << loadTimer.elapsed() << "ms";
 
     // Re-open active timelines
     QStringList openedTimelines = m_project->getDocumentProperty(QStringLiteral("opensequences")).split(QLatin1Char(';'), Qt::SkipEmptyParts);
@@ -896,6 +903,7 @@ KRecentFilesAction *ProjectManager::recentFilesAction()
 
 void ProjectManager::slotStartAutoSave()
 {
+    m_autoSavePending = true;
     if (m_lastSave.elapsed() > 300000) {
         // If the project was not saved in the last 5 minute, force save
         m_autoSaveTimer.stop();
@@ -907,22 +915,21 @@ void ProjectManager::slotStartAutoSave()
 
 void ProjectManager::slotAutoSave()
 {
-    prepareSave();
-    QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
-    QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
+    if (m_project->isAutoSaving()) {
+        // The previous backup is still being written, don't wait for it
+        m_autoSaveTimer.start(3000);
+        return;
     }
-    if (!scene.contains(QLatin1String("<track "))) {
-        // In some unexplained cases, the MLT playlist is corrupted and all tracks are deleted. Don't save in that case.
-        pCore->displayMessage(i18n("Project was corrupted, cannot backup. Please close and reopen your project file to recover last backup"), ErrorMessage);
+    if (!m_autoSavePending) {
+        // The timer is also restarted after loading a sequence, don't serialize an unchanged project
         return;
     }
-    m_project->slotAutoSave(scene);
+    m_autoSavePending = false;
+    prepareSave();
+    QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
+    // Only the serialization blocks the GUI thread, see the method documentation
+    QString scene = projectSceneList(saveFolder);
+    m_project->slotAutoSave(scene, m_replacementPattern);
     m_lastSave.start();
 }
 
@@ -1185,7 +1192,10 @@ bool ProjectManager::updateTimeline(int pos, bool createNewTab, const QString &c
 {
     pCore->taskManager.slotCancelJobs();
     const QUuid uuid = m_project->uuid();
+    QElapsedTimer timer;
+    timer.start();
     std::unique_ptr<Mlt::Producer> xmlProd(new Mlt::Producer(*pCore->getProjectProfile(), "xml-string", m_project->getAndClearProjectXml().constData()));
+    qCDebug(KDENLIVE_LOG) << "// MLT playlist loaded in" << timer.restart() << "ms";
     Mlt::Service s(*xmlProd.get());
     Mlt::Tractor tractor(s);
     if (xmlProd->property_exists("kdenlive:projectTractor")) {
@@ -1193,7 +1203,12 @@ bool ProjectManager::updateTimeline(int pos, bool createNewTab, const QString &c
         m_project->cleanupTimelinePreview(documentDate);
         pCore->projectItemModel()->buildPlaylist(uuid);
         // Load bin playlist
-        return loadProjectBin(pCore->projectItemModel(), tractor, m_progressDialog);
+        bool result = loadProjectBin(pCore->projectItemModel(), tractor, m_progressDialog);
+        qCDebug(KDENLIVE_LOG) << "// project bin and timelines built in" << timer.elapsed() << "ms";
+        if (result) {
+            probeLoadedClips();
+        }
+        return result;
     }
     if (tractor.count() == 0) {
         // Wow we have a project file with empty tractor, probably corrupted, propose to open a recovery file
@@ -1238,6 +1253,8 @@ bool ProjectManager::updateTimeline(int pos, bool createNewTab, const QString &c
         requestBackup(i18n("Project file is corrupted - failed to load tracks. Try to find a backup file?"));
         return false;
     }
+    qCDebug(KDENLIVE_LOG) << "// project bin and timeline built in" << timer.elapsed() << "ms";
+    probeLoadedClips();
     // Free memory used by original playlist
     xmlProd->clear();
     xmlProd.reset(nullptr);
@@ -1322,6 +1339,30 @@ bool ProjectManager::updateTimeline(int pos, bool createNewTab, const QString &c
     return true;
 }
 
+void ProjectManager::probeLoadedClips()
+{
+    const QStringList ids = m_project->takeUnprobedClips();
+    if (ids.isEmpty()) {
+        return;
+    }
+    // The probe tasks run in parallel on the task pool, log when the last one is done
+    auto remaining = std::make_shared<int>(ids.size());
+    auto timer = std::make_shared<QElapsedTimer>();
+    timer->start();
+    for (const QString &id : ids) {
+        std::shared_ptr<ProjectClip> clip = pCore->projectItemModel()->getClipByBinID(id);
+        if (!clip) {
+            (*remaining)--;
+            continue;
+        }
+        ClipProbeTask::start({ObjectType::BinClip, id.toInt()}, clip.get(), [remaining, timer, count = ids.size()]() {
+            if (--(*remaining) == 0) {
+                qCDebug(KDENLIVE_LOG) << "// media of" << count << "clips probed in" << timer->elapsed() << "ms";
+            }
+        });
+    }
+}
+
 void ProjectManager::adjustProjectDuration(int duration)
 {
     pCore->monitorManager()->projectMonitor()->adjustRulerSize(duration - 1, nullptr);
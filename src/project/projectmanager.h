@@ -210,7 +210,9 @@ private Q_SLOTS:
     void slotRevert();
     /** @brief Open the project's backupdialog. */
     bool slotOpenBackup(const QUrl &url = QUrl());
-    /** @brief Start autosaving the document. */
+    /** @brief Start autosaving the document if it was modified since the last autosave.
+     *  The scene is serialized in the GUI thread, since the timeline tractor and the bin playlist are only modified there
+     *  and MLT cannot clone them without serializing them. Only the path replacements and the file write run in the background. */
     void slotAutoSave();
     /** @brief Report progress of folder move operation. */
     void slotMoveProgress(KJob *, unsigned long progress);
@@ -231,6 +233,8 @@ private:
     std::shared_ptr<TimelineItemModel> m_activeTimelineModel;
     QElapsedTimer m_lastSave;
     QTimer m_autoSaveTimer;
+    /** @brief The document was modified since the last autosave */
+    bool m_autoSavePending{false};
     QUrl m_startUrl;
     QString m_loadClipsOnOpen;
     QMap<QString, QString> m_replacementPattern;
@@ -244,4 +248,6 @@ private:
     void saveRecentFiles();
     /** @brief Project loading failed, ask user if he wants to open a backup */
     void requestBackup(const QString &errorMessage);
+    /** @brief Check in background tasks the media of the clips that were loaded from their stored metadata */
+    void probeLoadedClips();
 };
@@ -18,6 +18,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 AbstractGfxScopeWidget::AbstractGfxScopeWidget(bool trackMouse, QWidget *parent)
     : AbstractScopeWidget(trackMouse, parent)
+    , m_analysis(std::make_shared<const ScopeAnalysis>())
 {
 }
 
@@ -26,7 +27,14 @@ AbstractGfxScopeWidget::~AbstractGfxScopeWidget() = default;
 QImage AbstractGfxScopeWidget::renderScope(uint accelerationFactor)
 {
     QMutexLocker lock(&m_mutex);
-    return renderGfxScope(accelerationFactor, m_scopeImage);
+    std::shared_ptr<const ScopeAnalysis> analysis = m_analysis;
+    lock.unlock();
+    if (!analysis->isEmpty() && !analysis->contains(requiredStatistics(), requiredChromaGeometry())) {
+        // The settings changed since the frame was analysed, ask for a new analysis.
+        // We are in the render thread, the request is handled by the scope manager in the GUI thread.
+        QMetaObject::invokeMethod(this, [this]() { Q_EMIT signalFrameRequest(widgetName()); }, Qt::QueuedConnection);
+    }
+    return renderGfxScope(accelerationFactor, *analysis);
 }
 
 void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
@@ -37,10 +45,11 @@ void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
 
 ///// Slots /////
 
-void AbstractGfxScopeWidget::slotRenderZoneUpdated(const QImage &frame)
+void AbstractGfxScopeWidget::slotRenderZoneUpdated(const std::shared_ptr<const ScopeAnalysis> &analysis)
 {
     QMutexLocker lock(&m_mutex);
-    m_scopeImage = frame;
+    m_analysis = analysis ? analysis : std::make_shared<const ScopeAnalysis>();
+    lock.unlock();
     AbstractScopeWidget::slotRenderZoneUpdated();
 }
 
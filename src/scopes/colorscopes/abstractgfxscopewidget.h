@@ -11,6 +11,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QWidget>
 
 #include "../abstractscopewidget.h"
+#include "scopeanalysis.h"
+
+#include <memory>
 
 /**
 * @brief Abstract class for scopes analyzing image frames.
@@ -23,27 +26,38 @@ public:
     explicit AbstractGfxScopeWidget(bool trackMouse = false, QWidget *parent = nullptr);
     ~AbstractGfxScopeWidget() override; // Must be virtual because of inheritance, to avoid memory leaks
 
+    /** @brief The frame statistics this scope needs with its current settings.
+     *  The scope manager collects the statistics of all open scopes in a single pass over the frame. */
+    virtual ScopeAnalysis::Statistics requiredStatistics() const = 0;
+    /** @brief Where the chroma samples have to be drawn, for scopes requiring the chroma statistics */
+    virtual ScopeAnalysis::ChromaGeometry requiredChromaGeometry() const { return ScopeAnalysis::ChromaGeometry(); }
+    /** @brief The acceleration factor hint of the scope renderer, the frame analysis reads only every n-th pixel */
+    uint accelFactor() const { return uint(qMax(1, m_accelFactorScope)); }
+
 protected:
     ///// Variables /////
 
     /** @brief Scope renderer. Must emit signalScopeRenderingFinished()
      *  when calculation has finished, to allow multi-threading.
-     *  accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible. */
-    virtual QImage renderGfxScope(uint accelerationFactor, const QImage &) = 0;
+     *  accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible.
+     *  The frame analysis is part of the calculation: its time has to be included in the reported time,
+     *  so that the acceleration factor given to the next analysis follows it. */
+    virtual QImage renderGfxScope(uint accelerationFactor, const ScopeAnalysis &) = 0;
 
     QImage renderScope(uint accelerationFactor) override;
 
     void mouseReleaseEvent(QMouseEvent *) override;
 
 private:
-    QImage m_scopeImage;
+    std::shared_ptr<const ScopeAnalysis> m_analysis;
     QMutex m_mutex;
 
 public Q_SLOTS:
-    /** @brief Must be called when the active monitor has shown a new frame.
+    /** @brief Must be called when the active monitor has shown a new frame, with the statistics
+     * of the frame shared by all scopes.
      * This slot must be connected in the implementing class, it is *not*
      * done in this abstract class. */
-    void slotRenderZoneUpdated(const QImage &);
+    void slotRenderZoneUpdated(const std::shared_ptr<const ScopeAnalysis> &analysis);
 
 protected Q_SLOTS:
     virtual void slotAutoRefreshToggled(bool autoRefresh);
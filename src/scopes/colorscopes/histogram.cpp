@@ -128,21 +128,28 @@ QImage Histogram::renderHUD(uint)
     Q_EMIT signalHUDRenderingFinished(0, 1);
     return QImage();
 }
-QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
+int Histogram::componentFlags() const
+{
+    return (m_ui->cbY->isChecked() ? 1 : 0) * HistogramGenerator::ComponentY | (m_ui->cbS->isChecked() ? 1 : 0) * HistogramGenerator::ComponentSum |
+           (m_ui->cbR->isChecked() ? 1 : 0) * HistogramGenerator::ComponentR | (m_ui->cbG->isChecked() ? 1 : 0) * HistogramGenerator::ComponentG |
+           (m_ui->cbB->isChecked() ? 1 : 0) * HistogramGenerator::ComponentB;
+}
+
+ScopeAnalysis::Statistics Histogram::requiredStatistics() const
+{
+    return HistogramGenerator::statistics(componentFlags(), m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709);
+}
+
+QImage Histogram::renderGfxScope(uint accelFactor, const ScopeAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
-    const int componentFlags =
-        (m_ui->cbY->isChecked() ? 1 : 0) * HistogramGenerator::ComponentY | (m_ui->cbS->isChecked() ? 1 : 0) * HistogramGenerator::ComponentSum |
-        (m_ui->cbR->isChecked() ? 1 : 0) * HistogramGenerator::ComponentR | (m_ui->cbG->isChecked() ? 1 : 0) * HistogramGenerator::ComponentG |
-        (m_ui->cbB->isChecked() ? 1 : 0) * HistogramGenerator::ComponentB;
-
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
 
-    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), qimage, componentFlags, rec, m_aUnscaled->isChecked(),
-                                                                m_ui->rbLogarithmic->isChecked(), accelFactor);
+    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), analysis, componentFlags(), rec, m_aUnscaled->isChecked(),
+                                                                m_ui->rbLogarithmic->isChecked());
 
-    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelFactor);
+    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()) + analysis.elapsed(), accelFactor);
     return histogram;
 }
 QImage Histogram::renderBackground(uint)
@@ -23,12 +23,15 @@ public:
     explicit Histogram(QWidget *parent = nullptr);
     ~Histogram() override;
     QString widgetName() const override;
+    ScopeAnalysis::Statistics requiredStatistics() const override;
 
 protected:
     void readConfig() override;
     void writeConfig();
 
 private:
+    /** @brief The HistogramGenerator::Components selected in the UI */
+    int componentFlags() const;
     HistogramGenerator *m_histogramGenerator;
     QAction *m_aUnscaled;
     QAction *m_aRec601;
@@ -40,7 +43,7 @@ private:
     bool isScopeDependingOnInput() const override;
     bool isBackgroundDependingOnInput() const override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const ScopeAnalysis &analysis) override;
     QImage renderBackground(uint accelerationFactor) override;
     Ui::Histogram_UI *m_ui;
 };
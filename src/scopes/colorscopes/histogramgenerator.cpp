@@ -19,7 +19,22 @@ HistogramGenerator::HistogramGenerator() = default;
 QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, ITURec rec, bool unscaled, bool logScale,
                                               uint accelFactor) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    return calculateHistogram(paradeSize, ScopeAnalysis(image, statistics(components, rec), accelFactor), components, rec, unscaled, logScale);
+}
+
+ScopeAnalysis::Statistics HistogramGenerator::statistics(int components, ITURec rec)
+{
+    ScopeAnalysis::Statistics result = ScopeAnalysis::RGBHistogram;
+    if ((components & HistogramGenerator::ComponentY) != 0) {
+        result |= ScopeAnalysis::lumaHistogram(rec);
+    }
+    return result;
+}
+
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const ScopeAnalysis &analysis, const int &components, ITURec rec, bool unscaled,
+                                              bool logScale) const
+{
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || analysis.isEmpty() || !analysis.contains(statistics(components, rec))) {
         return QImage();
     }
 
@@ -29,42 +44,17 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     bool drawB = (components & HistogramGenerator::ComponentB) != 0;
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
-    int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
-    std::fill(s, s + 766, 0);
-
     const int ww = paradeSize.width();
     const int wh = paradeSize.height();
 
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += accelFactor) {
-
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-
-            if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == ITURec::Rec_601) {
-                    y[int(REC_601_R * qRed(col) + REC_601_G * qGreen(col) + REC_601_B * qBlue(col))]++;
-                } else {
-                    y[int(REC_709_R * qRed(col) + REC_709_G * qGreen(col) + REC_709_B * qBlue(col))]++;
-                }
-            }
-
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
-        }
+    const int *r = analysis.histogram(ScopeAnalysis::Red);
+    const int *g = analysis.histogram(ScopeAnalysis::Green);
+    const int *b = analysis.histogram(ScopeAnalysis::Blue);
+    const int *y = drawY ? analysis.lumaHistogram(rec) : nullptr;
+    // Each sample adds its 3 components to the sum
+    int s[256];
+    for (int i = 0; i < 256; ++i) {
+        s[i] = r[i] + g[i] + b[i];
     }
 
     const int nParts = (drawY ? 1 : 0) + (drawR ? 1 : 0) + (drawG ? 1 : 0) + (drawB ? 1 : 0) + (drawSum ? 1 : 0);
@@ -80,7 +70,7 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     const int partH = (wh - nParts * d) / nParts;
 
     // Total number of bytes of the image
-    const int byteCount = int(image.sizeInBytes());
+    const int byteCount = int(analysis.bytesPerLine() * analysis.height());
 
     // Factor for scaling the measured value to the histogram.
     // This factor is used for linear scaling and does not depend
@@ -146,6 +136,7 @@ QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const
     Q_ASSERT(scaling != INFINITY);
 
     const int partH = size.height();
+    const QRgb rgba = color.rgba();
 
     const int maxBinSize = *std::max_element(&y[0], &y[max - 1]);
     const float logScaling = float(size.height()) / log10f(float(maxBinSize + 1));
@@ -167,7 +158,7 @@ QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const
         partY = partH - 1 - partY;
 
         for (int k = partH - 1; k >= partY; --k) {
-            component.setPixel(x, k, color.rgba());
+            reinterpret_cast<QRgb *>(component.scanLine(k))[x] = rgba;
         }
     }
     if (unscaled && size.width() >= component.width()) {
@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include "scopeanalysis.h"
 
 class QColor;
 class QImage;
@@ -36,6 +37,11 @@ public:
     QImage calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, const ITURec rec, bool unscaled,
                               bool logScale,
                               uint accelFactor = 1) const;
+    /** @brief Calculates the histogram display from the statistics of a shared frame analysis */
+    QImage calculateHistogram(const QSize &paradeSize, const ScopeAnalysis &analysis, const int &components, const ITURec rec, bool unscaled,
+                              bool logScale) const;
+    /** @brief The statistics needed to draw the histogram of @p components */
+    static ScopeAnalysis::Statistics statistics(int components, ITURec rec);
 
     /**
      * Draws the histogram of a single component.
@@ -132,15 +132,20 @@ QImage RGBParade::renderHUD(uint)
     return hud;
 }
 
-QImage RGBParade::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+ScopeAnalysis::Statistics RGBParade::requiredStatistics() const
+{
+    return RGBParadeGenerator::statistics();
+}
+
+QImage RGBParade::renderGfxScope(uint accelerationFactor, const ScopeAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
 
     int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), qimage, RGBParadeGenerator::PaintMode(paintmode), m_aAxis->isChecked(),
-                                                             m_aGradRef->isChecked(), accelerationFactor);
-    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
+    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), analysis, RGBParadeGenerator::PaintMode(paintmode), m_aAxis->isChecked(),
+                                                             m_aGradRef->isChecked());
+    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()) + analysis.elapsed(), accelerationFactor);
     return parade;
 }
 
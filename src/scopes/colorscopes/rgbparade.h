@@ -24,6 +24,7 @@ public:
     explicit RGBParade(QWidget *parent = nullptr);
     ~RGBParade() override;
     QString widgetName() const override;
+    ScopeAnalysis::Statistics requiredStatistics() const override;
 
 protected:
     void readConfig() override;
@@ -42,6 +43,6 @@ private:
     bool isBackgroundDependingOnInput() const override;
 
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const ScopeAnalysis &analysis) override;
     QImage renderBackground(uint accelerationFactor) override;
 };
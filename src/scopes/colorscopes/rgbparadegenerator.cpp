@@ -34,8 +34,18 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
                                               bool drawGradientRef, uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
+    return calculateRGBParade(paradeSize, ScopeAnalysis(image, statistics(), accelFactor), paintMode, drawAxis, drawGradientRef);
+}
+
+ScopeAnalysis::Statistics RGBParadeGenerator::statistics()
+{
+    return ScopeAnalysis::RGBColumns | ScopeAnalysis::RGBHistogram;
+}
 
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const ScopeAnalysis &analysis, const RGBParadeGenerator::PaintMode paintMode,
+                                              bool drawAxis, bool drawGradientRef)
+{
+    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || analysis.isEmpty() || !analysis.contains(statistics())) {
         return QImage();
     }
     QImage parade(paradeSize, QImage::Format_ARGB32);
@@ -50,8 +60,8 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const uint ww = uint(paradeSize.width());
     const uint wh = uint(paradeSize.height());
-    const uint iw = uint(image.width());
-    const uint ih = uint(image.height());
+    const uint iw = uint(analysis.width());
+    const uint ih = uint(analysis.height());
 
     const uchar offset = 10;
     const uint partW = (ww - 2 * offset - distRight) / 3;
@@ -59,10 +69,21 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     // Statistics
     uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    auto range = [](const int *histogram, uchar &min, uchar &max) {
+        for (int v = 0; v < 256; ++v) {
+            if (histogram[v] > 0) {
+                min = qMin(min, uchar(v));
+                max = qMax(max, uchar(v));
+            }
+        }
+    };
+    range(analysis.histogram(ScopeAnalysis::Red), minR, maxR);
+    range(analysis.histogram(ScopeAnalysis::Green), minG, maxG);
+    range(analysis.histogram(ScopeAnalysis::Blue), minB, maxB);
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = float((iw * ih) / accelFactor) / (partW * 255);
+    const float pixelDepth = float((iw * ih) / analysis.accelFactor()) / (partW * 255);
     const float gain = 255 / (8 * pixelDepth);
     //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
@@ -71,63 +92,47 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const float wPrediv = float(partW - 1) / (iw - 1);
 
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const auto x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
-        auto r = uchar(qRed(pixel));
-        auto g = uchar(qGreen(pixel));
-        auto b = uchar(qBlue(pixel));
-
-        double dx = x * double(wPrediv);
-
-        paradeVals[size_t(dx)][r].r++;
-        paradeVals[size_t(dx)][g].g++;
-        paradeVals[size_t(dx)][b].b++;
-
-        if (r < minR) {
-            minR = r;
-        }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
+    // Sum the distributions of the image columns falling on each scope column, value j of column i at index 256 * i + j
+    std::vector<StructRGB> paradeVals(size_t(partW) * 256, {0, 0, 0});
+    const uint *red = analysis.columns(ScopeAnalysis::Red);
+    const uint *green = analysis.columns(ScopeAnalysis::Green);
+    const uint *blue = analysis.columns(ScopeAnalysis::Blue);
+    for (uint x = 0; x < iw; ++x) {
+        StructRGB *column = paradeVals.data() + size_t(x * double(wPrediv)) * 256;
+        const size_t source = size_t(x) * 256;
+        for (size_t v = 0; v < 256; ++v) {
+            column[v].r += red[source + v];
+            column[v].g += green[source + v];
+            column[v].b += blue[source + v];
         }
     }
 
+    // The alpha value only depends on the number of hits, compute it once for each count
+    // up to the saturation limit.
+    uint maxValue = 0;
+    for (const StructRGB &value : paradeVals) {
+        maxValue = qMax(maxValue, qMax(value.r, qMax(value.g, value.b)));
+    }
+    const uint tableSize = uint(qMin(double(maxValue), qMax(0., 256. / double(gain)))) + 2;
+    std::vector<int> alpha(tableSize);
+    for (uint count = 0; count < tableSize; ++count) {
+        alpha[count] = CHOP255(gain * float(count));
+    }
+    auto alphaFor = [&](uint count) { return count < tableSize ? alpha[count] : alpha.back(); };
+
     const int offset1 = int(partW + offset);
     const int offset2 = int(2 * partW + 2 * offset);
-    switch (paintMode) {
-    case PaintMode_RGB:
+    const QRgb colorR = paintMode == PaintMode_RGB ? qRgb(255, 10, 10) : qRgb(255, 255, 255);
+    const QRgb colorG = paintMode == PaintMode_RGB ? qRgb(10, 255, 10) : qRgb(255, 255, 255);
+    const QRgb colorB = paintMode == PaintMode_RGB ? qRgb(10, 10, 255) : qRgb(255, 255, 255);
+    for (int j = 0; j < 256; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(unscaled.scanLine(j));
         for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
-        }
-        break;
-    default:
-        for (int i = 0; i < int(partW); ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].r))));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].g))));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * float(paradeVals[size_t(i)][size_t(j)].b))));
-            }
+            const StructRGB &value = paradeVals[size_t(i) * 256 + size_t(j)];
+            line[i] = (colorR & 0x00ffffff) | (uint(alphaFor(value.r)) << 24);
+            line[i + offset1] = (colorG & 0x00ffffff) | (uint(alphaFor(value.g)) << 24);
+            line[i + offset2] = (colorB & 0x00ffffff) | (uint(alphaFor(value.b)) << 24);
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
@@ -139,9 +144,10 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
         QRgb opx;
         for (int i = 0; i <= 10; ++i) {
             int dy = i * int(partH - 1) / 10;
+            auto *line = reinterpret_cast<QRgb *>(parade.scanLine(dy));
             for (int x = 0; x < int(ww - distRight); ++x) {
-                opx = parade.pixel(x, dy);
-                parade.setPixel(x, dy, qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx))));
+                opx = line[x];
+                line[x] = qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx)));
             }
         }
     }
@@ -7,6 +7,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include "scopeanalysis.h"
+
 #include <QObject>
 
 class QColor;
@@ -21,6 +23,11 @@ public:
     RGBParadeGenerator();
     QImage calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis, bool drawGradientRef,
                               uint accelFactor = 1);
+    /** @brief Draw the parade from the component distributions of each column of a shared frame analysis */
+    QImage calculateRGBParade(const QSize &paradeSize, const ScopeAnalysis &analysis, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
+                              bool drawGradientRef);
+    /** @brief The statistics needed to draw the parade */
+    static ScopeAnalysis::Statistics statistics();
 
     static const QColor colHighlight;
     static const QColor colLight;
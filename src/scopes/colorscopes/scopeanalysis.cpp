@@ -0,0 +1,257 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "scopeanalysis.h"
+#include "scopebands.h"
+
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+
+constexpr double ScopeAnalysis::ChromaScaling;
+
+namespace {
+/** @brief Consecutive samples drawn on the same vectorscope pixel, flushed at once to the shared buffer */
+struct ChromaRun
+{
+    size_t index{0};
+    uint count{0};
+    QRgb color{0};
+};
+
+/** @brief Statistics of a column band that have to be merged with the other bands */
+struct BandStatistics
+{
+    std::vector<int> histograms[3];
+    std::vector<int> luma601;
+    std::vector<int> luma709;
+    ChromaRun runYUV;
+    ChromaRun runYPbPr;
+};
+
+/** @brief Vectorscope pixels shared by all the bands */
+struct ChromaBuffer
+{
+    std::unique_ptr<std::atomic<uint>[]> hits;
+    std::unique_ptr<std::atomic<QRgb>[]> colors;
+
+    void allocate(size_t size, bool withColors)
+    {
+        // Value initialization sets the atomics to 0
+        hits.reset(new std::atomic<uint>[size]());
+        if (withColors) {
+            colors.reset(new std::atomic<QRgb>[size]());
+        }
+    }
+    /** @brief Draws a sample, only touching the shared buffer when the sample falls on another pixel than the previous one */
+    void draw(ChromaRun &run, size_t index, QRgb color)
+    {
+        if (run.count > 0 && run.index != index) {
+            flush(run);
+        }
+        run.index = index;
+        run.count++;
+        run.color = color;
+    }
+    void flush(ChromaRun &run)
+    {
+        if (run.count == 0) {
+            return;
+        }
+        hits[run.index].fetch_add(run.count, std::memory_order_relaxed);
+        if (colors) {
+            colors[run.index].store(run.color, std::memory_order_relaxed);
+        }
+        run.count = 0;
+    }
+};
+
+template <typename T> std::vector<T> takeValues(const std::unique_ptr<std::atomic<T>[]> &buffer, size_t size)
+{
+    std::vector<T> values;
+    if (buffer) {
+        values.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            values.push_back(buffer[i].load(std::memory_order_relaxed));
+        }
+    }
+    return values;
+}
+
+inline int lumaBin(float luma)
+{
+    return qMin(255, int(luma));
+}
+} // namespace
+
+ScopeAnalysis::ScopeAnalysis(const QImage &image, Statistics statistics, uint accelFactor, const ChromaGeometry &chroma)
+    : m_statistics(statistics)
+    , m_size(image.size())
+    , m_accelFactor(qMax(1u, accelFactor))
+    , m_chroma(chroma)
+    , m_depth(image.depth())
+    , m_bytesPerLine(image.bytesPerLine())
+{
+    if (image.isNull() || m_size.isEmpty()) {
+        m_size = QSize();
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    const QImage input = ScopeBands::rgb32(image);
+    const int iw = input.width();
+    const int ih = input.height();
+    const uint accel = m_accelFactor;
+
+    const bool rgbHistogram = statistics & RGBHistogram;
+    const bool luma601 = statistics & LumaHistogram601;
+    const bool luma709 = statistics & LumaHistogram709;
+    const bool rgbColumns = statistics & RGBColumns;
+    const bool lumaColumns601 = statistics & LumaColumns601;
+    const bool lumaColumns709 = statistics & LumaColumns709;
+    const int side = qMax(0, chroma.side());
+    const bool yuv = (statistics & ChromaYUV) && side > 0;
+    const bool yPbPr = (statistics & ChromaYPbPr) && side > 0;
+    const bool colors = statistics & ChromaColors;
+    const size_t chromaSize = size_t(side) * size_t(side);
+    const double chromaGain = ChromaScaling * double(chroma.gain);
+
+    // Column distributions are written in place, each band owning its columns
+    const size_t columnsSize = size_t(iw) * 256;
+    if (rgbColumns) {
+        for (auto &column : m_columns) {
+            column.assign(columnsSize, 0);
+        }
+    }
+    if (lumaColumns601) {
+        m_lumaColumns601.assign(columnsSize, 0);
+    }
+    if (lumaColumns709) {
+        m_lumaColumns709.assign(columnsSize, 0);
+    }
+    // The vectorscope pixels are shared by all the bands
+    ChromaBuffer bufferYUV;
+    ChromaBuffer bufferYPbPr;
+    if (yuv) {
+        bufferYUV.allocate(chromaSize, colors);
+    }
+    if (yPbPr) {
+        bufferYPbPr.allocate(chromaSize, colors);
+    }
+    auto drawChroma = [&](ChromaBuffer &buffer, ChromaRun &run, double u, double v, QRgb pixel) {
+        const QPoint pt = mapToCircle(chroma.size, QPointF(chromaGain * u, chromaGain * v));
+        if (pt.x() >= side || pt.x() < 0 || pt.y() >= side || pt.y() < 0) {
+            // Sample lies outside (because of scaling), don't plot it
+            return;
+        }
+        buffer.draw(run, size_t(pt.y()) * size_t(side) + size_t(pt.x()), pixel);
+    };
+
+    auto init = [&]() {
+        BandStatistics band;
+        if (rgbHistogram) {
+            for (auto &histogram : band.histograms) {
+                histogram.assign(256, 0);
+            }
+        }
+        if (luma601) {
+            band.luma601.assign(256, 0);
+        }
+        if (luma709) {
+            band.luma709.assign(256, 0);
+        }
+        return band;
+    };
+    auto process = [&](BandStatistics &band, int firstColumn, int lastColumn) {
+        for (int y = 0; y < ih; ++y) {
+            const auto *line = reinterpret_cast<const QRgb *>(input.constScanLine(y));
+            int x = ScopeBands::firstSample(y, iw, accel);
+            if (x < firstColumn) {
+                x += int((uint(firstColumn - x) + accel - 1) / accel * accel);
+            }
+            for (; x < lastColumn; x += int(accel)) {
+                const QRgb pixel = line[x];
+                const int r = qRed(pixel);
+                const int g = qGreen(pixel);
+                const int b = qBlue(pixel);
+                const size_t column = size_t(x) * 256;
+                if (rgbHistogram) {
+                    band.histograms[Red][r]++;
+                    band.histograms[Green][g]++;
+                    band.histograms[Blue][b]++;
+                }
+                if (rgbColumns) {
+                    m_columns[Red][column + size_t(r)]++;
+                    m_columns[Green][column + size_t(g)]++;
+                    m_columns[Blue][column + size_t(b)]++;
+                }
+                if (luma601 || lumaColumns601) {
+                    const int luma = lumaBin(REC_601_R * r + REC_601_G * g + REC_601_B * b);
+                    if (luma601) {
+                        band.luma601[luma]++;
+                    }
+                    if (lumaColumns601) {
+                        m_lumaColumns601[column + size_t(luma)]++;
+                    }
+                }
+                if (luma709 || lumaColumns709) {
+                    const int luma = lumaBin(REC_709_R * r + REC_709_G * g + REC_709_B * b);
+                    if (luma709) {
+                        band.luma709[luma]++;
+                    }
+                    if (lumaColumns709) {
+                        m_lumaColumns709[column + size_t(luma)]++;
+                    }
+                }
+                if (yuv) {
+                    const double u = -0.0005781 * r - 0.001135 * g + 0.001713 * b;
+                    const double v = 0.002411 * r - 0.002019 * g - 0.0003921 * b;
+                    drawChroma(bufferYUV, band.runYUV, u, v, pixel);
+                }
+                if (yPbPr) {
+                    const double u = -0.0006671 * r - 0.001299 * g + 0.0019608 * b;
+                    const double v = 0.001961 * r - 0.001642 * g - 0.0003189 * b;
+                    drawChroma(bufferYPbPr, band.runYPbPr, u, v, pixel);
+                }
+            }
+        }
+        if (yuv) {
+            bufferYUV.flush(band.runYUV);
+        }
+        if (yPbPr) {
+            bufferYPbPr.flush(band.runYPbPr);
+        }
+    };
+    std::vector<BandStatistics> bands = ScopeBands::accumulate(iw, 64, 16, init, process);
+
+    // Merge the histograms in the first band
+    BandStatistics &total = bands.front();
+    for (size_t i = 1; i < bands.size(); ++i) {
+        const BandStatistics &band = bands[i];
+        for (int channel = 0; channel < 3 && rgbHistogram; ++channel) {
+            for (int v = 0; v < 256; ++v) {
+                total.histograms[channel][size_t(v)] += band.histograms[channel][size_t(v)];
+            }
+        }
+        for (int v = 0; v < 256; ++v) {
+            if (luma601) {
+                total.luma601[size_t(v)] += band.luma601[size_t(v)];
+            }
+            if (luma709) {
+                total.luma709[size_t(v)] += band.luma709[size_t(v)];
+            }
+        }
+    }
+    for (int channel = 0; channel < 3; ++channel) {
+        m_histograms[channel] = std::move(total.histograms[channel]);
+    }
+    m_luma601 = std::move(total.luma601);
+    m_luma709 = std::move(total.luma709);
+    m_chromaYUV = takeValues(bufferYUV.hits, chromaSize);
+    m_chromaYPbPr = takeValues(bufferYPbPr.hits, chromaSize);
+    m_colorsYUV = takeValues(bufferYUV.colors, chromaSize);
+    m_colorsYPbPr = takeValues(bufferYPbPr.colors, chromaSize);
+    m_elapsed = uint(timer.elapsed());
+}
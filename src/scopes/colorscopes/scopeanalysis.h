@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "colorconstants.h"
+
+#include <QFlags>
+#include <QImage>
+#include <QPoint>
+#include <QPointF>
+#include <QSize>
+#include <vector>
+
+/** @class ScopeAnalysis
+    @brief Statistics of a monitor frame shared by all the color scopes.
+
+    The frame is read once, in a single pass split in column bands processed in parallel,
+    and only the statistics requested by the open scopes are collected:
+    - 256 bin histograms of the red, green and blue components and of the luma (Rec. 601 or 709),
+    - per image column distributions of the components and of the luma, used by the waveform and RGB parade,
+    - the number of samples drawn on each vectorscope pixel for YUV or YPbPr, used by the vectorscope.
+      The chroma samples are accumulated directly at the display resolution of the vectorscope,
+      in a buffer shared by all the bands, so its size and gain are part of the analysis request.
+
+    Scopes then render from these statistics, so that their cost does not depend on the frame size anymore.
+ */
+class ScopeAnalysis
+{
+public:
+    enum Statistic {
+        RGBHistogram = 1 << 0,
+        LumaHistogram601 = 1 << 1,
+        LumaHistogram709 = 1 << 2,
+        RGBColumns = 1 << 3,
+        LumaColumns601 = 1 << 4,
+        LumaColumns709 = 1 << 5,
+        ChromaYUV = 1 << 6,
+        ChromaYPbPr = 1 << 7,
+        /** Also keep the color of a sample for each chroma cell */
+        ChromaColors = 1 << 8
+    };
+    Q_DECLARE_FLAGS(Statistics, Statistic)
+
+    enum Channel { Red = 0, Green = 1, Blue = 2 };
+
+    /** @brief Scaling of the U and V values on the vectorscope circle.
+        The maximum distance from the center for any RGB color is 0.63, so no need to make the circle bigger than required. */
+    static constexpr double ChromaScaling = 1 / .7;
+
+    /** @brief Where the chroma samples are drawn on the vectorscope */
+    struct ChromaGeometry
+    {
+        /** Size of the vectorscope, the samples are drawn in a square with the smallest side */
+        QSize size;
+        float gain{1.f};
+
+        bool operator==(const ChromaGeometry &other) const { return size == other.size && qFuzzyCompare(gain, other.gain); }
+        bool operator!=(const ChromaGeometry &other) const { return !(*this == other); }
+        /** @brief Side of the square holding the chroma samples */
+        int side() const { return qMin(size.width(), size.height()); }
+    };
+
+    /** @brief An empty analysis, scopes render nothing from it */
+    ScopeAnalysis() = default;
+    /** @brief Collect @p statistics from the image
+        @param accelFactor only every accelFactor-th pixel of the image is read
+        @param chroma where the chroma samples are drawn, used for the ChromaYUV and ChromaYPbPr statistics */
+    ScopeAnalysis(const QImage &image, Statistics statistics, uint accelFactor = 1, const ChromaGeometry &chroma = ChromaGeometry());
+
+    bool isEmpty() const { return m_size.isEmpty(); }
+    /** @brief Returns true if all the @p required statistics were collected */
+    bool contains(Statistics required) const { return (m_statistics & required) == required; }
+    /** @brief Returns true if all the @p required statistics were collected, with the chroma samples drawn at @p chroma */
+    bool contains(Statistics required, const ChromaGeometry &chroma) const { return contains(required) && (!hasChroma(required) || m_chroma == chroma); }
+    Statistics statistics() const { return m_statistics; }
+    /** @brief Time taken to collect the statistics, in milliseconds */
+    uint elapsed() const { return m_elapsed; }
+
+    /** @brief Size of the analysed frame */
+    QSize size() const { return m_size; }
+    int width() const { return m_size.width(); }
+    int height() const { return m_size.height(); }
+    uint accelFactor() const { return m_accelFactor; }
+    /** @brief Bit depth and bytes per line of the analysed frame, used by scopes to estimate the sample density */
+    int depth() const { return m_depth; }
+    qint64 bytesPerLine() const { return m_bytesPerLine; }
+
+    /** @brief 256 bins histogram of a component */
+    const int *histogram(Channel channel) const { return m_histograms[channel].data(); }
+    /** @brief 256 bins luma histogram */
+    const int *lumaHistogram(ITURec rec) const { return (rec == ITURec::Rec_601 ? m_luma601 : m_luma709).data(); }
+    /** @brief Distribution of a component in each image column, value v of column x at index 256 * x + v */
+    const uint *columns(Channel channel) const { return m_columns[channel].data(); }
+    /** @brief Distribution of the luma in each image column, value v of column x at index 256 * x + v */
+    const uint *lumaColumns(ITURec rec) const { return (rec == ITURec::Rec_601 ? m_lumaColumns601 : m_lumaColumns709).data(); }
+    /** @brief Where the chroma samples were drawn */
+    const ChromaGeometry &chromaGeometry() const { return m_chroma; }
+    /** @brief Number of samples drawn on each vectorscope pixel, pixel (x, y) at index side * y + x */
+    const uint *chromaHits(bool yPbPr) const { return (yPbPr ? m_chromaYPbPr : m_chromaYUV).data(); }
+    /** @brief Color of a sample drawn on each vectorscope pixel */
+    const QRgb *chromaColors(bool yPbPr) const { return (yPbPr ? m_colorsYPbPr : m_colorsYUV).data(); }
+
+    static Statistic lumaHistogram(ITURec rec) { return rec == ITURec::Rec_601 ? LumaHistogram601 : LumaHistogram709; }
+    static Statistic lumaColumns(ITURec rec) { return rec == ITURec::Rec_601 ? LumaColumns601 : LumaColumns709; }
+    static Statistic chroma(bool yPbPr) { return yPbPr ? ChromaYPbPr : ChromaYUV; }
+    static bool hasChroma(Statistics statistics) { return statistics.testFlag(ChromaYUV) || statistics.testFlag(ChromaYPbPr); }
+    /** @brief Maps a point of [-1,1]², positive directions being →top/→right, to the pixels of an image of size @p targetSize */
+    static QPoint mapToCircle(const QSize &targetSize, const QPointF &point)
+    {
+        return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
+    }
+
+private:
+    Statistics m_statistics;
+    QSize m_size;
+    uint m_accelFactor{1};
+    uint m_elapsed{0};
+    ChromaGeometry m_chroma;
+    int m_depth{0};
+    qint64 m_bytesPerLine{0};
+    std::vector<int> m_histograms[3];
+    std::vector<int> m_luma601;
+    std::vector<int> m_luma709;
+    std::vector<uint> m_columns[3];
+    std::vector<uint> m_lumaColumns601;
+    std::vector<uint> m_lumaColumns709;
+    std::vector<uint> m_chromaYUV;
+    std::vector<uint> m_chromaYPbPr;
+    std::vector<QRgb> m_colorsYUV;
+    std::vector<QRgb> m_colorsYPbPr;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ScopeAnalysis::Statistics)
@@ -0,0 +1,70 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QImage>
+#include <QThread>
+#include <QtConcurrent>
+#include <numeric>
+#include <vector>
+
+/**
+ * Helpers used by the scope analysis to read the input image
+ * scanline by scanline and to split the statistics in bands computed in parallel.
+ */
+namespace ScopeBands {
+
+/** @brief Returns the image in a 32 bit (A)RGB format that can be read with constScanLine, converting it only if needed */
+inline QImage rgb32(const QImage &image)
+{
+    switch (image.format()) {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        return image;
+    default:
+        return image.convertToFormat(QImage::Format_ARGB32);
+    }
+}
+
+/** @brief Column of the first sampled pixel of a row when every accelFactor-th pixel of the image is read */
+inline int firstSample(int row, int width, uint accelFactor)
+{
+    const qint64 offset = qint64(row) * width % accelFactor;
+    return offset == 0 ? 0 : int(accelFactor - offset);
+}
+
+/**
+ * Run @p process on bands of rows or columns in parallel and return the per band accumulators in order.
+ * Small inputs are processed in a single band since the threads would cost more than they save.
+ * @param count the number of rows or columns to split
+ * @param minBandSize the minimum number of rows or columns in a band
+ * @param maxBands the maximum number of bands, each one allocating its own accumulator
+ * @param init creates an empty accumulator for a band
+ * @param process process(accumulator, first, last) collects the statistics of the rows or columns [first, last[
+ */
+template <typename Init, typename Process>
+auto accumulate(int count, int minBandSize, int maxBands, Init init, Process process) -> std::vector<decltype(init())>
+{
+    const int bands = qBound(1, count / qMax(1, minBandSize), qMin(maxBands, QThread::idealThreadCount()));
+    std::vector<decltype(init())> results;
+    results.reserve(size_t(bands));
+    for (int i = 0; i < bands; ++i) {
+        results.push_back(init());
+    }
+    const int bandSize = (count + bands - 1) / bands;
+    if (bands == 1) {
+        process(results.front(), 0, count);
+        return results;
+    }
+    std::vector<int> indexes(size_t(bands));
+    std::iota(indexes.begin(), indexes.end(), 0);
+    // The calling thread takes part in the work, so this is safe from inside a scope calculation thread
+    QtConcurrent::blockingMap(indexes, [&](int band) { process(results[size_t(band)], band * bandSize, qMin(count, (band + 1) * bandSize)); });
+    return results;
+}
+
+} // namespace ScopeBands
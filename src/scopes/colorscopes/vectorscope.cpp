@@ -264,7 +264,20 @@ QImage Vectorscope::renderHUD(uint)
     return hud;
 }
 
-QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+ScopeAnalysis::Statistics Vectorscope::requiredStatistics() const
+{
+    VectorscopeGenerator::ColorSpace colorSpace =
+        m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr : VectorscopeGenerator::ColorSpace_YUV;
+    VectorscopeGenerator::PaintMode paintMode = VectorscopeGenerator::PaintMode(m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt());
+    return VectorscopeGenerator::statistics(paintMode, colorSpace);
+}
+
+ScopeAnalysis::ChromaGeometry Vectorscope::requiredChromaGeometry() const
+{
+    return {m_scopeRect.size(), m_gain};
+}
+
+QImage Vectorscope::renderGfxScope(uint accelerationFactor, const ScopeAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
@@ -277,10 +290,10 @@ QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage
         VectorscopeGenerator::ColorSpace colorSpace =
             m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr : VectorscopeGenerator::ColorSpace_YUV;
         VectorscopeGenerator::PaintMode paintMode = VectorscopeGenerator::PaintMode(m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt());
-        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size(), qimage, m_gain, paintMode, colorSpace, m_aAxisEnabled->isChecked(),
-                                                             accelerationFactor);
+        // Until the requested analysis arrives, the samples are drawn with the previous size and gain
+        scope = m_vectorscopeGenerator->calculateVectorscope(analysis, paintMode, colorSpace, m_aAxisEnabled->isChecked());
     }
-    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), accelerationFactor);
+    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()) + analysis.elapsed(), accelerationFactor);
     return scope;
 }
 
@@ -31,12 +31,14 @@ public:
     ~Vectorscope() override;
 
     QString widgetName() const override;
+    ScopeAnalysis::Statistics requiredStatistics() const override;
+    ScopeAnalysis::ChromaGeometry requiredChromaGeometry() const override;
 
 protected:
     ///// Implemented methods /////
     QRect scopeRect() override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const ScopeAnalysis &analysis) override;
     QImage renderBackground(uint accelerationFactor) override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
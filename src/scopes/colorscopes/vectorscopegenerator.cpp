@@ -62,12 +62,59 @@ mRgb2YPbPr =                        r =
 
 #include "vectorscopegenerator.h"
 #include <cmath>
+#include <vector>
 
 // The maximum distance from the center for any RGB color is 0.63, so
 // no need to make the circle bigger than required.
-const double SCALING = 1 / .7;
+const double SCALING = ScopeAnalysis::ChromaScaling;
 
-const double VectorscopeGenerator::scaling = 1 / .7;
+const double VectorscopeGenerator::scaling = ScopeAnalysis::ChromaScaling;
+
+namespace {
+/** @brief Color of a vectorscope pixel in the YUV and Chroma paint modes, see yuvColorWheel */
+QRgb chromaColor(VectorscopeGenerator::PaintMode paintMode, VectorscopeGenerator::ColorSpace colorSpace, double u, double v)
+{
+    // Default Y value. Lower = darker.
+    const double dy = paintMode == VectorscopeGenerator::PaintMode_YUV ? 128 : 200;
+    double dr, dg, db;
+
+    // Calculate the RGB values from YUV/YPbPr
+    switch (colorSpace) {
+    case VectorscopeGenerator::ColorSpace_YUV:
+        dr = dy + 290.8 * v;
+        dg = dy - 100.6 * u - 148 * v;
+        db = dy + 517.2 * u;
+        break;
+    case VectorscopeGenerator::ColorSpace_YPbPr:
+    default:
+        dr = dy + 357.5 * v;
+        dg = dy - 87.75 * u - 182 * v;
+        db = dy + 451.9 * u;
+        break;
+    }
+
+    if (paintMode == VectorscopeGenerator::PaintMode_YUV) {
+        dr = qBound(0., dr, 255.);
+        dg = qBound(0., dg, 255.);
+        db = qBound(0., db, 255.);
+    } else {
+        // Scale the RGB values back to max 255
+        double dmax = dr;
+        if (dg > dmax) {
+            dmax = dg;
+        }
+        if (db > dmax) {
+            dmax = db;
+        }
+        dmax = 255 / dmax;
+
+        dr *= dmax;
+        dg *= dmax;
+        db *= dmax;
+    }
+    return qRgba(int(dr), int(dg), int(db), 255);
+}
+} // namespace
 
 /**
   Input point is on [-1,1]², 0 being at the center,
@@ -101,161 +148,124 @@ const double VectorscopeGenerator::scaling = 1 / .7;
  */
 QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF &point) const
 {
-    return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
+    // The frame analysis draws the chroma samples with the same mapping
+    return ScopeAnalysis::mapToCircle(targetSize, point);
 }
 
 QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
-                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
+                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool drawAxis,
                                                   uint accelFactor) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (accelFactor < 1) { accelFactor = 1; }
+    const ScopeAnalysis::ChromaGeometry chroma{vectorscopeSize, gain};
+    return calculateVectorscope(ScopeAnalysis(image, statistics(paintMode, colorSpace), accelFactor, chroma), paintMode, colorSpace, drawAxis);
+}
+
+ScopeAnalysis::Statistics VectorscopeGenerator::statistics(PaintMode paintMode, ColorSpace colorSpace)
+{
+    ScopeAnalysis::Statistics result = ScopeAnalysis::chroma(colorSpace == ColorSpace_YPbPr);
+    if (paintMode == PaintMode_Original) {
+        result |= ScopeAnalysis::ChromaColors;
+    }
+    return result;
+}
+
+QImage VectorscopeGenerator::calculateVectorscope(const ScopeAnalysis &analysis, const VectorscopeGenerator::PaintMode &paintMode,
+                                                  const VectorscopeGenerator::ColorSpace &colorSpace, bool) const
+{
+    const ScopeAnalysis::ChromaGeometry &geometry = analysis.chromaGeometry();
+    const int cw = geometry.side();
+    if (cw <= 0 || analysis.isEmpty() || !analysis.contains(statistics(paintMode, colorSpace))) {
         // Invalid size
         return QImage();
     }
-    if (accelFactor < 1) { accelFactor = 1; }
 
     // Prepare the vectorscope data
-    const int cw = (vectorscopeSize.width() < vectorscopeSize.height()) ? vectorscopeSize.width() : vectorscopeSize.height();
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    double dy, dr, dg, db, dmax;
-    double /*y,*/ u, v;
-    QPoint pt;
-    QRgb px;
-
     // Just an average for the number of image pixels per scope pixel.
     // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
     // https://doc.qt.io/qt-5/qimage.html#bytesPerLine
-    double avgPxPerPx = double(image.depth()) / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
+    double avgPxPerPx =
+        double(analysis.depth()) / 8 * (analysis.bytesPerLine() * analysis.height()) / scope.size().width() / scope.size().height() / analysis.accelFactor();
 
     // benchmarking code
     // const auto start = std::chrono::high_resolution_clock::now();
 
-    const auto totalPixels = image.width() * image.height();
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const QRgb pixel = image.pixel(i % image.width(), i / image.width());
-        const int r = qRed(pixel);
-        const int g = qGreen(pixel);
-        const int b = qBlue(pixel);
-
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = 0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = -0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = 0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
+    // The analysis counted the samples drawn on each scope pixel. The accumulating paint modes only depend
+    // on that number, while the other ones give each hit pixel a color.
+    const bool accumulating = paintMode == PaintMode_Green || paintMode == PaintMode_Green2 || paintMode == PaintMode_Black;
+    const bool yPbPr = colorSpace == ColorSpace_YPbPr;
+    const uint *hits = analysis.chromaHits(yPbPr);
+
+    if (accumulating) {
+        // Each hit brightens the pixel depending on its previous value only, so the color of a pixel
+        // is given by its number of hits. Compute it once for each count.
+        const size_t scopeSize = size_t(cw) * size_t(cw);
+        uint maxHits = 0;
+        for (size_t i = 0; i < scopeSize; ++i) {
+            maxHits = qMax(maxHits, hits[i]);
         }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * double(gain) * u, SCALING * double(gain) * v));
-
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
-
-        } else {
-
-            // Draw the pixel using the chosen draw mode.
+        std::vector<QRgb> countColors;
+        countColors.reserve(maxHits + 1);
+        QRgb px = qRgba(0, 0, 0, 0);
+        countColors.push_back(px);
+        for (uint count = 1; count <= maxHits; ++count) {
             switch (paintMode) {
-            case PaintMode_YUV:
-                // see yuvColorWheel
-                dy = 128; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                if (dr < 0) {
-                    dr = 0;
-                }
-                if (dg < 0) {
-                    dg = 0;
-                }
-                if (db < 0) {
-                    db = 0;
-                }
-                if (dr > 255) {
-                    dr = 255;
-                }
-                if (dg > 255) {
-                    dg = 255;
-                }
-                if (db > 255) {
-                    db = 255;
-                }
-
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
-                break;
-
-            case PaintMode_Chroma:
-                dy = 200; // Default Y value. Lower = darker.
-
-                // Calculate the RGB values from YUV/YPbPr
-                switch (colorSpace) {
-                case VectorscopeGenerator::ColorSpace_YUV:
-                    dr = dy + 290.8 * v;
-                    dg = dy - 100.6 * u - 148 * v;
-                    db = dy + 517.2 * u;
-                    break;
-                case VectorscopeGenerator::ColorSpace_YPbPr:
-                default:
-                    dr = dy + 357.5 * v;
-                    dg = dy - 87.75 * u - 182 * v;
-                    db = dy + 451.9 * u;
-                    break;
-                }
-
-                // Scale the RGB values back to max 255
-                dmax = dr;
-                if (dg > dmax) {
-                    dmax = dg;
-                }
-                if (db > dmax) {
-                    dmax = db;
-                }
-                dmax = 255 / dmax;
-
-                dr *= dmax;
-                dg *= dmax;
-                db *= dmax;
-
-                scope.setPixel(pt, qRgba(int(dr), int(dg), int(db), 255));
-                break;
-            case PaintMode_Original:
-                scope.setPixel(pt, pixel);
-                break;
             case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
-                                         qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx))));
+                px = qRgba(qRed(px) + int((255 - qRed(px)) / (3 * avgPxPerPx)), qGreen(px) + int(20 * (255 - qGreen(px)) / (avgPxPerPx)),
+                           qBlue(px) + int((255 - qBlue(px)) / (avgPxPerPx)), qAlpha(px) + int((255 - qAlpha(px)) / (avgPxPerPx)));
                 break;
             case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255,
-                                         qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))), qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx)))));
+                px = qRgba(qRed(px) + int(ceil((255 - qRed(px)) / (4 * avgPxPerPx))), 255, qBlue(px) + int(ceil((255 - qBlue(px)) / (avgPxPerPx))),
+                           qAlpha(px) + int(ceil((255 - qAlpha(px)) / (avgPxPerPx))));
                 break;
             case PaintMode_Black:
             default:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+                px = qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20);
                 break;
             }
+            if (px == countColors.back()) {
+                // The color does not change anymore with more hits
+                break;
+            }
+            countColors.push_back(px);
+        }
+        const uint lastCount = uint(countColors.size() - 1);
+        for (int row = 0; row < cw; ++row) {
+            auto *line = reinterpret_cast<QRgb *>(scope.scanLine(row));
+            const uint *rowHits = hits + size_t(row) * size_t(cw);
+            for (int x = 0; x < cw; ++x) {
+                line[x] = countColors[qMin(rowHits[x], lastCount)];
+            }
+        }
+    } else if (paintMode == PaintMode_Original) {
+        const QRgb *colors = analysis.chromaColors(yPbPr);
+        for (int row = 0; row < cw; ++row) {
+            auto *line = reinterpret_cast<QRgb *>(scope.scanLine(row));
+            const size_t rowOffset = size_t(row) * size_t(cw);
+            for (int x = 0; x < cw; ++x) {
+                if (hits[rowOffset + size_t(x)] > 0) {
+                    line[x] = colors[rowOffset + size_t(x)];
+                }
+            }
+        }
+    } else {
+        // Draw the pixel with the color of the U and V values at its center, inverting mapToCircle
+        const double gain = SCALING * double(geometry.gain);
+        const double width = qMax(1, geometry.size.width() - 1);
+        const double height = qMax(1, geometry.size.height() - 1);
+        for (int row = 0; row < cw; ++row) {
+            auto *line = reinterpret_cast<QRgb *>(scope.scanLine(row));
+            const size_t rowOffset = size_t(row) * size_t(cw);
+            const double v = (1 - 2 * (row + .5) / height) / gain;
+            for (int x = 0; x < cw; ++x) {
+                if (hits[rowOffset + size_t(x)] > 0) {
+                    const double u = (2 * (x + .5) / width - 1) / gain;
+                    line[x] = chromaColor(paintMode, colorSpace, u, v);
+                }
+            }
         }
     }
     // const auto elapsed = std::chrono::high_resolution_clock::now() - start;
@@ -7,6 +7,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #pragma once
 
+#include "scopeanalysis.h"
+
 #include <QImage>
 #include <QObject>
 
@@ -25,6 +27,11 @@ public:
 
     QImage calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
                                 const VectorscopeGenerator::ColorSpace &colorSpace, bool, uint accelFactor = 1) const;
+    /** @brief Draw the vectorscope from the chroma samples of a shared frame analysis, at the size and gain they were drawn with */
+    QImage calculateVectorscope(const ScopeAnalysis &analysis, const VectorscopeGenerator::PaintMode &paintMode,
+                                const VectorscopeGenerator::ColorSpace &colorSpace, bool) const;
+    /** @brief The statistics needed to draw the vectorscope */
+    static ScopeAnalysis::Statistics statistics(PaintMode paintMode, ColorSpace colorSpace);
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
     static const double scaling;
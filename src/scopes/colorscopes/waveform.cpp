@@ -178,17 +178,22 @@ QImage Waveform::renderHUD(uint)
     return hud;
 }
 
-QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
+ScopeAnalysis::Statistics Waveform::requiredStatistics() const
+{
+    return WaveformGenerator::statistics(m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709);
+}
+
+QImage Waveform::renderGfxScope(uint accelFactor, const ScopeAnalysis &analysis)
 {
     QElapsedTimer timer;
     timer.start();
 
     const int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
     ITURec rec = m_aRec601->isChecked() ? ITURec::Rec_601 : ITURec::Rec_709;
-    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), qimage,
-                                                         WaveformGenerator::PaintMode(paintmode), true, rec, accelFactor);
+    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), analysis,
+                                                         WaveformGenerator::PaintMode(paintmode), true, rec);
 
-    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()), 1);
+    Q_EMIT signalScopeRenderingFinished(uint(timer.elapsed()) + analysis.elapsed(), accelFactor);
     return wave;
 }
 
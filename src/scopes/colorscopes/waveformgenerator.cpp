@@ -16,6 +16,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QSize>
 #include <vector>
 
+
 #define CHOP255(a) int((255) < (a) ? (255) : (a))
 
 WaveformGenerator::WaveformGenerator() = default;
@@ -26,29 +27,33 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
                                             uint accelFactor)
 {
     Q_ASSERT(accelFactor >= 1);
+    return calculateWaveform(waveformSize, ScopeAnalysis(image, statistics(rec), accelFactor), paintMode, drawAxis, rec);
+}
+
+ScopeAnalysis::Statistics WaveformGenerator::statistics(ITURec rec)
+{
+    return ScopeAnalysis::lumaColumns(rec);
+}
 
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const ScopeAnalysis &analysis, WaveformGenerator::PaintMode paintMode, bool drawAxis,
+                                            ITURec rec)
+{
     // QTime time;
     // time.start();
 
-    QImage wave(waveformSize, QImage::Format_ARGB32);
-
-    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || analysis.isEmpty() || !analysis.contains(statistics(rec))) {
         return QImage();
     }
-
-    // Fill with transparent color
-    wave.fill(qRgba(0, 0, 0, 0));
+    QImage wave(waveformSize, QImage::Format_ARGB32);
 
     const uint ww = uint(waveformSize.width());
     const uint wh = uint(waveformSize.height());
-    const uint iw = uint(image.width());
-    const auto totalPixels = image.width() * image.height();
-
-    std::vector<std::vector<uint>> waveValues(size_t(waveformSize.width()), std::vector<uint>(size_t(waveformSize.height()), 0));
+    const uint iw = uint(analysis.width());
+    const auto totalPixels = analysis.width() * analysis.height();
 
     // Number of input pixels that will fall on one scope pixel.
     // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = float(totalPixels / accelFactor) / (ww * wh);
+    const float pixelDepth = float(totalPixels / analysis.accelFactor()) / (ww * wh);
     const float gain = 255.f / (8 * pixelDepth);
     // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
 
@@ -57,53 +62,59 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
     const float hPrediv = (wh - 1) / 255.f;
     const float wPrediv = (ww - 1) / float(iw - 1);
 
-    for (int i = 0; i < totalPixels; i += accelFactor) {
-        const int x = i % image.width();
-        const QRgb pixel = image.pixel(x, i / image.width());
-
-        float dY, dx, dy;
-
-        if (rec == ITURec::Rec_601) {
-            // CIE 601 Luminance
-            dY = REC_601_R * qRed(pixel) + REC_601_G * qGreen(pixel) + REC_601_B * qBlue(pixel);
-        } else {
-            // CIE 709 Luminance
-            dY = REC_709_R * qRed(pixel) + REC_709_G * qGreen(pixel) + REC_709_B * qBlue(pixel);
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = x * wPrediv;
-        waveValues[size_t(dx)][size_t(dy)]++;
+    // Scope row of each luma value
+    uint rows[256];
+    for (int luma = 0; luma < 256; ++luma) {
+        rows[luma] = uint(luma * hPrediv);
     }
 
-    switch (paintMode) {
-    case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * logf(0.1f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(52 * logf(.25f * gain * float(waveValues[size_t(i)][size_t(j)]))),
-                                    CHOP255(64 * logf(gain * float(waveValues[size_t(i)][size_t(j)])))));
+    // Flat buffer of the hits, row j holding the luma value j (from bottom to top),
+    // filled from the luma distribution of each image column
+    std::vector<uint> waveValues(size_t(ww) * wh, 0);
+    const uint *lumaColumns = analysis.lumaColumns(rec);
+    for (uint x = 0; x < iw; ++x) {
+        const uint column = uint(x * wPrediv);
+        const uint *distribution = lumaColumns + size_t(x) * 256;
+        for (int luma = 0; luma < 256; ++luma) {
+            if (distribution[luma] > 0) {
+                waveValues[size_t(rows[luma]) * ww + column] += distribution[luma];
             }
         }
-        break;
-    case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * float(waveValues[size_t(i)][size_t(j)]))));
-            }
+    }
+    uint maxValue = 0;
+    for (uint value : waveValues) {
+        maxValue = qMax(maxValue, value);
+    }
+
+    // Colors only depend on the number of hits, compute them once for each count.
+    // All counts above the saturation limit give the same color.
+    auto colorFor = [&](uint count) -> QRgb {
+        switch (paintMode) {
+        case PaintMode_Green:
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            return qRgba(CHOP255(52 * logf(0.1f * gain * float(count))), CHOP255(52 * logf(gain * float(count))), CHOP255(52 * logf(.25f * gain * float(count))),
+                         CHOP255(64 * logf(gain * float(count))));
+        case PaintMode_Yellow:
+            return qRgba(255, 242, 0, CHOP255(gain * float(count)));
+        default:
+            return qRgba(255, 255, 255, CHOP255(2.f * gain * float(count)));
         }
-        break;
-    default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2.f * gain * float(waveValues[size_t(i)][size_t(j)]))));
-            }
+    };
+    const double saturation = paintMode == PaintMode_Green ? 2560. / gain : 256. / gain;
+    const uint tableSize = uint(qMin(double(maxValue), qMax(0., saturation))) + 2;
+    std::vector<QRgb> colors;
+    colors.reserve(tableSize);
+    // The logarithm is not defined for empty pixels, leave them transparent
+    colors.push_back(paintMode == PaintMode_Green ? qRgba(0, 0, 0, 0) : colorFor(0));
+    for (uint count = 1; count < tableSize; ++count) {
+        colors.push_back(colorFor(count));
+    }
+    for (uint j = 0; j < wh; ++j) {
+        auto *line = reinterpret_cast<QRgb *>(wave.scanLine(int(wh - j - 1)));
+        const uint *values = waveValues.data() + size_t(j) * ww;
+        for (uint i = 0; i < ww; ++i) {
+            line[i] = values[i] < tableSize ? colors[values[i]] : colors.back();
         }
-        break;
     }
 
     if (drawAxis) {
@@ -119,9 +130,10 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
         davinci.setCompositionMode(QPainter::CompositionMode_Overlay);
         for (int i = 0; i <= 10; ++i) {
             int dy = int(i / 10.f * (wh - 1));
+            auto *line = reinterpret_cast<QRgb *>(wave.scanLine(dy));
             for (int x = 0; x < int(ww); ++x) {
-                opx = wave.pixel(x, dy);
-                wave.setPixel(x, dy, qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx))));
+                opx = line[x];
+                line[x] = qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx)));
             }
         }
     }
@@ -9,6 +9,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include <QObject>
 #include "colorconstants.h"
+#include "scopeanalysis.h"
 
 class QImage;
 class QSize;
@@ -25,4 +26,9 @@ public:
 
     QImage calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
                              const ITURec rec, uint accelFactor = 1);
+    /** @brief Draw the waveform from the luma distribution of each column of a shared frame analysis */
+    QImage calculateWaveform(const QSize &waveformSize, const ScopeAnalysis &analysis, WaveformGenerator::PaintMode paintMode, bool drawAxis,
+                             const ITURec rec);
+    /** @brief The statistics needed to draw the waveform */
+    static ScopeAnalysis::Statistics statistics(ITURec rec);
 };
@@ -22,6 +22,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "klocalizedstring.h"
 #include <QDockWidget>
 #include <QSignalMapper>
+#include <QtConcurrent>
 
 //#define DEBUG_SM
 #ifdef DEBUG_SM
@@ -35,6 +36,7 @@ ScopeManager::ScopeManager(QObject *parent)
     connect(pCore->monitorManager(), &MonitorManager::checkColorScopes, this, &ScopeManager::slotUpdateActiveRenderer);
     connect(pCore->monitorManager(), &MonitorManager::clearScopes, this, &ScopeManager::slotClearColorScopes);
     connect(pCore->monitorManager(), &MonitorManager::checkScopes, this, &ScopeManager::slotCheckActiveScopes);
+    connect(&m_analysisWatcher, &QFutureWatcher<std::shared_ptr<const ScopeAnalysis>>::finished, this, &ScopeManager::slotAnalysisReady);
 
     slotUpdateActiveRenderer();
 
@@ -121,15 +123,57 @@ void ScopeManager::slotDistributeAudio(const audioShortVector &sampleData, int f
         }
     }
 }
+bool ScopeManager::scopeWantsFrame(const GfxScopeData &scopeData) const
+{
+    return !scopeData.scope->visibleRegion().isEmpty() && (scopeData.scope->autoRefreshEnabled() || scopeData.singleFrameRequested);
+}
+
 void ScopeManager::slotDistributeFrame(const QImage &image)
 {
 #ifdef DEBUG_SM
     qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting to distribute frame.";
 #endif
+    if (m_analysisWatcher.isRunning()) {
+        // Only keep the latest frame, it will be analysed when the current analysis is done
+        m_pendingFrame = image;
+        return;
+    }
+    startAnalysis(image);
+}
+
+void ScopeManager::startAnalysis(const QImage &image)
+{
+    ScopeAnalysis::Statistics statistics;
+    ScopeAnalysis::ChromaGeometry chroma;
+    uint accelFactor = 1;
+    for (const auto &colorScope : qAsConst(m_colorScopes)) {
+        if (scopeWantsFrame(colorScope)) {
+            const ScopeAnalysis::Statistics required = colorScope.scope->requiredStatistics();
+            statistics |= required;
+            if (ScopeAnalysis::hasChroma(required)) {
+                chroma = colorScope.scope->requiredChromaGeometry();
+            }
+            // The frame is read once for all the scopes, so the slowest one decides how many pixels are skipped
+            accelFactor = qMax(accelFactor, colorScope.scope->accelFactor());
+        }
+    }
+    if (statistics == ScopeAnalysis::Statistics()) {
+        // No scope wants this frame
+        return;
+    }
+    // Convert and read the frame once for all the scopes
+    m_analysisWatcher.setFuture(QtConcurrent::run([image, statistics, accelFactor, chroma]() {
+        return std::shared_ptr<const ScopeAnalysis>(new ScopeAnalysis(image, statistics, accelFactor, chroma));
+    }));
+}
+
+void ScopeManager::slotAnalysisReady()
+{
+    const std::shared_ptr<const ScopeAnalysis> analysis = m_analysisWatcher.result();
     for (auto &m_colorScope : m_colorScopes) {
         if (!m_colorScope.scope->visibleRegion().isEmpty()) {
             if (m_colorScope.scope->autoRefreshEnabled()) {
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(analysis);
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed frame to " << m_colorScopes[i].scope->widgetName();
 #endif
@@ -137,7 +181,7 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
                 // Special case: Auto refresh is disabled, but user requested an update (e.g. by clicking).
                 // Force the scope to update.
                 m_colorScope.singleFrameRequested = false;
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(analysis);
                 m_colorScope.scope->forceUpdateScope();
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed forced frame to " << m_colorScopes[i].scope->widgetName();
@@ -145,6 +189,11 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
             }
         }
     }
+    if (!m_pendingFrame.isNull()) {
+        QImage frame = m_pendingFrame;
+        m_pendingFrame = QImage();
+        startAnalysis(frame);
+    }
     // checkActiveColourScopes();
 }
 
@@ -10,7 +10,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "audioscopes/abstractaudioscopewidget.h"
 #include "colorscopes/abstractgfxscopewidget.h"
 
+#include <QFutureWatcher>
+#include <QImage>
 #include <QList>
+#include <memory>
 
 class QDockWidget;
 class AbstractMonitor;
@@ -72,6 +75,16 @@ private:
 
     QSignalMapper *m_signalMapper;
 
+    /** @brief Analysis of the last frame, computed off the GUI thread and shared by all color scopes */
+    QFutureWatcher<std::shared_ptr<const ScopeAnalysis>> m_analysisWatcher;
+    /** @brief Latest frame received while an analysis was running, the older ones are dropped */
+    QImage m_pendingFrame;
+
+    /** @brief Returns true if the scope should receive the next frame */
+    bool scopeWantsFrame(const GfxScopeData &scopeData) const;
+    /** @brief Collect the statistics needed by all the scopes receiving the frame in a single pass */
+    void startAnalysis(const QImage &image);
+
     /**
       Checks whether there is any scope accepting audio data, or if all of them are hidden
       or if auto refresh is disabled.
@@ -125,6 +138,8 @@ private Q_SLOTS:
     void checkActiveColourScopes();
 
     void slotDistributeFrame(const QImage &image);
+    /** @brief The frame analysis is ready, send it to the scopes */
+    void slotAnalysisReady();
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
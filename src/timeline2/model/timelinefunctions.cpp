@@ -33,6 +33,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QDebug>
 #include <QInputDialog>
 #include <QSemaphore>
+#include <climits>
 #include <unordered_map>
 
 #ifdef CRASH_AUTO_TEST
@@ -791,16 +792,27 @@ bool TimelineFunctions::removeSpace(const std::shared_ptr<TimelineItemModel> &ti
                                     bool useTargets)
 {
     std::unordered_set<int> clips;
+    QVector<int> tracks = allowedTracks;
     if (useTargets) {
+        tracks.clear();
         auto it = timeline->m_allTracks.cbegin();
         while (it != timeline->m_allTracks.cend()) {
             int target_track = (*it)->getId();
             if (timeline->getTrackById_const(target_track)->shouldReceiveTimelineOp()) {
-                std::unordered_set<int> subs = timeline->getItemsInRange(target_track, zone.y() - 1, -1, true);
-                clips.insert(subs.begin(), subs.end());
+                tracks << target_track;
             }
             ++it;
         }
+    }
+    // Shift all the items at once if no group or item crosses the zone end
+    if (timeline->requestShiftItems(zone.y(), zone.x() - zone.y(), tracks, undo, redo)) {
+        return true;
+    }
+    if (useTargets) {
+        for (int target_track : qAsConst(tracks)) {
+            std::unordered_set<int> subs = timeline->getItemsInRange(target_track, zone.y() - 1, -1, true);
+            clips.insert(subs.begin(), subs.end());
+        }
     } else {
         for (auto tid : allowedTracks) {
             std::unordered_set<int> subs = timeline->getItemsInRange(tid, zone.y() - 1, -1, true);
@@ -839,6 +851,21 @@ bool TimelineFunctions::requestInsertSpace(const std::shared_ptr<TimelineItemMod
     timeline->requestClearSelection();
     Fun local_undo = []() { return true; };
     Fun local_redo = []() { return true; };
+    // Shift all the items at once if no group or item crosses the zone start
+    QVector<int> tracks = allowedTracks;
+    bool movesSubtitles = false;
+    if (tracks.isEmpty()) {
+        for (const auto &track : timeline->m_allTracks) {
+            if (!track->isLocked()) {
+                tracks << track->getId();
+            }
+        }
+        movesSubtitles = timeline->getSubtitleModel() && !timeline->getSubtitleModel()->getItemsInRange(zone.x(), -1).empty();
+    }
+    if (!movesSubtitles && timeline->requestShiftItems(zone.x(), zone.y() - zone.x(), tracks, local_undo, local_redo)) {
+        UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo);
+        return true;
+    }
     std::unordered_set<int> items;
     if (allowedTracks.isEmpty()) {
         // Select clips in all tracks
@@ -1710,7 +1737,8 @@ bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &tim
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     if (TimelineFunctions::pasteClips(timeline, pasteString, trackId, position, undo, redo)) {
-        pCore->pushUndo(undo, redo, i18n("Paste clips"));
+        // The pasted clips and their effects are described by the paste string
+        pCore->pushUndo(undo, redo, i18n("Paste clips"), pasteString.size() * qint64(sizeof(QChar)));
         return true;
     }
     return false;
@@ -2606,6 +2634,32 @@ bool TimelineFunctions::requestDeleteAllBlanksFrom(const std::shared_ptr<Timelin
         if (blankStart == -1) {
             return false;
         }
+        // Close the blanks by shifting the following items at once, until a blank is crossed by a group or a composition
+        while (blankStart != -1) {
+            int blankEnd = timeline->getTrackById_const(trackId)->getBlankEnd(blankStart);
+            if (blankEnd == INT_MAX) {
+                // Reached the end of the track
+                blankStart = -1;
+                break;
+            }
+            std::function<bool(void)> local_undo = []() { return true; };
+            std::function<bool(void)> local_redo = []() { return true; };
+            if (!timeline->requestShiftItems(blankEnd + 1, blankStart - blankEnd - 1, {trackId}, local_undo, local_redo)) {
+                break;
+            }
+            if (!KdenliveSettings::lockedGuides()) {
+                // Move guides like requestSpacerEndOperation does
+                int guidesPosition = qMin(position, blankEnd + 1);
+                GenTime fromPos(guidesPosition, pCore->getCurrentFps());
+                GenTime offset(blankStart - blankEnd - 1, pCore->getCurrentFps());
+                QList<CommentedTime> guides = timeline->getGuideModel()->getMarkersInRange(guidesPosition, -1);
+                if (!guides.isEmpty()) {
+                    timeline->getGuideModel()->moveMarkers(guides, fromPos, fromPos + offset, local_undo, local_redo);
+                }
+            }
+            UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo);
+            blankStart = timeline->getTrackById_const(trackId)->getNextBlankStart(blankStart);
+        }
         while (blankStart != -1) {
             std::pair<int, int> spacerOp = requestSpacerStartOperation(timeline, trackId, blankStart, true);
             int cid = spacerOp.first;
@@ -1713,7 +1713,7 @@ bool TimelineModel::requestClipInsertion(const QString &binClipId, int trackId,
     }
     bool result = requestClipInsertion(binClipId, trackId, position, id, logUndo, refreshView, useTargets, undo, redo, allowedTracks);
     if (result && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Insert Clip"));
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Insert Clip"), itemUndoSize(id));
     }
     TRACE_RES(result);
     return result;
@@ -2039,14 +2039,33 @@ bool TimelineModel::requestItemDeletion(int itemId, bool logUndo)
     }
     Fun undo = []() { return true; };
     Fun redo = []() { return true; };
+    // The deleted items are kept alive by the undo
+    qint64 undoSize = logUndo ? itemUndoSize(itemId) : 0;
     bool res = requestItemDeletion(itemId, undo, redo, logUndo);
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, actionLabel);
+        PUSH_UNDO_WITH_SIZE(undo, redo, actionLabel, undoSize);
     }
     TRACE_RES(res);
     return res;
 }
 
+qint64 TimelineModel::itemUndoSize(int itemId) const
+{
+    std::unordered_set<int> items = {itemId};
+    if (m_groups->isInGroup(itemId)) {
+        items = m_groups->getLeaves(m_groups->getRootId(itemId));
+    }
+    qint64 size = 0;
+    for (int id : items) {
+        if (isClip(id)) {
+            size += m_allClips.at(id)->m_effectStack->paramsSize();
+        } else if (isComposition(id)) {
+            size += AssetParameterModel::paramsSize(m_allCompositions.at(id)->getAllParameters());
+        }
+    }
+    return size;
+}
+
 bool TimelineModel::requestClipDeletion(int clipId, Fun &undo, Fun &redo, bool logUndo)
 {
     int trackId = getClipTrackId(clipId);
@@ -2761,6 +2780,65 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
     return true;
 }
 
+bool TimelineModel::requestShiftItems(int position, int delta, const QVector<int> &trackIds, Fun &undo, Fun &redo)
+{
+    QWriteLocker locker(&m_lock);
+    if (delta == 0) {
+        return true;
+    }
+    std::unordered_set<int> movedItems;
+    for (int tid : trackIds) {
+        if (!isTrack(tid) || !getTrackById_const(tid)->canShift(position, delta)) {
+            return false;
+        }
+        std::unordered_set<int> items = getItemsInRange(tid, position, -1);
+        movedItems.insert(items.begin(), items.end());
+    }
+    // Groups must move as a whole
+    std::unordered_set<int> checkedGroups;
+    for (int id : movedItems) {
+        if (!m_groups->isInGroup(id)) {
+            continue;
+        }
+        int groupId = m_groups->getRootId(id);
+        if (!checkedGroups.insert(groupId).second) {
+            continue;
+        }
+        std::unordered_set<int> leaves = m_groups->getLeaves(groupId);
+        for (int leaf : leaves) {
+            if (movedItems.count(leaf) == 0) {
+                return false;
+            }
+        }
+    }
+    Fun local_undo = []() { return true; };
+    Fun local_redo = []() { return true; };
+    for (int tid : trackIds) {
+        auto track = getTrackById(tid);
+        int trackDuration = track->trackDuration();
+        Fun operation = track->requestShift_lambda(position, delta);
+        if (!operation()) {
+            bool undone = local_undo();
+            Q_ASSERT(undone);
+            return false;
+        }
+        Fun reverse = track->requestShift_lambda(position + delta, -delta);
+        UPDATE_UNDO_REDO(operation, reverse, local_undo, local_redo);
+        if (trackDuration != track->trackDuration()) {
+            track->adjustStackLength(trackDuration, track->trackDuration(), local_undo, local_redo);
+        }
+    }
+    Fun update_duration = [this]() {
+        updateDuration();
+        return true;
+    };
+    update_duration();
+    PUSH_LAMBDA(update_duration, local_redo);
+    PUSH_LAMBDA(update_duration, local_undo);
+    UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
+    return true;
+}
+
 bool TimelineModel::requestGroupDeletion(int clipId, bool logUndo)
 {
     QWriteLocker locker(&m_lock);
@@ -4292,7 +4370,7 @@ bool TimelineModel::requestTrackDeletion(int trackId, Fun &undo, Fun &redo)
         return false;
     }
     // Discard running jobs
-    pCore->taskManager.discardJobs({ObjectType::TimelineTrack, trackId});
+    pCore->taskManager.discardJobsAndWait({ObjectType::TimelineTrack, trackId});
 
     std::vector<int> clips_to_delete;
     for (const auto &it : getTrackById(trackId)->m_allClips) {
@@ -4919,7 +4997,7 @@ bool TimelineModel::requestCompositionInsertion(const QString &transitionId, int
     Fun redo = []() { return true; };
     bool result = requestCompositionInsertion(transitionId, trackId, -1, position, length, std::move(transProps), id, undo, redo, logUndo);
     if (result && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Insert Composition"));
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Insert Composition"), itemUndoSize(id));
     }
     // TRACE_RES(result);
     return result;
@@ -6281,6 +6359,7 @@ void TimelineModel::switchComposition(int cid, const QString &compoId)
         return;
     }
 
+    qint64 undoSize = itemUndoSize(cid);
     bool res = requestCompositionDeletion(cid, undo, redo);
     int newId = -1;
     // Check if composition should be reversed (top clip at beginning, bottom at end)
@@ -6325,7 +6404,7 @@ void TimelineModel::switchComposition(int cid, const QString &compoId)
         local_redo();
         PUSH_LAMBDA(local_redo, redo);
         PUSH_LAMBDA(local_undo, undo);
-        PUSH_UNDO(undo, redo, i18n("Change composition"));
+        PUSH_UNDO_WITH_SIZE(undo, redo, i18n("Change composition"), undoSize + itemUndoSize(newId));
     } else {
         undo();
     }
@@ -517,6 +517,9 @@ public:
     Q_INVOKABLE bool requestItemDeletion(int itemId, bool logUndo = true);
     /* Same function, but accumulates undo and redo*/
     bool requestItemDeletion(int itemId, Fun &undo, Fun &redo, bool logUndo = false);
+    /** @brief Returns the approximate memory kept alive by the undo functions of an operation on this item or its group, in bytes.
+     *  This is the size of the clip effects and composition parameters */
+    qint64 itemUndoSize(int itemId) const;
 
     /** @brief Move a group to a specific position
        This action is undoable
@@ -536,6 +539,17 @@ public:
                           bool revertMove = false, bool moveMirrorTracks = true, bool allowViewRefresh = true,
                           const QVector<int> &allowedTracks = QVector<int>());
 
+    /** @brief Shift all the clips and compositions starting after position on the given tracks by delta frames.
+       The items are moved in one pass per track, with a single undo record per track, instead of being moved one by one.
+       Returns false without modifying anything if the shift is not possible this way: an item or a mix crosses position,
+       a backwards shift would overlap other items, a track is locked or is the subtitle track, or a moved item is grouped with an item that does not move.
+       Callers should then fall back to a group move.
+       @param position the first frame of the moved items
+       @param delta the position change, negative to remove space
+       @param trackIds the ids of the tracks to shift
+    */
+    bool requestShiftItems(int position, int delta, const QVector<int> &trackIds, Fun &undo, Fun &redo);
+
     /** @brief Deletes all clips inside the group that contains the given clip.
        This action is undoable
        Note that if their is a hierarchy of groups, all of them will be deleted.
@@ -137,6 +137,7 @@ bool TrackModel::switchPlaylist(int clipId, int position, int sourcePlaylist, in
         clip->setSubPlaylistIndex(destPlaylist, m_id);
         int index = m_playlists[destPlaylist].insert_at(position, *clip, 1);
         m_playlists[destPlaylist].consolidate_blanks();
+        indexClip(clipId, index == -1 ? sourcePlaylist : destPlaylist);
         return index != -1;
     }
     return false;
@@ -171,6 +172,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             m_allClips[clip->getId()] = clip; // store clip
             // update clip position and track
             clip->setPosition(position);
+            indexClip(clipId, subPlaylist);
             if (finalMove) {
                 clip->setSubPlaylistIndex(subPlaylist, m_id);
             }
@@ -365,6 +367,8 @@ void TrackModel::replugClip(int clipId)
     if (auto ptr = m_parent.lock()) {
         std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
         m_playlists[target_track].insert_at(clip_position, *clip, 1);
+        // The producer may have a different length
+        indexClip(clipId, target_track);
         if (!clip->isAudioOnly() && !isAudioTrack()) {
             Q_EMIT ptr->invalidateZone(clip->getIn(), clip->getOut());
         }
@@ -412,6 +416,7 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             // m_allClips[clipId]->setSubPlaylistIndex(-1);
+            unindexClip(clipId);
             m_allClips.erase(clipId);
             delete prod;
             m_playlists[target_track].unlock();
@@ -452,7 +457,7 @@ bool TrackModel::requestClipDeletion(int clipId, bool updateView, bool finalMove
     // qDebug() << "/// REQUESTOING CLIP DELETION_: " << updateView;
     int duration = trackDuration();
     if (finalDeletion) {
-        pCore->taskManager.discardJobs({ObjectType::TimelineClip, clipId});
+        pCore->taskManager.discardJobsAndWait({ObjectType::TimelineClip, clipId});
     }
     auto operation = requestClipDeletion_lambda(clipId, updateView, finalMove, groupMove, finalDeletion);
     if (operation()) {
@@ -686,6 +691,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // make sure to do this after, to avoid messing the indexes
             m_playlists[target_track].consolidate_blanks();
             m_playlists[target_track].unlock();
+            indexClip(clipId, target_track);
             if (err == 0) {
                 update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
                 if (right && finalMove && m_playlists[target_track].count() - 1 == target_clip_mutable) {
@@ -722,6 +728,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     clip->set("length", out + 1);
                 }
                 int err = m_playlists[target_track].resize_clip(target_clip, in, out);
+                indexClip(clipId, target_track);
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
                 }
@@ -775,6 +782,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                 if (!right && err == 0) {
                     m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
                 }
+                indexClip(clipId, target_track);
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
                 }
@@ -799,28 +807,66 @@ int TrackModel::getId() const
 int TrackModel::getClipByStartPosition(int position) const
 {
     READ_LOCK();
-    for (auto &clip : m_allClips) {
-        if (clip.second->getPosition() == position) {
-            return clip.second->getId();
+    int cid = -1;
+    for (const auto &positions : m_clipPos) {
+        auto it = positions.find(position);
+        if (it != positions.cend() && (cid == -1 || it->second.first < cid)) {
+            cid = it->second.first;
         }
     }
-    return -1;
+    return cid;
+}
+
+void TrackModel::indexClip(int clipId, int playlist)
+{
+    unindexClip(clipId);
+    auto clip = m_allClips.find(clipId);
+    if (clip == m_allClips.end()) {
+        return;
+    }
+    int position = clip->second->getPosition();
+    m_clipPos[playlist][position] = {clipId, position + clip->second->getPlaytime()};
+    m_clipIndex[clipId] = {playlist, position};
+}
+
+void TrackModel::unindexClip(int clipId)
+{
+    auto entry = m_clipIndex.find(clipId);
+    if (entry == m_clipIndex.end()) {
+        return;
+    }
+    auto &positions = m_clipPos[entry->second.first];
+    auto it = positions.find(entry->second.second);
+    if (it != positions.end() && it->second.first == clipId) {
+        positions.erase(it);
+    }
+    m_clipIndex.erase(entry);
+}
+
+int TrackModel::indexedClipAt(int position, int playlist) const
+{
+    const auto &positions = m_clipPos[playlist];
+    auto it = positions.upper_bound(position);
+    if (it == positions.cbegin()) {
+        return -1;
+    }
+    --it;
+    return position < it->second.second ? it->second.first : -1;
 }
 
 int TrackModel::getClipByPosition(int position, int playlist)
 {
     READ_LOCK();
-    QSharedPointer<Mlt::Producer> prod(nullptr);
-    if ((playlist == 0 || playlist == -1) && m_playlists[0].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[0].get_clip_at(position));
+    int cid = -1;
+    if (playlist == 0 || playlist == -1) {
+        cid = indexedClipAt(position, 0);
     }
-    if (playlist != 0 && (!prod || prod->is_blank()) && m_playlists[1].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[1].get_clip_at(position));
+    if (playlist != 0 && cid == -1) {
+        cid = indexedClipAt(position, 1);
     }
-    if (!prod || prod->is_blank()) {
+    if (cid == -1) {
         return -1;
     }
-    int cid = prod->get_int("_kdenlive_cid");
     if (playlist == -1) {
         if (hasStartMix(cid)) {
             if (position < m_allClips[cid]->getPosition() + m_allClips[cid]->getMixCutPosition()) {
@@ -854,15 +900,21 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
+    // Compositions do not overlap, only the last two starting before position can contain it
+    auto it = m_compoPos.upper_bound(position);
+    if (it == m_compoPos.begin()) {
+        return -1;
+    }
+    --it;
+    if (it != m_compoPos.begin()) {
+        auto previous = std::prev(it);
+        if (previous->first + m_allCompositions[previous->second]->getPlaytime() >= position) {
+            return previous->second;
         }
     }
+    if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+        return it->second;
+    }
     return -1;
 }
 
@@ -881,14 +933,14 @@ std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
+    for (const auto &positions : m_clipPos) {
+        auto it = positions.upper_bound(position);
+        if (it != positions.cbegin() && std::prev(it)->second.second > position) {
+            // This clip starts before position but ends after it
+            --it;
         }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+        for (; it != positions.cend() && (end <= -1 || it->first < end); ++it) {
+            ids.insert(it->second.first);
         }
     }
     return ids;
@@ -973,6 +1025,22 @@ bool TrackModel::checkConsistency()
         Q_ASSERT(c.second);
         Q_ASSERT(c.second.get() == ptr->getClipPtr(c.first).get());
         clips.emplace_back(c.second->getPosition(), c.first);
+        // Check the position index
+        auto entry = m_clipIndex.find(c.first);
+        if (entry == m_clipIndex.end() || entry->second.first != c.second->getSubPlaylistIndex() || entry->second.second != c.second->getPosition()) {
+            qDebug() << "ERROR: clip" << c.first << "is not indexed at its position";
+            return false;
+        }
+        auto indexed = m_clipPos[entry->second.first].find(entry->second.second);
+        if (indexed == m_clipPos[entry->second.first].end() || indexed->second.first != c.first ||
+            indexed->second.second != c.second->getPosition() + c.second->getPlaytime()) {
+            qDebug() << "ERROR: wrong index entry for clip" << c.first;
+            return false;
+        }
+    }
+    if (m_clipIndex.size() != m_allClips.size() || m_clipPos[0].size() + m_clipPos[1].size() != m_allClips.size()) {
+        qDebug() << "ERROR: the position index has" << m_clipIndex.size() << "clips instead of" << m_allClips.size();
+        return false;
     }
     std::sort(clips.begin(), clips.end());
     int last_out = 0;
@@ -1364,6 +1432,148 @@ Fun TrackModel::requestCompositionResize_lambda(int compoId, int in, int out, bo
     };
 }
 
+bool TrackModel::canShift(int position, int delta) const
+{
+    READ_LOCK();
+    if (isLocked()) {
+        return false;
+    }
+    if (delta < 0 && position + delta < 0) {
+        return false;
+    }
+    for (int i = 0; i < 2; i++) {
+        // A clip crossing position would have to be cut
+        int cid = indexedClipAt(position, i);
+        if (cid > -1 && m_clipIndex.at(cid).second < position) {
+            return false;
+        }
+        if (delta < 0) {
+            // The blank before position must be long enough
+            auto it = m_clipPos[i].lower_bound(position);
+            if (it != m_clipPos[i].cbegin() && std::prev(it)->second.second > position + delta) {
+                return false;
+            }
+        }
+    }
+    auto compo = m_compoPos.lower_bound(position);
+    if (compo != m_compoPos.cbegin()) {
+        --compo;
+        if (compo->first + m_allCompositions.at(compo->second)->getPlaytime() > position) {
+            return false;
+        }
+    }
+    if (delta < 0 && hasIntersectingComposition(position + delta, position - 1)) {
+        return false;
+    }
+    // Both clips of a mix must move together
+    for (auto it = m_mixList.cbegin(); it != m_mixList.cend(); ++it) {
+        if ((m_allClips.at(it.key())->getPosition() >= position) != (m_allClips.at(it.value())->getPosition() >= position)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Fun TrackModel::requestShift_lambda(int position, int delta)
+{
+    return [this, position, delta]() {
+        if (isLocked()) return false;
+        if (delta == 0) {
+            return true;
+        }
+        // Resize the blank at position in each playlist, the following clips move with it
+        for (auto &playlist : m_playlists) {
+            if (position >= playlist.get_playtime()) {
+                continue;
+            }
+            playlist.lock();
+            int index = playlist.get_clip_index_at(position);
+            int err = 0;
+            if (!playlist.is_blank(index)) {
+                if (delta > 0) {
+                    err = playlist.insert_blank(index, delta - 1);
+                    index = -1;
+                } else {
+                    // The clip starts at position, we shorten the blank before it
+                    index--;
+                }
+            }
+            if (index > -1) {
+                int length = playlist.clip_length(index) + delta;
+                err = length > 0 ? playlist.resize_clip(index, 0, length - 1) : playlist.remove(index);
+            }
+            playlist.consolidate_blanks();
+            playlist.unlock();
+            if (err != 0) {
+                qDebug() << "Error : shift failed on track" << m_id << "at" << position;
+                return false;
+            }
+        }
+        auto ptr = m_parent.lock();
+        if (!ptr) {
+            qDebug() << "Error : shift failed because parent timeline is not available anymore";
+            Q_ASSERT(false);
+            return false;
+        }
+        // Update the positions. The moved items keep their order and stay after the others, so they are appended back to the indexes
+        for (auto &positions : m_clipPos) {
+            auto first = positions.lower_bound(position);
+            std::vector<std::pair<int, std::pair<int, int>>> moved(first, positions.end());
+            positions.erase(first, positions.end());
+            for (const auto &entry : moved) {
+                int cid = entry.second.first;
+                int newIn = entry.first + delta;
+                int newOut = entry.second.second + delta;
+                ptr->m_snaps->removePoint(entry.first);
+                ptr->m_snaps->removePoint(entry.second.second);
+                m_allClips[cid]->setPosition(newIn);
+                ptr->m_snaps->addPoint(newIn);
+                ptr->m_snaps->addPoint(newOut);
+                positions.emplace_hint(positions.end(), newIn, std::make_pair(cid, newOut));
+                m_clipIndex[cid].second = newIn;
+            }
+        }
+        auto firstCompo = m_compoPos.lower_bound(position);
+        std::vector<std::pair<int, int>> movedCompositions(firstCompo, m_compoPos.end());
+        m_compoPos.erase(firstCompo, m_compoPos.end());
+        for (const auto &entry : movedCompositions) {
+            std::shared_ptr<CompositionModel> composition = m_allCompositions[entry.second];
+            int length = composition->getPlaytime();
+            int newIn = entry.first + delta;
+            ptr->m_snaps->removePoint(entry.first);
+            ptr->m_snaps->removePoint(entry.first + length);
+            composition->setInOut(newIn, newIn + length - 1);
+            ptr->m_snaps->addPoint(newIn);
+            ptr->m_snaps->addPoint(newIn + length);
+            m_compoPos.emplace_hint(m_compoPos.end(), newIn, entry.second);
+        }
+        // Same track transitions follow their clips
+        for (auto it = m_mixList.cbegin(); it != m_mixList.cend(); ++it) {
+            int mixIn = m_allClips[it.value()]->getPosition();
+            if (mixIn >= position + delta) {
+                int mixOut = m_allClips[it.key()]->getPosition() + m_allClips[it.key()]->getPlaytime();
+                Mlt::Transition &transition = *static_cast<Mlt::Transition *>(m_sameCompositions[it.value()]->getAsset());
+                transition.set_in_and_out(mixIn, mixOut);
+            }
+        }
+        // A single notification for all the items of the track
+        int rows = int(m_allClips.size() + m_allCompositions.size());
+        if (rows > 0) {
+            QModelIndex trackIndex = ptr->makeTrackIndexFromID(m_id);
+            ptr->notifyChange(ptr->index(0, 0, trackIndex), ptr->index(rows - 1, 0, trackIndex), {TimelineModel::StartRole});
+        }
+        if (!isAudioTrack()) {
+            int start = qMin(position, position + delta);
+            int end = ptr->duration() + qAbs(delta);
+            if (!isHidden()) {
+                ptr->checkRefresh(start, end);
+            }
+            Q_EMIT ptr->invalidateZone(start, end);
+        }
+        return true;
+    };
+}
+
 bool TrackModel::requestCompositionInsertion(int compoId, int position, bool updateView, bool finalMove, Fun &undo, Fun &redo)
 {
     QWriteLocker locker(&m_lock);
@@ -1891,8 +2101,10 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                             // Something went wrong, abort
                             m_playlists[1].insert_at(pos, *clip, 1);
                             m_playlists[1].consolidate_blanks();
+                            indexClip(i.key(), 1);
                             return false;
                         }
+                        indexClip(i.key(), 0);
                     }
                     m_playlists[1].consolidate_blanks();
                 }
@@ -1910,8 +2122,10 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                             // Something went wrong, abort
                             m_playlists[0].insert_at(pos, *clip, 1);
                             m_playlists[0].consolidate_blanks();
+                            indexClip(i.key(), 0);
                             return false;
                         }
+                        indexClip(i.key(), 1);
                     }
                     if (m_sameCompositions.count(i.key()) > 0) {
                         // There is a mix at clip start, adjust direction
@@ -1955,8 +2169,10 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                             // Something went wrong, abort
                             m_playlists[0].insert_at(pos, *clip, 1);
                             m_playlists[0].consolidate_blanks();
+                            indexClip(i.key(), 0);
                             return false;
                         }
+                        indexClip(i.key(), 1);
                     }
                     m_playlists[0].consolidate_blanks();
                 }
@@ -1974,8 +2190,10 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                             // Something went wrong, abort
                             m_playlists[1].insert_at(pos, *clip, 1);
                             m_playlists[1].consolidate_blanks();
+                            indexClip(i.key(), 1);
                             return false;
                         }
+                        indexClip(i.key(), 0);
                     }
                     if (m_sameCompositions.count(i.key()) > 0) {
                         // There is a mix at clip start, adjust direction
@@ -2802,11 +3020,9 @@ QVariantList TrackModel::stackZones() const
 
 bool TrackModel::hasClipStart(int pos)
 {
-    for (auto &m_playlist : m_playlists) {
-        if (m_playlist.is_blank_at(pos)) {
-            continue;
-        }
-        if (pos == 0 || m_playlist.get_clip_index_at(pos) != m_playlist.get_clip_index_at(pos - 1)) {
+    READ_LOCK();
+    for (const auto &positions : m_clipPos) {
+        if (positions.count(pos) > 0) {
             return true;
         }
     }
@@ -214,6 +214,16 @@ protected:
     Fun requestCompositionDeletion_lambda(int compoId, bool updateView, bool finalMove = false);
     Fun requestCompositionResize_lambda(int compoId, int in, int out = -1, bool logUndo = false);
 
+    /** @brief Returns true if all the items starting after position can be shifted by delta frames.
+       This is not the case if an item or a mix crosses position, or if a backwards shift would overlap the items before position
+    */
+    bool canShift(int position, int delta) const;
+    /** @brief Returns a lambda that shifts all the clips and compositions starting after position by delta frames.
+       The blank at position is resized in Melt and the items are moved in one pass, so the cost does not depend on their number.
+       canShift must be checked before building it. The reverse operation is requestShift_lambda(position + delta, -delta)
+    */
+    Fun requestShift_lambda(int position, int delta);
+
     /** @brief Returns the size of the blank before or after the given clip
        @param clipId is the id of the clip
        @param after is true if we query the blank after, false otherwise
@@ -365,6 +375,19 @@ private:
      */
     std::map<int, int> m_compoPos;
 
+    /** We also index the clips of each sub-playlist by position, as {start: {clipId, end}} where end is excluded.
+     *  This index is updated by the insertion, deletion, resize and playlist switch operations, so that position queries do not go through Melt
+     */
+    std::map<int, std::pair<int, int>> m_clipPos[2];
+    /** The entry of each clip in m_clipPos, as {clipId: {playlist, start}} */
+    std::unordered_map<int, std::pair<int, int>> m_clipIndex;
+    /** @brief Record the current position and length of a clip, in the given sub-playlist */
+    void indexClip(int clipId, int playlist);
+    /** @brief Remove a clip from the position index */
+    void unindexClip(int clipId);
+    /** @brief Returns the id of the indexed clip at position in a sub-playlist, or -1 */
+    int indexedClipAt(int position, int playlist) const;
+
     /// This is a lock that ensures safety in case of concurrent access
     mutable QReadWriteLock m_lock;
     void reverseCompositionXml(const QString &composition, QDomElement xml);
@@ -109,7 +109,7 @@ public:
                     update();
                 } else {
                     // Clip changed, reset levels
-                    m_audioLevels.clear();
+                    m_audioLevels = AudioLevels();
                 }
             }
         });
@@ -128,6 +128,8 @@ public:
         if (m_audioLevels.isEmpty() && m_stream >= 0) {
             m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId, m_stream);
             if (m_audioLevels.isEmpty()) {
+                // Ask for the audio levels of on screen clips to be computed first
+                pCore->taskManager.markVisible(m_binId.toInt());
                 return;
             }
             m_audioMax = KdenliveSettings::normalizechannels() ? pCore->projectItemModel()->getAudioMaxLevel(m_binId, m_stream) : 0;
@@ -169,11 +171,33 @@ public:
             m_inPoint = qMin(m_inPoint, maxLength - m_channels);
         }
         int startPos = int(m_inPoint / indicesPrPixel);
+        // Each drawn column covers a range of frames, its peak is read from the matching level of the peak pyramid
+        double framesPerPixel = indicesPrPixel / m_channels;
+        int frameCount = maxLength / m_channels;
+        auto columnRange = [&](double i, int &first, int &last) {
+            if (reverse) {
+                first = qCeil((startPos - i - increment) * framesPerPixel);
+                last = qCeil((startPos - i) * framesPerPixel);
+                if (last < 0) {
+                    return false;
+                }
+            } else {
+                first = qCeil((startPos + i) * framesPerPixel);
+                last = qCeil((startPos + i + increment) * framesPerPixel);
+                if (first + 1 >= frameCount) {
+                    return false;
+                }
+            }
+            first = qMax(0, first);
+            last = qMax(first + 1, last);
+            return true;
+        };
         if (!KdenliveSettings::displayallchannels()) {
             // Draw merged channels
             double i = 0;
             int j = 0;
-            int idx = 0;
+            int first = 0;
+            int last = 0;
             QPainterPath path;
             if (pathDraw) {
                 path.moveTo(j - 1, height());
@@ -181,21 +205,11 @@ public:
             for (; i <= width(); j++) {
                 double level;
                 i = j * increment;
-                if (reverse) {
-                    idx = qCeil((startPos - i) * indicesPrPixel);
-                    idx -= idx % m_channels;
-                } else {
-                    idx = qCeil((startPos + i) * indicesPrPixel);
-                    idx += idx % m_channels;
-                }
-                i -= offset;
-                if (idx + m_channels >= maxLength || idx < 0) {
+                if (!columnRange(i, first, last)) {
                     break;
                 }
-                level = m_audioLevels.at(idx) / scaleFactor;
-                for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
-                }
+                i -= offset;
+                level = m_audioLevels.peak(-1, first, last) / scaleFactor;
                 if (pathDraw) {
                     double val = height() - level * height();
                     path.lineTo(i, val);
@@ -239,24 +253,18 @@ public:
                 painter->setOpacity(1);
                 double i = 0;
                 int j = 0;
-                int idx = 0;
+                int first = 0;
+                int last = 0;
                 for (; i <= width(); j++) {
                     i = j * increment;
-                    if (reverse) {
-                        idx = qCeil((startPos - i) * indicesPrPixel);
-                        idx -= idx % m_channels;
-                    } else {
-                        idx = qCeil((startPos + i) * indicesPrPixel);
-                        idx += idx % m_channels;
+                    if (!columnRange(i, first, last)) {
+                        break;
                     }
                     i -= offset;
-                    idx += channel;
-                    if (idx >= maxLength || idx < 0) break;
+                    level = m_audioLevels.peak(channel, first, last) * scaleFactor; // divide height by 510 (2*255) to get height
                     if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
                         path.lineTo(i, y - level);
                     } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
                         painter->drawLine(int(i), int(y - level), int(i), int(y + level));
                     }
                 }
@@ -282,7 +290,7 @@ Q_SIGNALS:
     void audioChannelsChanged();
 
 private:
-    QVector<uint8_t> m_audioLevels;
+    AudioLevels m_audioLevels;
     int m_inPoint;
     int m_outPoint;
     QString m_binId;
@@ -14,46 +14,225 @@
 
 #include <QCryptographicHash>
 #include <QDebug>
+#include <QMutex>
+#include <QThread>
+#include <QThreadPool>
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProfile.h>
 
+namespace {
+// A clip gets one more producer for this many pending requests
+const int RequestsPerProducer = 4;
+// Maximum number of producers decoding thumbnails of the same clip
+const int MaxProducersPerClip = 3;
+} // namespace
+
+/** @class ThumbnailResponse
+    @brief A thumbnail request, finished from the thumbnail threads
+ */
+class ThumbnailResponse : public QQuickImageResponse
+{
+public:
+    explicit ThumbnailResponse(int frameNumber)
+        : frame(frameNumber)
+    {
+    }
+    QQuickTextureFactory *textureFactory() const override { return QQuickTextureFactory::textureFactoryForImage(m_image); }
+    void cancel() override { m_canceled.storeRelease(1); }
+    bool isCanceled() const { return m_canceled.loadAcquire() == 1; }
+    /** @brief Deliver the image, the engine deletes the response after this */
+    void finish(const QImage &image)
+    {
+        m_image = image;
+        Q_EMIT finished();
+    }
+    /** @brief A response finished as soon as the engine listens to it */
+    static ThumbnailResponse *finished(const QImage &image)
+    {
+        auto *response = new ThumbnailResponse(-1);
+        QMetaObject::invokeMethod(
+            response, [response, image]() { response->finish(image); }, Qt::QueuedConnection);
+        return response;
+    }
+    const int frame;
+
+private:
+    QImage m_image;
+    QAtomicInt m_canceled;
+};
+
+/** @class ThumbnailRequestQueue
+    @brief The pending thumbnail requests of each clip, shared by the timeline and monitor providers.
+    It is created with the first provider and its threads are stopped when the last provider is deleted.
+ */
+class ThumbnailRequestQueue
+{
+public:
+    static std::shared_ptr<ThumbnailRequestQueue> shared()
+    {
+        static std::weak_ptr<ThumbnailRequestQueue> instance;
+        std::shared_ptr<ThumbnailRequestQueue> queue = instance.lock();
+        if (!queue) {
+            queue.reset(new ThumbnailRequestQueue());
+            instance = queue;
+        }
+        return queue;
+    }
+    ~ThumbnailRequestQueue()
+    {
+        QMutexLocker lk(&m_mutex);
+        m_closing = true;
+        lk.unlock();
+        // Workers that did not start are dropped, the running ones stop after their current thumbnail
+        m_pool.clear();
+        m_pool.waitForDone();
+        for (const ClipRequests &clip : qAsConst(m_clips)) {
+            for (ThumbnailResponse *response : clip.requests) {
+                response->finish(QImage());
+            }
+        }
+        m_clips.clear();
+    }
+    void add(const QString &binId, ThumbnailResponse *response)
+    {
+        QMutexLocker lk(&m_mutex);
+        ClipRequests &clip = m_clips[binId];
+        clip.requests.push_back(response);
+        // More visible thumbnails, more producers for the clip
+        const int wanted = qMin(MaxProducersPerClip, (int(clip.requests.size()) + RequestsPerProducer - 1) / RequestsPerProducer);
+        if (clip.producers < wanted) {
+            clip.producers++;
+            m_pool.start([this, binId]() { process(binId); });
+        }
+    }
+
+private:
+    ThumbnailRequestQueue() { m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount() / 2, 8)); }
+    /** @brief Decode the requests of a clip until there are none left */
+    void process(const QString &binId);
+    /** @brief Take the next request to decode, nullptr if there is none left for this producer */
+    ThumbnailResponse *takeRequest(const QString &binId, int position);
+    struct ClipRequests
+    {
+        std::vector<ThumbnailResponse *> requests;
+        int producers{0};
+    };
+    QMutex m_mutex;
+    QHash<QString, ClipRequests> m_clips;
+    bool m_closing{false};
+    /** @brief Serializes the clips that only have a shared thumbnail producer */
+    QMutex m_sharedProducerMutex;
+    QThreadPool m_pool;
+};
+
+ThumbnailResponse *ThumbnailRequestQueue::takeRequest(const QString &binId, int position)
+{
+    QMutexLocker lk(&m_mutex);
+    if (m_closing) {
+        // The remaining requests are finished by the destructor
+        return nullptr;
+    }
+    ClipRequests &clip = m_clips[binId];
+    std::vector<ThumbnailResponse *> &requests = clip.requests;
+    // Requests that were canceled before they started are not decoded
+    for (auto it = requests.begin(); it != requests.end();) {
+        if ((*it)->isCanceled()) {
+            (*it)->finish(QImage());
+            it = requests.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (requests.empty()) {
+        if (--clip.producers == 0) {
+            m_clips.remove(binId);
+        }
+        return nullptr;
+    }
+    // Keep decoding forward: take the closest frame after the last one, or restart from the first frame
+    auto best = requests.begin();
+    for (auto it = requests.begin() + 1; it != requests.end(); ++it) {
+        const bool after = (*it)->frame >= position;
+        const bool bestAfter = (*best)->frame >= position;
+        if (after != bestAfter ? after : (*it)->frame < (*best)->frame) {
+            best = it;
+        }
+    }
+    ThumbnailResponse *next = *best;
+    requests.erase(best);
+    return next;
+}
+
+void ThumbnailRequestQueue::process(const QString &binId)
+{
+    std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+    std::shared_ptr<Mlt::Producer> producer;
+    bool pooled = false;
+    if (binClip) {
+        producer = binClip->takeThumbProducer();
+        pooled = producer != nullptr;
+        if (!pooled) {
+            producer = binClip->thumbProducer();
+        }
+    }
+    int position = -1;
+    while (ThumbnailResponse *next = takeRequest(binId, position)) {
+        QImage result;
+        if (producer && producer->is_valid()) {
+            // Another producer may have decoded it meanwhile
+            result = ThumbnailCache::get()->getThumbnail(binClip->hashForThumbs(), binId, next->frame);
+            if (result.isNull()) {
+                if (pooled) {
+                    result = ThumbnailProvider::makeThumbnail(producer, next->frame, QSize());
+                } else {
+                    QMutexLocker lk(&m_sharedProducerMutex);
+                    result = ThumbnailProvider::makeThumbnail(producer, next->frame, QSize());
+                }
+                ThumbnailCache::get()->storeThumbnail(binId, next->frame, result, false);
+            }
+        }
+        position = next->frame;
+        next->finish(result);
+    }
+    if (pooled) {
+        binClip->releaseThumbProducer(producer);
+    }
+}
+
 ThumbnailProvider::ThumbnailProvider()
-    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
+    : m_queue(ThumbnailRequestQueue::shared())
 {
 }
 
 ThumbnailProvider::~ThumbnailProvider() = default;
 
-QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
-    QImage result;
+    Q_UNUSED(requestedSize)
     // id is binID/#frameNumber
     QString binId = id.section('/', 0, 0);
     bool ok;
     int frameNumber = id.section('#', -1).toInt(&ok);
-    if (ok) {
-        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-        if (binClip) {
-            int duration = binClip->frameDuration();
-            if (frameNumber > duration) {
-                // for endless loopable clips, we rewrite the position
-                frameNumber = frameNumber - ((frameNumber / duration) * duration);
-            }
-            result = ThumbnailCache::get()->getThumbnail(binClip->hashForThumbs(), binId, frameNumber);
-            if (!result.isNull()) {
-
-                *size = result.size();
-                return result;
-            }
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
-            if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
-                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
-            }
-        }
+    std::shared_ptr<ProjectClip> binClip = ok ? pCore->projectItemModel()->getClipByBinID(binId) : nullptr;
+    if (!binClip) {
+        return ThumbnailResponse::finished(QImage());
+    }
+    // The clip is on screen, its pending jobs should not wait behind the others
+    pCore->taskManager.markVisible(binId.toInt());
+    int duration = binClip->frameDuration();
+    if (duration > 0 && frameNumber > duration) {
+        // for endless loopable clips, we rewrite the position
+        frameNumber = frameNumber - ((frameNumber / duration) * duration);
+    }
+    // Decode the closest keyframe instead, the thumbnail is cached under its own position
+    frameNumber = binClip->thumbSeekPosition(frameNumber);
+    QImage result = ThumbnailCache::get()->getThumbnail(binClip->hashForThumbs(), binId, frameNumber);
+    if (!result.isNull()) {
+        return ThumbnailResponse::finished(result);
     }
-    if (size) *size = result.size();
-    return result;
+    auto *response = new ThumbnailResponse(frameNumber);
+    m_queue->add(binId, response);
+    return response;
 }
 
 QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber)
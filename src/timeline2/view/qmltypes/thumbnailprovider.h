@@ -14,14 +14,25 @@
 #include <mlt++/MltProducer.h>
 #include <mlt++/MltProfile.h>
 
-class ThumbnailProvider : public QQuickImageProvider
+class ThumbnailRequestQueue;
+
+/** @class ThumbnailProvider
+    @brief Provides the timeline thumbnails to QML.
+    Requests missing from the cache are decoded in a thread pool, with up to a few producers per clip
+    depending on the number of pending requests. Each producer decodes its requests in increasing frame
+    order and the requests canceled by QML, for example because they scrolled out of view, are dropped.
+ */
+class ThumbnailProvider : public QQuickAsyncImageProvider
 {
 public:
     explicit ThumbnailProvider();
     ~ThumbnailProvider() override;
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
 
 private:
-    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
+    friend class ThumbnailRequestQueue;
+    static QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
     QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
+    /** @brief The decoding threads and pending requests, shared with the other providers */
+    std::shared_ptr<ThumbnailRequestQueue> m_queue;
 };
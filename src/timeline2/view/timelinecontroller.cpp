@@ -3330,6 +3330,7 @@ void TimelineController::alignAudio(int clipId)
         clipsToAnalyse.insert(clipId);
     }
     QList<int> processedGroups;
+    QList<AudioEnvelope *> envelopes;
     int processed = 0;
     for (int cid : clipsToAnalyse) {
         if (!m_model->isClip(cid) || cid == m_audioRef) {
@@ -3367,9 +3368,12 @@ void TimelineController::alignAudio(int clipId)
         }
         processed++;
         // Perform audio calculation
-        auto *envelope =
-            new AudioEnvelope(otherBinId, cid, size_t(m_model->getClipIn(cid)), size_t(m_model->getClipPlaytime(cid)), size_t(m_model->getClipPosition(cid)));
-        m_audioCorrelator->addChild(envelope);
+        envelopes << new AudioEnvelope(otherBinId, cid, size_t(m_model->getClipIn(cid)), size_t(m_model->getClipPlaytime(cid)),
+                                       size_t(m_model->getClipPosition(cid)));
+    }
+    if (!envelopes.isEmpty()) {
+        // All the clips are aligned in one batch sharing the reference spectrum
+        m_audioCorrelator->addChildren(envelopes);
     }
     if (processed == 0) {
         // TODO: improve feedback message after freeze
@@ -5254,9 +5258,20 @@ void TimelineController::setMulticamIn(int pos)
     Q_EMIT multicamInChanged();
 }
 
-void TimelineController::checkClipPosition(const QModelIndex &topLeft, const QModelIndex &, const QVector<int> &roles)
+void TimelineController::checkClipPosition(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
 {
     if (roles.contains(TimelineModel::StartRole)) {
+        if (topLeft.row() != bottomRight.row() && topLeft.parent().isValid()) {
+            // All the items of a track were shifted at once
+            auto track = m_model->getTrackById_const(int(topLeft.parent().internalId()));
+            for (const auto &clip : track->m_allClips) {
+                Q_EMIT updateAssetPosition(clip.first);
+            }
+            for (const auto &composition : track->m_allCompositions) {
+                Q_EMIT updateAssetPosition(composition.first);
+            }
+            return;
+        }
         int id = int(topLeft.internalId());
         if (m_model->isComposition(id) || m_model->isClip(id)) {
             Q_EMIT updateAssetPosition(id);
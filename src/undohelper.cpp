@@ -8,16 +8,45 @@
 #include "logger.hpp"
 #endif
 #include <QDebug>
+#include <QDomNode>
+#include <QTextStream>
 #include <utility>
-FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
+
+namespace {
+// The command, its text and the chain of closures built by the undo macros
+const qint64 commandCost = 1024;
+} // namespace
+
+FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, qint64 payloadSize, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_undo(std::move(undo))
     , m_redo(std::move(redo))
     , m_undone(false)
+    , m_memoryCost(commandCost + payloadSize)
 {
     setText(text);
 }
 
+qint64 FunctionalUndoCommand::memoryCost() const
+{
+    return m_memoryCost;
+}
+
+void FunctionalUndoCommand::release()
+{
+    m_undo = Fun();
+    m_redo = Fun();
+    m_memoryCost = 0;
+}
+
+qint64 FunctionalUndoCommand::xmlSize(const QDomNode &node)
+{
+    QString xml;
+    QTextStream stream(&xml);
+    node.save(stream, 0);
+    return xml.size() * qint64(sizeof(QChar));
+}
+
 void FunctionalUndoCommand::undo()
 {
     // qDebug() << "UNDOING " <<text();
@@ -25,13 +54,17 @@ void FunctionalUndoCommand::undo()
     Logger::log_undo(true);
 #endif
     m_undone = true;
+    if (!m_undo) {
+        // Released to free memory, the stack removes it without undoing
+        return;
+    }
     bool res = m_undo();
     Q_ASSERT(res);
 }
 
 void FunctionalUndoCommand::redo()
 {
-    if (m_undone) {
+    if (m_undone && m_redo) {
         // qDebug() << "REDOING " <<text();
 #ifdef CRASH_AUTO_TEST
         Logger::log_undo(false);
@@ -27,6 +27,8 @@ using Fun = std::function<bool(void)>;
 
 #include <QUndoCommand>
 
+class QDomNode;
+
 /** @brief this is a generic class that takes fonctors as undo and redo actions. It just executes them when required by Qt
   Note that QUndoStack actually executes redo() when we push the undoCommand to the stack
   This is bad for us because we execute the command as we construct the undo Function. So to prevent it to be executed twice, there is a small hack in this
@@ -35,11 +37,19 @@ using Fun = std::function<bool(void)>;
 class FunctionalUndoCommand : public QUndoCommand
 {
 public:
-    FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent = nullptr);
+    /** @param payloadSize is the size in bytes of the data captured by the functions that the command keeps alive, like XML or parameter values */
+    FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, qint64 payloadSize = 0, QUndoCommand *parent = nullptr);
     void undo() override;
     void redo() override;
+    /** @brief Estimated memory used by the undo and redo functions, in bytes */
+    qint64 memoryCost() const;
+    /** @brief Free the undo and redo functions, the command cannot be undone anymore */
+    void release();
+    /** @brief Approximate memory used by a copy of @p node kept by the functions, in bytes */
+    static qint64 xmlSize(const QDomNode &node);
 
 private:
     Fun m_undo, m_redo;
     bool m_undone;
+    qint64 m_memoryCost;
 };
@@ -0,0 +1,201 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "probecache.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <mlt++/MltProducer.h>
+
+std::unique_ptr<ProbeCache> ProbeCache::instance;
+std::once_flag ProbeCache::m_onceFlag;
+
+ProbeCache::ProbeCache(const QString &cacheRoot)
+    : m_dir(cacheRoot)
+{
+    m_valid = m_dir.mkpath(QStringLiteral("probes")) && m_dir.cd(QStringLiteral("probes"));
+}
+
+std::unique_ptr<ProbeCache> &ProbeCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new ProbeCache(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))); });
+    return instance;
+}
+
+QString ProbeCache::entryName(const QFileInfo &info) const
+{
+    if (!m_valid || !info.isFile()) {
+        return QString();
+    }
+    // The size and modification time are part of the name, so that a modified file never matches an older entry
+    const QString key = QStringLiteral("%1|%2|%3").arg(info.absoluteFilePath()).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+    return QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+QJsonObject ProbeCache::readEntry(const QString &path) const
+{
+    const QString name = entryName(QFileInfo(path));
+    if (name.isEmpty()) {
+        return QJsonObject();
+    }
+    QFile file(m_dir.absoluteFilePath(name + QStringLiteral(".json")));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QJsonObject();
+    }
+    return QJsonDocument::fromJson(file.readAll()).object();
+}
+
+void ProbeCache::updateEntry(const QString &path, const QJsonObject &values)
+{
+    const QString name = entryName(QFileInfo(path));
+    if (name.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&m_mutex);
+    QJsonObject entry = readEntry(path);
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        entry.insert(it.key(), it.value());
+    }
+    entry.insert(QStringLiteral("path"), path);
+    // The folder may have been deleted from the cache management dialog
+    m_dir.mkpath(QStringLiteral("."));
+    QSaveFile file(m_dir.absoluteFilePath(name + QStringLiteral(".json")));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+QString ProbeCache::hash(const QString &path) const
+{
+    return readEntry(path).value(QStringLiteral("hash")).toString();
+}
+
+QMap<QString, QString> ProbeCache::properties(const QString &path) const
+{
+    QMap<QString, QString> result;
+    const QJsonObject properties = readEntry(path).value(QStringLiteral("properties")).toObject();
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        result.insert(it.key(), it.value().toString());
+    }
+    return result;
+}
+
+QString ProbeCache::thumbnailPath(const QString &name, const QString &variant) const
+{
+    const QByteArray variantHash = QCryptographicHash::hash(variant.toUtf8(), QCryptographicHash::Md5).toHex();
+    return m_dir.absoluteFilePath(QStringLiteral("%1-%2.png").arg(name, QString::fromLatin1(variantHash)));
+}
+
+QImage ProbeCache::thumbnail(const QString &path, const QString &variant) const
+{
+    const QString name = entryName(QFileInfo(path));
+    if (name.isEmpty()) {
+        return QImage();
+    }
+    const QString thumbPath = thumbnailPath(name, variant);
+    if (!QFile::exists(thumbPath)) {
+        return QImage();
+    }
+    return QImage(thumbPath);
+}
+
+void ProbeCache::storeHash(const QString &path, const QString &hash)
+{
+    if (!hash.isEmpty()) {
+        updateEntry(path, {{QStringLiteral("hash"), hash}});
+    }
+}
+
+void ProbeCache::storeProperties(const QString &path, const QMap<QString, QString> &properties)
+{
+    QJsonObject values;
+    for (auto it = properties.constBegin(); it != properties.constEnd(); ++it) {
+        values.insert(it.key(), it.value());
+    }
+    updateEntry(path, {{QStringLiteral("properties"), values}});
+}
+
+void ProbeCache::storeMedia(const QString &path, Mlt::Producer &producer)
+{
+    if (!producer.is_valid() || producer.get_fps() <= 0.) {
+        return;
+    }
+    QMap<QString, QString> properties;
+    const int count = producer.count();
+    for (int i = 0; i < count; ++i) {
+        const QString name = QString::fromUtf8(producer.get_name(i));
+        if (name.startsWith(QLatin1String("meta.media."))) {
+            properties.insert(name, QString::fromUtf8(producer.get(i)));
+        }
+    }
+    properties.insert(QStringLiteral("duration"), QString::number(producer.get_length() / producer.get_fps(), 'f', 6));
+    storeProperties(path, properties);
+}
+
+void ProbeCache::storeThumbnail(const QString &path, const QString &variant, const QImage &img)
+{
+    const QString name = entryName(QFileInfo(path));
+    if (name.isEmpty() || img.isNull()) {
+        return;
+    }
+    m_dir.mkpath(QStringLiteral("."));
+    QSaveFile file(thumbnailPath(name, variant));
+    if (file.open(QIODevice::WriteOnly) && img.save(&file, "PNG")) {
+        file.commit();
+    }
+}
+
+qint64 ProbeCache::prune(const QDateTime &date)
+{
+    if (!m_valid) {
+        return 0;
+    }
+    QMutexLocker locker(&m_mutex);
+    qint64 removed = 0;
+    QSet<QString> entries;
+    QSet<QString> removedEntries;
+    const QFileInfoList files = m_dir.entryInfoList({QStringLiteral("*.json")}, QDir::Files);
+    for (const QFileInfo &info : files) {
+        const QString name = info.completeBaseName();
+        bool obsolete = info.lastModified() < date;
+        if (!obsolete) {
+            // Entries of files that were modified or deleted are never matched again
+            QFile file(info.absoluteFilePath());
+            if (file.open(QIODevice::ReadOnly)) {
+                const QString path = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("path")).toString();
+                obsolete = entryName(QFileInfo(path)) != name;
+            }
+        }
+        if (obsolete && QFile::remove(info.absoluteFilePath())) {
+            removed += info.size();
+            removedEntries << name;
+        } else {
+            entries << name;
+        }
+    }
+    // Remove the thumbnails of the removed entries. Recent thumbnails without entry are kept, they can be stored before it
+    const QFileInfoList thumbs = m_dir.entryInfoList({QStringLiteral("*.png")}, QDir::Files);
+    for (const QFileInfo &info : thumbs) {
+        const QString name = info.completeBaseName().section(QLatin1Char('-'), 0, 0);
+        const bool obsolete = removedEntries.contains(name) || (!entries.contains(name) && info.lastModified() < date);
+        if (obsolete && QFile::remove(info.absoluteFilePath())) {
+            removed += info.size();
+        }
+    }
+    return removed;
+}
+
+QString ProbeCache::folder() const
+{
+    return m_dir.absolutePath();
+}
@@ -0,0 +1,80 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QDateTime>
+#include <QDir>
+#include <QImage>
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <memory>
+#include <mutex>
+
+class QFileInfo;
+namespace Mlt {
+class Producer;
+}
+
+/** @class ProbeCache
+    @brief This class stores the result of probing media files, so that unchanged files don't need to be opened again.
+    The cache is independent of the projects, it lives in the user's cache folder and is shared by all projects.
+    Each file has its own small json entry holding the file hash and the media properties (streams, codecs, fps
+    and duration in seconds). Entries are keyed by the path, size and modification time of the file, so that
+    a modified file is probed again. The first frame thumbnails are stored as images next to it, one for each
+    combination of the producer properties affecting the image (video stream, rotation, aspect ratio...).
+    Entries are refreshed each time a clip using the file is loaded, old ones are removed by prune().
+ * Note that this class is a Singleton
+ */
+class ProbeCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<ProbeCache> &get();
+
+    /** @brief Returns the cached hash of a file, empty if the file is not cached or was modified */
+    QString hash(const QString &path) const;
+    /** @brief Returns the cached media properties of a file, empty if the file is not cached or was modified.
+       The duration of the media in seconds is stored in the "duration" key.
+     */
+    QMap<QString, QString> properties(const QString &path) const;
+    /** @brief Returns the cached first frame of a file
+       @param variant lists the producer properties affecting the image, as name=value pairs */
+    QImage thumbnail(const QString &path, const QString &variant) const;
+
+    void storeHash(const QString &path, const QString &hash);
+    void storeProperties(const QString &path, const QMap<QString, QString> &properties);
+    /** @brief Store the media properties of a producer opening the file, its length is converted to seconds */
+    void storeMedia(const QString &path, Mlt::Producer &producer);
+    void storeThumbnail(const QString &path, const QString &variant, const QImage &img);
+    /** @brief Remove the entries last updated before @p date and the ones of files that were modified or deleted
+       @returns the size of the removed files in bytes */
+    qint64 prune(const QDateTime &date);
+    /** @brief Returns the folder of the cache */
+    QString folder() const;
+
+protected:
+    // Constructor is protected because class is a Singleton
+    explicit ProbeCache(const QString &cacheRoot);
+
+    // Returns the base name of the files of an entry, empty if the path is not a file
+    QString entryName(const QFileInfo &info) const;
+    // Read the entry of a file, empty if it does not match the file anymore
+    QJsonObject readEntry(const QString &path) const;
+    // Update some fields of the entry of a file
+    void updateEntry(const QString &path, const QJsonObject &values);
+    // Path of the thumbnail of an entry for a variant
+    QString thumbnailPath(const QString &name, const QString &variant) const;
+
+    static std::unique_ptr<ProbeCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the repository only once;
+
+    QDir m_dir;
+    bool m_valid;
+    // m_mutex serializes the updates and removals of the entries, reads rely on the atomic write of the entries
+    QMutex m_mutex;
+};
@@ -10,6 +10,7 @@
 #include "doc/kdenlivedoc.h"
 #include "project/projectmanager.h"
 #include <QDir>
+#include <QFile>
 #include <QMutexLocker>
 #include <list>
 
@@ -24,63 +25,87 @@ public:
     {
     }
 
-    bool contains(const QString &key) const { return m_cache.count(key) > 0; }
+    bool contains(const CacheKey &key) const
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_cache.count(key) > 0;
+    }
+
+    void remove(const CacheKey &key)
+    {
+        QMutexLocker locker(&m_mutex);
+        removeLocked(key);
+    }
 
-    void remove(const QString &key)
+    /** @brief Remove all the entries of a clip from this shard */
+    void removeClip(quint64 clip)
     {
-        if (!contains(key)) {
+        QMutexLocker locker(&m_mutex);
+        auto positions = m_clipIndex.find(clip);
+        if (positions == m_clipIndex.end()) {
             return;
         }
-        auto it = m_cache.at(key);
-        m_currentCost -= (*it).second.second;
-        // Need to erase reference to iterator before erasing what it points to.
-        // Fixes BUG 463764.
-        m_cache.erase(key);
-        m_data.erase(it);
+        // Copy positions since removeLocked updates the index
+        const std::vector<int> toRemove(positions->second.begin(), positions->second.end());
+        for (int pos : toRemove) {
+            removeLocked({clip, pos});
+        }
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    void insert(const CacheKey &key, const QImage &img, int cost)
     {
         if (cost > m_maxCost) {
             return;
         }
+        QMutexLocker locker(&m_mutex);
+        // if the cache already contains this entry, replace it
+        removeLocked(key);
         m_data.push_front({key, {img, cost}});
         auto it = m_data.begin();
         m_cache[key] = it;
+        m_clipIndex[key.clip].insert(key.pos);
         m_currentCost += cost;
         while (m_currentCost > m_maxCost) {
-            remove(m_data.back().first);
+            removeLocked(m_data.back().first);
         }
     }
 
-    QImage get(const QString &key)
+    QImage get(const CacheKey &key)
     {
-        if (!contains(key)) {
+        QMutexLocker locker(&m_mutex);
+        auto found = m_cache.find(key);
+        if (found == m_cache.end()) {
             return QImage();
         }
         // when a get operation occurs, we put the corresponding list item in front to remember last access
-        std::pair<QString, std::pair<QImage, int>> data;
-        auto it = m_cache.at(key);
-        std::swap(data, (*it));                                         // take data out without copy
-        QImage result = data.second.first;                              // a copy occurs here
-        m_data.erase(it);                                               // delete old iterator
-        m_cache[key] = m_data.emplace(m_data.begin(), std::move(data)); // reinsert without copy and store iterator
-        return result;
+        auto it = found->second;
+        m_data.splice(m_data.begin(), m_data, it); // move item to front, iterators remain valid
+        return it->second.first;                   // a copy occurs here
     }
     void clear()
     {
+        QMutexLocker locker(&m_mutex);
         m_data.clear();
         m_cache.clear();
+        m_clipIndex.clear();
         m_currentCost = 0;
     }
     bool checkIntegrity() const
     {
+        QMutexLocker locker(&m_mutex);
         if (m_data.size() != m_cache.size()) {
             // Cache is corrupted
             return false;
         }
+        size_t indexed = 0;
+        for (const auto &positions : m_clipIndex) {
+            indexed += positions.second.size();
+        }
+        if (indexed != m_data.size()) {
+            return false;
+        }
         for (const auto &d : m_data) {
-            if (!contains(d.first)) {
+            if (m_cache.count(d.first) == 0) {
                 return false;
             }
         }
@@ -88,21 +113,66 @@ public:
     }
 
 protected:
+    void removeLocked(const CacheKey &key)
+    {
+        auto found = m_cache.find(key);
+        if (found == m_cache.end()) {
+            return;
+        }
+        auto it = found->second;
+        m_currentCost -= (*it).second.second;
+        // Need to erase reference to iterator before erasing what it points to.
+        // Fixes BUG 463764.
+        m_cache.erase(found);
+        auto positions = m_clipIndex.find(key.clip);
+        if (positions != m_clipIndex.end()) {
+            positions->second.erase(key.pos);
+            if (positions->second.empty()) {
+                m_clipIndex.erase(positions);
+            }
+        }
+        m_data.erase(it);
+    }
+
     int m_maxCost;
     int m_currentCost{0};
+    mutable QMutex m_mutex;
 
     // The data is stored as (key,(image, cost)) in a std::list that serves as a
     // FIFO queue. If m_maxCost is exceeded, elements are removed from the
     // end of the list until the sum of the costs in the list is less than m_maxCost.
-    std::list<std::pair<QString, std::pair<QImage, int>>> m_data;
+    std::list<std::pair<CacheKey, std::pair<QImage, int>>> m_data;
     // m_cache keeps a mapping from the key to an iterator that represents the
     // item's location in m_data, like a pointer.
-    std::unordered_map<QString, decltype(m_data.begin())> m_cache;
+    std::unordered_map<CacheKey, decltype(m_data.begin()), CacheKeyHash> m_cache;
+    // m_clipIndex keeps track of the positions stored in this shard for each clip
+    std::unordered_map<quint64, std::unordered_set<int>> m_clipIndex;
 };
 
+namespace {
+quint64 mixKey(quint64 clip, int pos)
+{
+    // splitmix64 finalizer, so that neighbour frames of a clip spread over all shards
+    quint64 x = clip ^ (quint64(quint32(pos)) * 0x9E3779B97F4A7C15ULL);
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+} // namespace
+
+size_t ThumbnailCache::CacheKeyHash::operator()(const CacheKey &key) const
+{
+    return size_t(mixKey(key.clip, key.pos));
+}
+
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
 {
+    for (auto &cache : m_volatileCache) {
+        cache.reset(new Cache_t(10000000 / ShardCount));
+    }
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -111,40 +181,49 @@ std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
     return instance;
 }
 
+ThumbnailCache::Cache_t &ThumbnailCache::shard(const CacheKey &key) const
+{
+    // Use the high bits, the low ones are used for the buckets of the shard's hash map
+    return *m_volatileCache[(mixKey(key.clip, key.pos) >> 56) % ShardCount];
+}
+
 bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = pos < 0 ? getAudioKey(binId, &ok).constFirst() : getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
+    const QString hash = pos < 0 ? getAudioKey(binId, &ok).value(0) : getHash(binId, &ok);
+    if (!ok || (pos < 0 && hash.isEmpty())) {
+        return false;
+    }
+    const CacheKey key = volatileKey(hash.isEmpty() ? localHash(binId) : hash, pos);
+    if (shard(key).contains(key)) {
         return true;
     }
-    if (!ok || volatileOnly) {
+    if (volatileOnly || hash.isEmpty()) {
         return false;
     }
-    locker.unlock();
-    QDir thumbFolder = getDir(pos < 0, &ok);
-    return ok && thumbFolder.exists(key);
+    if (pos < 0) {
+        QDir thumbFolder = getDir(true, &ok);
+        return ok && thumbFolder.exists(hash);
+    }
+    auto thumbPack = pack(hash);
+    return thumbPack && thumbPack->contains(pos);
 }
 
 QImage ThumbnailCache::getAudioThumbnail(const QString &binId, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = getAudioKey(binId, &ok).constFirst();
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
+    auto audioKey = getAudioKey(binId, &ok).value(0);
+    if (!ok || audioKey.isEmpty()) {
         return QImage();
     }
+    const CacheKey key = volatileKey(audioKey, -1);
+    QImage img = shard(key).get(key);
+    if (!img.isNull() || volatileOnly) {
+        return img;
+    }
     QDir thumbFolder = getDir(true, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        if (std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), -1) != m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(-1);
-        }
-        locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(key));
+    if (ok && thumbFolder.exists(audioKey)) {
+        return QImage(thumbFolder.absoluteFilePath(audioKey));
     }
     return QImage();
 }
@@ -168,169 +247,227 @@ const QList<QUrl> ThumbnailCache::getAudioThumbPath(const QString &binId) const
 QImage ThumbnailCache::getThumbnail(QString hash, const QString &binId, int pos, bool volatileOnly) const
 {
     if (hash.isEmpty()) {
-        return QImage();
-    }
-    hash.append(QString("#%1.jpg").arg(pos));
-    QMutexLocker locker(&m_mutex);
-    if (m_volatileCache->contains(hash)) {
-        return m_volatileCache->get(hash);
+        if (binId.isEmpty()) {
+            return QImage();
+        }
+        // Clips without file hash only have volatile thumbnails
+        const CacheKey key = volatileKey(localHash(binId), pos);
+        return shard(key).get(key);
     }
-    if (volatileOnly) {
-        return QImage();
+    const CacheKey key = volatileKey(hash, pos);
+    QImage img = shard(key).get(key);
+    if (!img.isNull() || volatileOnly) {
+        return img;
     }
-    bool ok = false;
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(hash)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
-        locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(hash));
+    auto thumbPack = pack(hash);
+    if (thumbPack) {
+        img = thumbPack->get(pos);
     }
-    locker.unlock();
-    return QImage();
+    return img;
 }
 
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
-    }
-    if (!ok || volatileOnly) {
+    const QString hash = getHash(binId, &ok);
+    if (!ok) {
         return QImage();
     }
-    QDir thumbFolder = getDir(false, &ok);
-    if (ok && thumbFolder.exists(key)) {
-        if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-            std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-            m_storedOnDisk[binId].push_back(pos);
-        }
-        locker.unlock();
-        return QImage(thumbFolder.absoluteFilePath(key));
-    }
-    return QImage();
+    return getThumbnail(hash, binId, pos, volatileOnly);
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
 {
-    QMutexLocker locker(&m_mutex);
     bool ok = false;
-    const QString key = getKey(binId, pos, &ok);
+    const QString hash = getHash(binId, &ok);
     if (!ok) {
         return;
     }
-    // if volatile cache also contains this entry, update it
-    if (m_volatileCache->contains(key)) {
-        m_volatileCache->remove(key);
-    } else {
-        m_storedVolatile[binId].push_back(pos);
-    }
-    m_volatileCache->insert(key, img, (int)img.sizeInBytes());
-    if (persistent) {
-        QDir thumbFolder = getDir(false, &ok);
-        if (ok) {
-            if (m_storedOnDisk.find(binId) == m_storedOnDisk.end() ||
-                std::find(m_storedOnDisk[binId].begin(), m_storedOnDisk[binId].end(), pos) == m_storedOnDisk[binId].end()) {
-                m_storedOnDisk[binId].push_back(pos);
-            }
-            locker.unlock();
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB in: " << thumbFolder.absoluteFilePath(key);
-            }
+    const CacheKey key = volatileKey(hash.isEmpty() ? localHash(binId) : hash, pos);
+    // if volatile cache also contains this entry, it is replaced
+    shard(key).insert(key, img, int(img.sizeInBytes()));
+    if (persistent && !hash.isEmpty()) {
+        auto thumbPack = pack(hash);
+        if (thumbPack && !thumbPack->append({{pos, img}})) {
+            qDebug() << ".............\n!!!!!!!! ERROR SAVING THUMB for clip: " << binId;
         }
     }
 }
 
 bool ThumbnailCache::checkIntegrity() const
 {
-    return m_volatileCache->checkIntegrity();
+    for (const auto &cache : m_volatileCache) {
+        if (!cache->checkIntegrity()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void ThumbnailCache::saveCachedThumbs(const std::unordered_map<QString, std::vector<int>> &keys)
 {
-    bool ok;
-    QDir thumbFolder = getDir(false, &ok);
-    if (!ok) {
-        return;
-    }
-    QMutexLocker locker(&m_mutex);
     for (auto &key : keys) {
         bool ok;
-        for (const auto &pos : key.second) {
-            if (m_storedOnDisk.find(key.first) == m_storedOnDisk.end() ||
-                std::find(m_storedOnDisk[key.first].begin(), m_storedOnDisk[key.first].end(), pos) == m_storedOnDisk[key.first].end()) {
-                const QString thumbKey = getKey(key.first, pos, &ok);
-                if (!ok) {
-                    continue;
-                }
-                if (!thumbFolder.exists(thumbKey) && m_volatileCache->contains(thumbKey)) {
-                    QImage img = m_volatileCache->get(thumbKey);
-                    if (!img.save(thumbFolder.absoluteFilePath(thumbKey))) {
-                        qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                        break;
-                    } else {
-                        m_storedOnDisk[key.first].push_back(pos);
-                    }
-                }
+        const QString hash = getHash(key.first, &ok);
+        if (!ok || hash.isEmpty()) {
+            continue;
+        }
+        auto thumbPack = pack(hash);
+        if (!thumbPack) {
+            return;
+        }
+        // Collect all missing thumbnails of the clip and write them in one append
+        std::vector<std::pair<int, QImage>> toSave;
+        for (int pos : key.second) {
+            if (thumbPack->contains(pos)) {
+                continue;
             }
+            const CacheKey thumbKey = volatileKey(hash, pos);
+            QImage img = shard(thumbKey).get(thumbKey);
+            if (!img.isNull()) {
+                toSave.push_back({pos, img});
+            }
+        }
+        if (!toSave.empty() && !thumbPack->append(toSave)) {
+            qDebug() << "// Error writing thumbnails for clip " << key.first;
+            return;
         }
     }
 }
 
-void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
+void ThumbnailCache::saveThumbnails(const QString &binId, const std::vector<std::pair<int, QImage>> &thumbs)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
-            }
-        }
-        m_storedVolatile.erase(binId);
+    bool ok = false;
+    const QString hash = getHash(binId, &ok);
+    if (!ok || hash.isEmpty() || thumbs.empty()) {
+        return;
     }
+    auto thumbPack = pack(hash);
+    if (thumbPack && !thumbPack->append(thumbs)) {
+        qDebug() << "// Error writing thumbnails for clip " << binId;
+    }
+}
+
+void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
+{
     bool ok = false;
-    // Video thumbs
-    QStringList files;
-    if (m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
-        // Remove persistent cache
-        for (const auto &pos : m_storedOnDisk.at(binId)) {
-            if (pos >= 0) {
-                auto key = getKey(binId, pos, &ok);
-                if (ok) {
-                    files << key;
-                }
-            }
-        }
-        m_storedOnDisk.erase(binId);
+    const QString hash = getHash(binId, &ok);
+    if (!ok) {
+        return;
+    }
+    const quint64 clip = volatileKey(hash.isEmpty() ? localHash(binId) : hash, 0).clip;
+    for (auto &cache : m_volatileCache) {
+        cache->removeClip(clip);
+    }
+    if (hash.isEmpty()) {
+        return;
+    }
+    // Remove persistent cache
+    QMutexLocker locker(&m_mutex);
+    std::shared_ptr<ThumbnailPack> thumbPack;
+    auto found = m_packs.find(hash);
+    if (found != m_packs.end()) {
+        thumbPack = found->second;
+        m_packs.erase(found);
     }
     // Release mutex before deleting files
     locker.unlock();
-    if (!files.isEmpty()) {
+    if (thumbPack) {
+        thumbPack->remove();
+    } else {
         QDir thumbFolder = getDir(false, &ok);
         if (ok) {
-            while (!files.isEmpty()) {
-                thumbFolder.remove(files.takeFirst());
-            }
+            thumbFolder.remove(hash + ThumbnailPack::extension);
         }
     }
 }
 
 void ThumbnailCache::clearCache()
 {
+    for (auto &cache : m_volatileCache) {
+        cache->clear();
+    }
     QMutexLocker locker(&m_mutex);
-    m_volatileCache->clear();
-    m_storedVolatile.clear();
-    m_storedOnDisk.clear();
+    m_packs.clear();
+}
+
+qint64 ThumbnailCache::persistentCacheSize() const
+{
+    bool ok = false;
+    QDir thumbFolder = getDir(false, &ok);
+    if (!ok) {
+        return 0;
+    }
+    qint64 total = 0;
+    const QFileInfoList files = thumbFolder.entryInfoList(QDir::Files);
+    for (const QFileInfo &info : files) {
+        total += info.size();
+    }
+    return total;
+}
+
+void ThumbnailCache::clearPersistentCache()
+{
+    QMutexLocker locker(&m_mutex);
+    auto packs = std::move(m_packs);
+    m_packs.clear();
+    locker.unlock();
+    for (auto &thumbPack : packs) {
+        thumbPack.second->remove();
+    }
+}
+
+std::shared_ptr<ThumbnailPack> ThumbnailCache::pack(const QString &hash) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto found = m_packs.find(hash);
+    if (found != m_packs.end()) {
+        return found->second;
+    }
+    bool ok = false;
+    QDir thumbFolder = getDir(false, &ok);
+    if (!ok) {
+        return nullptr;
+    }
+    auto thumbPack = std::make_shared<ThumbnailPack>(thumbFolder.absoluteFilePath(hash + ThumbnailPack::extension));
+    m_packs[hash] = thumbPack;
+    locker.unlock();
+    migrateLegacyThumbs(thumbFolder, hash, *thumbPack.get());
+    return thumbPack;
+}
+
+// static
+void ThumbnailCache::migrateLegacyThumbs(const QDir &thumbFolder, const QString &hash, ThumbnailPack &thumbPack)
+{
+    const QString prefix = hash + QLatin1Char('#');
+    const QStringList legacyFiles = thumbFolder.entryList({prefix + QStringLiteral("*.jpg")}, QDir::Files);
+    if (legacyFiles.isEmpty()) {
+        return;
+    }
+    // The files are already JPEG encoded, copy their data as is
+    std::vector<std::pair<int, QByteArray>> thumbs;
+    for (const QString &fileName : legacyFiles) {
+        bool ok = false;
+        const int pos = fileName.mid(prefix.length()).chopped(4).toInt(&ok);
+        if (!ok || thumbPack.contains(pos)) {
+            continue;
+        }
+        QFile file(thumbFolder.absoluteFilePath(fileName));
+        if (file.open(QIODevice::ReadOnly)) {
+            thumbs.push_back({pos, file.readAll()});
+        }
+    }
+    if (!thumbPack.appendEncoded(thumbs)) {
+        // Keep the files, we will try again next time
+        return;
+    }
+    for (const QString &fileName : legacyFiles) {
+        thumbFolder.remove(fileName);
+    }
 }
 
 // static
-QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
+QString ThumbnailCache::getHash(const QString &binId, bool *ok)
 {
     if (binId.isEmpty()) {
         *ok = false;
@@ -341,7 +478,22 @@ QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
     if (!*ok) {
         return QString();
     }
-    return binClip->hashForThumbs() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".jpg");
+    return binClip->hashForThumbs();
+}
+
+// static
+QString ThumbnailCache::localHash(const QString &binId)
+{
+    // Cannot collide with a file hash or a sequence uuid
+    return QLatin1Char('#') + binId;
+}
+
+// static
+ThumbnailCache::CacheKey ThumbnailCache::volatileKey(const QString &hash, int pos)
+{
+    // Two differently seeded 32 bit hashes make collisions between clips very unlikely
+    const quint64 clip = (quint64(qHash(hash, 0x9E3779B9U)) << 32) | quint64(qHash(hash));
+    return {clip, pos};
 }
 
 // static
@@ -6,22 +6,28 @@
 #pragma once
 
 #include "definitions.h"
+#include "utils/thumbnailpack.hpp"
 #include <QDir>
 #include <QImage>
 #include <QMutex>
 #include <QUrl>
+#include <array>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 /** @class ThumbnailCache
     @brief This class class is an interface to the caches that store thumbnails.
     In Kdenlive, we use two such caches, a persistent that is stored on disk to allow thumbnails to be reused when reopening.
+    The persistent cache stores all the thumbnails of a clip in a single packed file (see ThumbnailPack).
     The other one is a volatile LRU cache that lives in memory.
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in several shards, each one with its own lock, so that the many threads used by
+    the QML thumbnail provider don't all wait on a single mutex. Entries are keyed by a compact (clip hash, frame) pair.
  * Note that this class is a Singleton
  */
 class ThumbnailCache
@@ -58,21 +64,50 @@ public:
     /** @brief Removes all the thumbnails for a given clip */
     void invalidateThumbsForClip(const QString &binId);
 
-    /** @brief Save all cached thumbs to disk */
+    /** @brief Save all cached thumbs to disk, appending them in one batch per clip */
     void saveCachedThumbs(const std::unordered_map<QString, std::vector<int>> &keys);
 
+    /** @brief Write generated thumbnails of a clip to the persistent cache in one batch, without going through the volatile cache */
+    void saveThumbnails(const QString &binId, const std::vector<std::pair<int, QImage>> &thumbs);
+
     /** @brief Reset cache (discarding all thumbs stored in memory) */
     void clearCache();
 
+    /** @brief Size on disk of the persistent thumbnail cache of the current project */
+    qint64 persistentCacheSize() const;
+
+    /** @brief Close and delete all the persistent thumbnail files of the current project */
+    void clearPersistentCache();
+
     /** @brief Ensure the cache is not corrupted */
     bool checkIntegrity() const;
 
+    /** @brief Compact key identifying a thumbnail in the volatile cache */
+    struct CacheKey
+    {
+        quint64 clip;
+        int pos;
+        bool operator==(const CacheKey &other) const { return clip == other.clip && pos == other.pos; }
+    };
+    struct CacheKeyHash
+    {
+        size_t operator()(const CacheKey &key) const;
+    };
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
 
-    // Return the key associated to a thumbnail
-    static QString getKey(const QString &binId, int pos, bool *ok);
+    // Return the hash used to identify the thumbnails of a clip
+    static QString getHash(const QString &binId, bool *ok);
+    // Return the hash identifying the volatile thumbnails of a clip that has no file hash, like color clips
+    static QString localHash(const QString &binId);
+    // Build the volatile cache key from a clip hash
+    static CacheKey volatileKey(const QString &hash, int pos);
+    // Return the packed persistent cache of a clip, nullptr if there is no cache dir
+    std::shared_ptr<ThumbnailPack> pack(const QString &hash) const;
+    // Move the thumbnails stored as one <hash>#<pos>.jpg file per frame by older versions into the pack
+    static void migrateLegacyThumbs(const QDir &thumbFolder, const QString &hash, ThumbnailPack &thumbPack);
     static QStringList getAudioKey(const QString &binId, bool *ok);
 
     // Return the dir where the persistent cache lives
@@ -81,12 +116,14 @@ protected:
     static std::unique_ptr<ThumbnailCache> instance;
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
+    static constexpr int ShardCount = 16;
     class Cache_t;
-    std::unique_ptr<Cache_t> m_volatileCache;
-    mutable QMutex m_mutex;
+    // Return the shard in charge of a given key
+    Cache_t &shard(const CacheKey &key) const;
+    std::array<std::unique_ptr<Cache_t>, ShardCount> m_volatileCache;
 
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
-    mutable std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+    // m_mutex only protects the list of opened packs, the volatile cache shards have their own lock
+    mutable QMutex m_mutex;
+    // the persistent cache files opened for each clip hash
+    mutable std::unordered_map<QString, std::shared_ptr<ThumbnailPack>> m_packs;
 };
@@ -0,0 +1,227 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "thumbnailpack.hpp"
+
+#include <QBuffer>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+
+const QString ThumbnailPack::extension = QStringLiteral(".kthumbs");
+
+namespace {
+const char packMagic[4] = {'K', 'D', 'T', 'P'};
+const quint32 packVersion = 1;
+// magic + version
+const qint64 headerSize = 8;
+// position + data size
+const qint64 recordHeaderSize = 8;
+} // namespace
+
+ThumbnailPack::ThumbnailPack(const QString &path)
+    : m_file(path)
+{
+}
+
+ThumbnailPack::~ThumbnailPack()
+{
+    QMutexLocker locker(&m_mutex);
+    unmap();
+    m_file.close();
+}
+
+void ThumbnailPack::unmap() const
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+        m_mappedSize = 0;
+    }
+}
+
+bool ThumbnailPack::ensureMapped() const
+{
+    if (!m_file.isOpen()) {
+        if (!m_file.exists()) {
+            // Nothing stored yet, no need to check again until we append
+            m_indexed = true;
+            m_validSize = 0;
+            return false;
+        }
+        if (!m_file.open(QIODevice::ReadWrite)) {
+            return false;
+        }
+    }
+    if (m_map == nullptr) {
+        qint64 fileSize = m_file.size();
+        if (fileSize < headerSize) {
+            m_indexed = true;
+            m_validSize = 0;
+            return false;
+        }
+        m_map = m_file.map(0, fileSize);
+        if (m_map == nullptr) {
+            qDebug() << "// Cannot map thumbnail pack" << m_file.fileName() << m_file.errorString();
+            return false;
+        }
+        m_mappedSize = fileSize;
+    }
+    if (!m_indexed) {
+        m_indexed = true;
+        m_index.clear();
+        if (memcmp(m_map, packMagic, 4) != 0 || qFromLittleEndian<quint32>(m_map + 4) != packVersion) {
+            // Unknown format, the file will be overwritten on next append
+            m_validSize = 0;
+            return false;
+        }
+        qint64 offset = headerSize;
+        while (offset + recordHeaderSize <= m_mappedSize) {
+            qint32 pos = qFromLittleEndian<qint32>(m_map + offset);
+            quint32 length = qFromLittleEndian<quint32>(m_map + offset + 4);
+            if (offset + recordHeaderSize + length > m_mappedSize) {
+                // Truncated record, probably a crash while writing
+                break;
+            }
+            m_index[pos] = {offset + recordHeaderSize, length};
+            offset += recordHeaderSize + length;
+        }
+        m_validSize = offset;
+    }
+    return true;
+}
+
+bool ThumbnailPack::contains(int pos) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_indexed) {
+        ensureMapped();
+    }
+    return m_index.count(pos) > 0;
+}
+
+QImage ThumbnailPack::get(int pos) const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_indexed) {
+        ensureMapped();
+    }
+    auto found = m_index.find(pos);
+    if (found == m_index.end() || !ensureMapped() || found->second.first + found->second.second > m_mappedSize) {
+        return QImage();
+    }
+    // Copy the encoded data so that decoding happens without holding the lock
+    const QByteArray data(reinterpret_cast<const char *>(m_map + found->second.first), int(found->second.second));
+    locker.unlock();
+    return QImage::fromData(data, "JPG");
+}
+
+bool ThumbnailPack::append(const std::vector<std::pair<int, QImage>> &thumbs)
+{
+    // Encode outside of the lock
+    std::vector<std::pair<int, QByteArray>> encodedThumbs;
+    encodedThumbs.reserve(thumbs.size());
+    for (const auto &thumb : thumbs) {
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        if (thumb.second.isNull() || !thumb.second.save(&buffer, "JPG")) {
+            continue;
+        }
+        encodedThumbs.push_back({thumb.first, encoded});
+    }
+    return appendEncoded(encodedThumbs);
+}
+
+bool ThumbnailPack::appendEncoded(const std::vector<std::pair<int, QByteArray>> &thumbs)
+{
+    QByteArray records;
+    for (const auto &thumb : thumbs) {
+        if (thumb.second.isEmpty()) {
+            continue;
+        }
+        uchar recordHeader[recordHeaderSize];
+        qToLittleEndian<qint32>(thumb.first, recordHeader);
+        qToLittleEndian<quint32>(quint32(thumb.second.size()), recordHeader + 4);
+        records.append(reinterpret_cast<const char *>(recordHeader), int(recordHeaderSize));
+        records.append(thumb.second);
+    }
+    if (records.isEmpty()) {
+        return true;
+    }
+    QMutexLocker locker(&m_mutex);
+    ensureMapped();
+    // The file will grow, remap on next read
+    unmap();
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "// Cannot open thumbnail pack" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+    if (m_validSize < headerSize) {
+        // New or invalid file, start from scratch
+        m_index.clear();
+        m_file.resize(0);
+        uchar header[headerSize];
+        memcpy(header, packMagic, 4);
+        qToLittleEndian<quint32>(packVersion, header + 4);
+        if (m_file.write(reinterpret_cast<const char *>(header), headerSize) != headerSize) {
+            return false;
+        }
+        m_validSize = headerSize;
+        m_indexed = true;
+    } else if (m_file.size() > m_validSize) {
+        // Drop a partially written record
+        m_file.resize(m_validSize);
+    }
+    if (!m_file.seek(m_validSize) || m_file.write(records) != records.size()) {
+        qDebug() << "// Error writing thumbnail pack" << m_file.fileName() << m_file.errorString();
+        m_file.resize(m_validSize);
+        return false;
+    }
+    m_file.flush();
+    // Update the index with the new records
+    qint64 offset = 0;
+    const auto *data = reinterpret_cast<const uchar *>(records.constData());
+    while (offset < records.size()) {
+        qint32 pos = qFromLittleEndian<qint32>(data + offset);
+        quint32 length = qFromLittleEndian<quint32>(data + offset + 4);
+        m_index[pos] = {m_validSize + offset + recordHeaderSize, length};
+        offset += recordHeaderSize + length;
+    }
+    m_validSize += records.size();
+    return true;
+}
+
+std::vector<int> ThumbnailPack::positions() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_indexed) {
+        ensureMapped();
+    }
+    std::vector<int> result;
+    result.reserve(m_index.size());
+    for (const auto &entry : m_index) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+qint64 ThumbnailPack::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.exists() ? m_file.size() : 0;
+}
+
+void ThumbnailPack::remove()
+{
+    QMutexLocker locker(&m_mutex);
+    unmap();
+    m_file.close();
+    m_file.remove();
+    m_index.clear();
+    m_validSize = 0;
+    m_indexed = false;
+}
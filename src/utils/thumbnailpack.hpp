@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/** @class ThumbnailPack
+    @brief Append-only container storing all the persistent thumbnails of a clip in a single memory-mapped file.
+    The file starts with a header (magic + version), followed by records made of the frame position,
+    the size of the encoded image and the JPEG data. The position -> offset index is rebuilt from the record
+    headers when the file is opened. A position stored twice is resolved to the most recent record.
+ */
+class ThumbnailPack
+{
+public:
+    explicit ThumbnailPack(const QString &path);
+    ~ThumbnailPack();
+
+    /** @brief Extension of the pack files in the thumbnail cache folder */
+    static const QString extension;
+
+    /** @brief Returns true if a thumbnail is stored for this position */
+    bool contains(int pos) const;
+    /** @brief Decode the thumbnail stored for this position, or return a null image */
+    QImage get(int pos) const;
+    /** @brief Encode and append a batch of thumbnails at the end of the file
+        @return false if the file could not be written
+    */
+    bool append(const std::vector<std::pair<int, QImage>> &thumbs);
+    /** @brief Append a batch of already JPEG encoded thumbnails at the end of the file
+        @return false if the file could not be written
+    */
+    bool appendEncoded(const std::vector<std::pair<int, QByteArray>> &thumbs);
+    /** @brief The positions stored in this pack */
+    std::vector<int> positions() const;
+    /** @brief Size of the file on disk */
+    qint64 size() const;
+    /** @brief Close the file and delete it from disk */
+    void remove();
+
+private:
+    /** @brief Open and map the file if it exists, building the index. Must be called with m_mutex locked */
+    bool ensureMapped() const;
+    void unmap() const;
+
+    mutable QMutex m_mutex;
+    mutable QFile m_file;
+    mutable uchar *m_map{nullptr};
+    mutable qint64 m_mappedSize{0};
+    // Size of the valid part of the file, a partially written record at the end is ignored
+    mutable qint64 m_validSize{0};
+    mutable bool m_indexed{false};
+    // position -> (offset of the image data, size of the image data)
+    mutable std::unordered_map<int, std::pair<qint64, quint32>> m_index;
+};
@@ -0,0 +1,102 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "jobstatisticswidget.h"
+#include "core.h"
+
+#include <KIO/Global>
+#include <KLocalizedString>
+#include <QApplication>
+#include <QClipboard>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+JobStatisticsWidget::JobStatisticsWidget(QWidget *parent)
+    : QWidget(parent, Qt::Tool)
+{
+    setWindowTitle(i18n("Job Statistics"));
+    auto *lay = new QVBoxLayout(this);
+    m_poolsLabel = new QLabel(this);
+    m_poolsLabel->setWordWrap(true);
+    lay->addWidget(m_poolsLabel);
+    m_jobsList = new QTreeWidget(this);
+    m_jobsList->setRootIsDecorated(false);
+    m_jobsList->setAlternatingRowColors(true);
+    m_jobsList->setHeaderLabels({i18n("Job"), i18n("Running"), i18n("Pending"), i18n("Done"), i18n("Canceled"), i18n("Average Wait"), i18n("Average Run"),
+                                 i18n("Frames/s"), i18n("Read"), i18n("Written"), i18n("Pool Use")});
+    m_jobsList->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    lay->addWidget(m_jobsList);
+    auto *buttons = new QHBoxLayout;
+    auto *reset = new QPushButton(i18n("Reset"), this);
+    connect(reset, &QPushButton::clicked, this, &JobStatisticsWidget::resetStatistics);
+    auto *copy = new QPushButton(i18n("Copy as JSON"), this);
+    connect(copy, &QPushButton::clicked, this, &JobStatisticsWidget::copyStatistics);
+    buttons->addStretch();
+    buttons->addWidget(reset);
+    buttons->addWidget(copy);
+    lay->addLayout(buttons);
+    m_refreshTimer.setInterval(1000);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &JobStatisticsWidget::updateStatistics);
+}
+
+void JobStatisticsWidget::showEvent(QShowEvent *event)
+{
+    updateStatistics();
+    m_refreshTimer.start();
+    QWidget::showEvent(event);
+}
+
+void JobStatisticsWidget::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+void JobStatisticsWidget::updateStatistics()
+{
+    const QJsonObject statistics = pCore->taskManager.statistics();
+    const QJsonObject pools = statistics.value(QStringLiteral("pools")).toObject();
+    auto poolText = [&pools](const QString &name) {
+        const QJsonObject pool = pools.value(name).toObject();
+        return i18n("%1/%2 threads, %3 pending, %4% used", pool.value(QStringLiteral("running")).toInt(), pool.value(QStringLiteral("threads")).toInt(),
+                    pool.value(QStringLiteral("pending")).toInt(), qRound(100 * pool.value(QStringLiteral("utilization")).toDouble()));
+    };
+    m_poolsLabel->setText(i18n("Tasks: %1\nTranscoding: %2", poolText(QStringLiteral("tasks")), poolText(QStringLiteral("transcode"))));
+
+    const QJsonObject jobs = statistics.value(QStringLiteral("jobs")).toObject();
+    m_jobsList->clear();
+    for (auto it = jobs.constBegin(); it != jobs.constEnd(); ++it) {
+        const QJsonObject job = it.value().toObject();
+        auto *item = new QTreeWidgetItem(m_jobsList);
+        item->setText(0, it.key());
+        item->setText(1, QString::number(job.value(QStringLiteral("running")).toInt()));
+        item->setText(2, QString::number(job.value(QStringLiteral("pending")).toInt()));
+        item->setText(3, QString::number(job.value(QStringLiteral("finished")).toInt()));
+        item->setText(4, QString::number(job.value(QStringLiteral("canceled")).toInt()));
+        item->setText(5, i18n("%1 ms", job.value(QStringLiteral("averageQueueWaitMs")).toInt()));
+        item->setText(6, i18n("%1 ms", job.value(QStringLiteral("averageRunTimeMs")).toInt()));
+        item->setText(7, QString::number(job.value(QStringLiteral("framesPerSecond")).toDouble(), 'f', 1));
+        item->setText(8, KIO::convertSize(KIO::filesize_t(job.value(QStringLiteral("bytesRead")).toDouble())));
+        item->setText(9, KIO::convertSize(KIO::filesize_t(job.value(QStringLiteral("bytesWritten")).toDouble())));
+        item->setText(10, QStringLiteral("%1%").arg(qRound(100 * job.value(QStringLiteral("poolUtilization")).toDouble())));
+    }
+}
+
+void JobStatisticsWidget::copyStatistics()
+{
+    QApplication::clipboard()->setText(QString::fromUtf8(QJsonDocument(pCore->taskManager.statistics()).toJson()));
+}
+
+void JobStatisticsWidget::resetStatistics()
+{
+    pCore->taskManager.resetStatistics();
+    updateStatistics();
+}
@@ -0,0 +1,36 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QTimer>
+#include <QWidget>
+
+class QLabel;
+class QTreeWidget;
+
+/** @class JobStatisticsWidget
+    @brief A small panel displaying the statistics of the background jobs per job type, refreshed while visible.
+ */
+class JobStatisticsWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit JobStatisticsWidget(QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    QLabel *m_poolsLabel;
+    QTreeWidget *m_jobsList;
+    QTimer m_refreshTimer;
+
+private Q_SLOTS:
+    void updateStatistics();
+    void copyStatistics();
+    void resetStatistics();
+};
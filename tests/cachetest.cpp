@@ -8,9 +8,12 @@
 #include "doc/kdenlivedoc.h"
 #include "test_utils.hpp"
 
+#include <QTemporaryDir>
 #include <QString>
+#include <atomic>
 #include <cmath>
 #include <iostream>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 
@@ -18,6 +21,7 @@
 #define private public
 #define protected public
 #include "core.h"
+#include "utils/probecache.hpp"
 #include "utils/thumbnailcache.hpp"
 
 TEST_CASE("Cache insert-remove", "[Cache]")
@@ -59,6 +63,51 @@ TEST_CASE("Cache insert-remove", "[Cache]")
         ThumbnailCache::get()->storeThumbnail(binId, 0, img, false);
         REQUIRE(ThumbnailCache::get()->checkIntegrity());
     }
+    SECTION("Invalidate clip thumbnails")
+    {
+        QImage img(100, 100, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::red);
+        for (int i = 0; i < 10; ++i) {
+            ThumbnailCache::get()->storeThumbnail(binId, i, img, false);
+        }
+        REQUIRE(ThumbnailCache::get()->hasThumbnail(binId, 5, true));
+        ThumbnailCache::get()->invalidateThumbsForClip(binId);
+        REQUIRE(ThumbnailCache::get()->checkIntegrity());
+        for (int i = 0; i < 10; ++i) {
+            REQUIRE_FALSE(ThumbnailCache::get()->hasThumbnail(binId, i, true));
+        }
+    }
+    SECTION("Concurrent access from 16 threads")
+    {
+        const int frames = 200;
+        const int threadCount = 16;
+        const int iterations = 20000;
+        QImage img(32, 18, QImage::Format_ARGB32_Premultiplied);
+        img.fill(Qt::red);
+        for (int i = 0; i < frames; ++i) {
+            ThumbnailCache::get()->storeThumbnail(binId, i, img, false);
+        }
+        const QString hash = binModel->getClipByBinID(binId)->hashForThumbs();
+        std::atomic<int> misses{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < iterations; ++i) {
+                    int pos = (i * 7 + t * 13) % frames;
+                    if (i % 50 == 0) {
+                        ThumbnailCache::get()->storeThumbnail(binId, pos, img, false);
+                    } else if (ThumbnailCache::get()->getThumbnail(hash, binId, pos, true).isNull()) {
+                        misses++;
+                    }
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        REQUIRE(misses == 0);
+        REQUIRE(ThumbnailCache::get()->checkIntegrity());
+    }
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
@@ -111,3 +160,128 @@ TEST_CASE("getAudioKey() should dereference `ok` param", "ThumbnailCache") {
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
+
+TEST_CASE("Packed thumbnail storage", "[Cache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("clip") + ThumbnailPack::extension);
+    QImage img(64, 36, QImage::Format_RGB32);
+    img.fill(Qt::blue);
+    {
+        ThumbnailPack pack(path);
+        REQUIRE_FALSE(pack.contains(0));
+        REQUIRE(pack.get(0).isNull());
+        REQUIRE(pack.append({{0, img}, {25, img}, {50, img}}));
+        REQUIRE(pack.contains(25));
+        REQUIRE(pack.get(50).size() == img.size());
+        REQUIRE(pack.append({{75, img}}));
+        REQUIRE(pack.positions().size() == 4);
+    }
+    SECTION("Index is rebuilt when reopening")
+    {
+        ThumbnailPack pack(path);
+        REQUIRE(pack.contains(0));
+        REQUIRE(pack.contains(75));
+        REQUIRE_FALSE(pack.contains(10));
+        REQUIRE(pack.get(75).size() == img.size());
+    }
+    SECTION("Truncated record is ignored")
+    {
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadWrite));
+        file.resize(file.size() - 10);
+        file.close();
+        ThumbnailPack pack(path);
+        REQUIRE(pack.contains(50));
+        REQUIRE_FALSE(pack.contains(75));
+        REQUIRE(pack.append({{75, img}}));
+        REQUIRE(pack.get(75).size() == img.size());
+    }
+    SECTION("Remove pack")
+    {
+        ThumbnailPack pack(path);
+        pack.remove();
+        REQUIRE_FALSE(QFile::exists(path));
+        REQUIRE_FALSE(pack.contains(0));
+    }
+    SECTION("Legacy thumbnails are migrated")
+    {
+        QDir folder(dir.path());
+        REQUIRE(img.save(folder.absoluteFilePath(QStringLiteral("clip#100.jpg"))));
+        REQUIRE(img.save(folder.absoluteFilePath(QStringLiteral("clip#0.jpg"))));
+        ThumbnailPack pack(path);
+        ThumbnailCache::migrateLegacyThumbs(folder, QStringLiteral("clip"), pack);
+        REQUIRE(pack.get(100).size() == img.size());
+        REQUIRE(pack.positions().size() == 5);
+        REQUIRE_FALSE(folder.exists(QStringLiteral("clip#100.jpg")));
+        REQUIRE_FALSE(folder.exists(QStringLiteral("clip#0.jpg")));
+    }
+}
+
+TEST_CASE("Shared media probe cache", "[Cache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    // Use a cache in the temporary folder instead of the user's cache
+    QTemporaryDir cacheDir;
+    REQUIRE(cacheDir.isValid());
+    ProbeCache::get();
+    std::unique_ptr<ProbeCache> userCache(new ProbeCache(cacheDir.path()));
+    ProbeCache::instance.swap(userCache);
+
+    const QString path = dir.filePath(QStringLiteral("media.bin"));
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write(QByteArray(1000, 'a'));
+    file.close();
+    auto &cache = ProbeCache::get();
+    REQUIRE(cache->folder() == QDir(cacheDir.path()).absoluteFilePath(QStringLiteral("probes")));
+    REQUIRE(cache->hash(path).isEmpty());
+    REQUIRE(cache->properties(path).isEmpty());
+
+    // Computing the hash stores it in the cache
+    const QByteArray hash = ProjectClip::calculateHash(path).first;
+    REQUIRE(cache->hash(path) == QString::fromLatin1(hash.toHex()));
+    REQUIRE(ProjectClip::calculateHash(path).first == hash);
+    REQUIRE(ProjectClip::calculateHash(path).second == 1000);
+
+    cache->storeProperties(path, {{QStringLiteral("meta.media.nb_streams"), QStringLiteral("2")}, {QStringLiteral("duration"), QStringLiteral("4.0")}});
+    QImage img(64, 36, QImage::Format_ARGB32);
+    img.fill(Qt::red);
+    const QString variant = QStringLiteral("rotate=0,force_aspect_ratio=");
+    cache->storeThumbnail(path, variant, img);
+    // Storing the properties keeps the hash
+    REQUIRE(cache->hash(path) == QString::fromLatin1(hash.toHex()));
+    REQUIRE(cache->properties(path).value(QStringLiteral("meta.media.nb_streams")) == QStringLiteral("2"));
+    REQUIRE(cache->thumbnail(path, variant).size() == img.size());
+    // Thumbnails of other producer properties are not shared
+    REQUIRE(cache->thumbnail(path, QStringLiteral("rotate=0,force_aspect_ratio=1.333")).isNull());
+
+    // Recent entries of unchanged files are kept
+    REQUIRE(cache->prune(QDateTime::currentDateTime().addDays(-1)) == 0);
+    REQUIRE_FALSE(cache->hash(path).isEmpty());
+
+    // A modified file is not matched anymore
+    REQUIRE(file.open(QIODevice::Append));
+    file.write(QByteArray(10, 'b'));
+    file.close();
+    REQUIRE(cache->hash(path).isEmpty());
+    REQUIRE(cache->properties(path).isEmpty());
+    REQUIRE(cache->thumbnail(path, variant).isNull());
+    REQUIRE(ProjectClip::calculateHash(path).first != hash);
+
+    // The entry of the previous version is pruned with its thumbnail, the new one is kept
+    QDir probes(cache->folder());
+    REQUIRE(probes.entryList(QDir::Files).count() == 3);
+    REQUIRE(cache->prune(QDateTime::currentDateTime().addDays(-1)) > 0);
+    REQUIRE(probes.entryList(QDir::Files).count() == 1);
+    REQUIRE_FALSE(cache->hash(path).isEmpty());
+
+    // Old entries are pruned
+    REQUIRE(cache->prune(QDateTime::currentDateTime().addDays(1)) > 0);
+    REQUIRE(cache->hash(path).isEmpty());
+    REQUIRE(probes.entryList(QDir::Files).isEmpty());
+
+    ProbeCache::instance.swap(userCache);
+}
@@ -5,6 +5,7 @@
 #include "test_utils.hpp"
 
 #include "scopes/colorscopes/colorconstants.h"
+#include "scopes/colorscopes/scopeanalysis.h"
 #include "scopes/colorscopes/vectorscopegenerator.h"
 #include "scopes/colorscopes/waveformgenerator.h"
 #include "scopes/colorscopes/rgbparadegenerator.h"
@@ -80,3 +81,125 @@ TEST_CASE("Colorscope RGB/BGR handling")
         CHECK(rgbScope == bgrScope);
     }
 }
+
+// Scopes split the image in column bands processed in parallel, the result must not depend on
+// the split nor on the input format.
+TEST_CASE("Colorscope kernels on a full HD frame")
+{
+    QImage inputImage(1920, 1080, QImage::Format_RGB32);
+    for (int y = 0; y < inputImage.height(); ++y) {
+        auto *line = reinterpret_cast<QRgb *>(inputImage.scanLine(y));
+        for (int x = 0; x < inputImage.width(); ++x) {
+            line[x] = qRgb(x % 256, y % 256, (x + y) % 256);
+        }
+    }
+    QImage bgrInputImage = inputImage.convertToFormat(QImage::Format_BGR30);
+    QSize scopeSize{512, 512};
+
+    SECTION("Vectorscope")
+    {
+        VectorscopeGenerator vectorscope{};
+        for (auto mode : {VectorscopeGenerator::PaintMode_Green2, VectorscopeGenerator::PaintMode_Original}) {
+            QImage first = vectorscope.calculateVectorscope(scopeSize, inputImage, 1, mode, VectorscopeGenerator::ColorSpace_YUV, false, 1);
+            CHECK(vectorscope.calculateVectorscope(scopeSize, inputImage, 1, mode, VectorscopeGenerator::ColorSpace_YUV, false, 1) == first);
+            CHECK(vectorscope.calculateVectorscope(scopeSize, bgrInputImage, 1, mode, VectorscopeGenerator::ColorSpace_YUV, false, 1) == first);
+        }
+    }
+
+    SECTION("Waveform")
+    {
+        WaveformGenerator waveform{};
+        QImage first = waveform.calculateWaveform(scopeSize, inputImage, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709, 1);
+        CHECK(waveform.calculateWaveform(scopeSize, inputImage, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709, 1) == first);
+        CHECK(waveform.calculateWaveform(scopeSize, bgrInputImage, WaveformGenerator::PaintMode_Green, true, ITURec::Rec_709, 1) == first);
+    }
+
+    SECTION("RGB Parade")
+    {
+        RGBParadeGenerator rgb{};
+        QImage first = rgb.calculateRGBParade(scopeSize, inputImage, RGBParadeGenerator::PaintMode_RGB, true, false, 1);
+        CHECK(rgb.calculateRGBParade(scopeSize, inputImage, RGBParadeGenerator::PaintMode_RGB, true, false, 1) == first);
+        CHECK(rgb.calculateRGBParade(scopeSize, bgrInputImage, RGBParadeGenerator::PaintMode_RGB, true, false, 1) == first);
+    }
+
+    SECTION("Histogram")
+    {
+        const auto ALL_COMPONENTS = HistogramGenerator::ComponentY | HistogramGenerator::ComponentR | HistogramGenerator::ComponentG |
+                                    HistogramGenerator::ComponentB | HistogramGenerator::ComponentSum;
+        HistogramGenerator hist{};
+        QImage first = hist.calculateHistogram(scopeSize, inputImage, ALL_COMPONENTS, ITURec::Rec_709, false, false, 1);
+        CHECK(hist.calculateHistogram(scopeSize, inputImage, ALL_COMPONENTS, ITURec::Rec_709, false, false, 1) == first);
+        CHECK(hist.calculateHistogram(scopeSize, bgrInputImage, ALL_COMPONENTS, ITURec::Rec_709, false, false, 1) == first);
+    }
+}
+
+TEST_CASE("Shared scope analysis")
+{
+    // Each column has its own gray level, wide enough to be split in several bands
+    QImage inputImage(1024, 64, QImage::Format_RGB32);
+    for (int y = 0; y < inputImage.height(); ++y) {
+        auto *line = reinterpret_cast<QRgb *>(inputImage.scanLine(y));
+        for (int x = 0; x < inputImage.width(); ++x) {
+            line[x] = qRgb(x % 256, x % 256, x % 256);
+        }
+    }
+    const auto all = ScopeAnalysis::RGBHistogram | ScopeAnalysis::LumaHistogram709 | ScopeAnalysis::RGBColumns | ScopeAnalysis::LumaColumns709 |
+                     ScopeAnalysis::ChromaYUV | ScopeAnalysis::ChromaColors;
+    const ScopeAnalysis::ChromaGeometry chroma{QSize(256, 256), 1.f};
+    ScopeAnalysis analysis(inputImage, all, 1, chroma);
+    REQUIRE(analysis.contains(all));
+    CHECK(analysis.contains(all, chroma));
+    CHECK_FALSE(analysis.contains(all, ScopeAnalysis::ChromaGeometry{QSize(256, 256), 2.f}));
+    CHECK(analysis.contains(ScopeAnalysis::RGBHistogram, ScopeAnalysis::ChromaGeometry()));
+    CHECK_FALSE(analysis.contains(ScopeAnalysis::LumaColumns601));
+    CHECK(analysis.size() == inputImage.size());
+
+    // Each gray level appears in 4 columns of 64 pixels
+    for (int v = 0; v < 256; ++v) {
+        CHECK(analysis.histogram(ScopeAnalysis::Red)[v] == 256);
+        CHECK(analysis.histogram(ScopeAnalysis::Blue)[v] == 256);
+    }
+    int lumaTotal = 0;
+    for (int v = 0; v < 256; ++v) {
+        lumaTotal += analysis.lumaHistogram(ITURec::Rec_709)[v];
+    }
+    CHECK(lumaTotal == inputImage.width() * inputImage.height());
+    for (int x : {0, 100, 511, 700, 1023}) {
+        CHECK(analysis.columns(ScopeAnalysis::Green)[256 * x + x % 256] == 64);
+    }
+
+    // Gray has no chroma, all samples are drawn on the center pixel of the vectorscope
+    const QPoint center = ScopeAnalysis::mapToCircle(chroma.size, QPointF(0, 0));
+    const uint *hits = analysis.chromaHits(false);
+    CHECK(hits[center.y() * chroma.side() + center.x()] == uint(inputImage.width() * inputImage.height()));
+    const QRgb centerColor = analysis.chromaColors(false)[center.y() * chroma.side() + center.x()];
+    CHECK((qRed(centerColor) == qGreen(centerColor) && qGreen(centerColor) == qBlue(centerColor)));
+
+    // At a high gain, neighbouring colors are drawn on distinct vectorscope pixels
+    QImage reds(256, 64, QImage::Format_RGB32);
+    for (int y = 0; y < reds.height(); ++y) {
+        auto *line = reinterpret_cast<QRgb *>(reds.scanLine(y));
+        for (int x = 0; x < reds.width(); ++x) {
+            line[x] = qRgb(128 + x / 4, 128, 128);
+        }
+    }
+    const ScopeAnalysis::ChromaGeometry zoomed{QSize(512, 512), 4.f};
+    ScopeAnalysis redAnalysis(reds, ScopeAnalysis::ChromaYUV, 1, zoomed);
+    const uint *redHits = redAnalysis.chromaHits(false);
+    int drawnPixels = 0;
+    uint drawnSamples = 0;
+    for (int i = 0; i < zoomed.side() * zoomed.side(); ++i) {
+        drawnPixels += redHits[i] > 0 ? 1 : 0;
+        drawnSamples += redHits[i];
+    }
+    CHECK(drawnPixels == 64);
+    CHECK(drawnSamples == uint(reds.width() * reds.height()));
+
+    // Sampling every 3rd pixel
+    ScopeAnalysis sampled(inputImage, ScopeAnalysis::RGBHistogram, 3);
+    int sampledTotal = 0;
+    for (int v = 0; v < 256; ++v) {
+        sampledTotal += sampled.histogram(ScopeAnalysis::Red)[v];
+    }
+    CHECK(sampledTotal == (inputImage.width() * inputImage.height() + 2) / 3);
+}
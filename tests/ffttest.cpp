@@ -0,0 +1,165 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "test_utils.hpp"
+
+#include <cmath>
+
+#include "lib/audio/audioCorrelation.h"
+#include "lib/audio/audioLevels.h"
+#include "lib/audio/fftCorrelation.h"
+#include "lib/audio/fftTools.h"
+
+namespace {
+// Interleaved full scale sine waves, each channel on its own FFT bin
+audioShortVector sineFrame(int windowSize, int channels, int firstBin)
+{
+    audioShortVector frame(windowSize * channels);
+    for (int i = 0; i < windowSize; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            frame[i * channels + c] = qint16(32767 * sin(2 * M_PI * (firstBin + c) * i / windowSize));
+        }
+    }
+    return frame;
+}
+} // namespace
+
+TEST_CASE("Normalized FFT of audio frames")
+{
+    const int windowSize = 2048;
+    const int channels = 2;
+    const int bin = 64;
+    audioShortVector frame = sineFrame(windowSize, channels, bin);
+    FFTTools fftTools;
+
+    SECTION("A full scale sine is at 0 dB")
+    {
+        QVector<float> spectrum(windowSize / 2);
+        fftTools.fftNormalized(frame, 0, channels, spectrum.data(), FFTTools::Window_Rect, windowSize);
+        CHECK(std::abs(spectrum.at(bin)) < 0.1f);
+        CHECK(spectrum.at(bin / 2) < -60.f);
+        fftTools.fftNormalized(frame, 1, channels, spectrum.data(), FFTTools::Window_Rect, windowSize);
+        CHECK(std::abs(spectrum.at(bin + 1)) < 0.1f);
+    }
+
+    SECTION("Frames shorter than the window are padded")
+    {
+        // Switching between window sizes reuses the cached plans and work buffers
+        QVector<float> spectrum(windowSize);
+        audioShortVector shortFrame = frame.mid(0, windowSize);
+        fftTools.fftNormalized(shortFrame, 0, channels, spectrum.data(), FFTTools::Window_Hamming, 2 * windowSize);
+        QVector<float> reference(windowSize);
+        fftTools.fftNormalized(shortFrame, 0, channels, reference.data(), FFTTools::Window_Hamming, 2 * windowSize);
+        CHECK(spectrum == reference);
+        fftTools.fftNormalized(frame, 0, channels, spectrum.data(), FFTTools::Window_Rect, windowSize);
+        CHECK(std::abs(spectrum.at(bin)) < 0.1f);
+    }
+}
+
+// The audio scopes switch between window sizes, the cached configurations and buffers must not mix them up
+TEST_CASE("FFT with changing window sizes")
+{
+    const int channels = 2;
+    FFTTools fftTools;
+    const std::vector<int> sizes = {512, 2048, 8192};
+    std::vector<QVector<float>> first;
+    for (int round = 0; round < 2; ++round) {
+        for (size_t i = 0; i < sizes.size(); ++i) {
+            const int windowSize = sizes.at(i);
+            audioShortVector frame = sineFrame(windowSize, channels, 10);
+            QVector<float> left(windowSize / 2);
+            fftTools.fftNormalized(frame, 0, channels, left.data(), FFTTools::Window_Hamming, windowSize);
+            CHECK(std::isfinite(left.at(10)));
+            if (round == 0) {
+                first.push_back(left);
+            } else {
+                CHECK(left == first.at(i));
+            }
+        }
+    }
+}
+
+TEST_CASE("Audio envelope correlation")
+{
+    // Pseudo random envelope, the child being an excerpt of the main one
+    std::vector<qint64> main(80000);
+    quint32 seed = 42;
+    for (auto &value : main) {
+        seed = seed * 1664525u + 1013904223u;
+        value = qint64(seed >> 16) - 32768;
+    }
+    const size_t start = 12345;
+    std::vector<qint64> sub(main.begin() + start, main.begin() + start + 40000);
+    const size_t size = main.size() + sub.size() + 1;
+    auto maxIndex = [](const std::vector<qint64> &correlation) {
+        return size_t(std::max_element(correlation.begin(), correlation.end()) - correlation.begin());
+    };
+
+    SECTION("A shared reference gives the same result as a single correlation")
+    {
+        std::vector<qint64> single(size);
+        FFTCorrelation::correlate(main.data(), main.size(), sub.data(), sub.size(), single.data());
+        FFTCorrelation::Reference reference(main.data(), main.size(), sub.size());
+        std::vector<qint64> shared(size);
+        reference.correlate(sub.data(), sub.size(), shared.data());
+        CHECK(shared == single);
+        CHECK(maxIndex(shared) == sub.size() + start);
+        // A shorter child reuses the same reference
+        std::vector<qint64> shorter(main.size() + 1000 + 1);
+        reference.correlate(main.data() + 500, 1000, shorter.data());
+        CHECK(maxIndex(shorter) == 1000 + 500);
+    }
+
+    SECTION("Coarse to fine search finds the same shift")
+    {
+        std::vector<qint64> correlation(size);
+        AudioCorrelation::correlateCoarseToFine(main, sub, correlation.data());
+        CHECK(maxIndex(correlation) == sub.size() + start);
+    }
+}
+
+TEST_CASE("Audio levels peak of a frame range")
+{
+    // 2 channels, flat levels with a peak on each side of frame 500
+    const int frames = 1000;
+    QVector<uint8_t> data(frames * 2, 10);
+    data[499 * 2 + 1] = 250;
+    data[500 * 2] = 200;
+    AudioLevels levels(data, 2, 0, 25.);
+    REQUIRE(levels.pyramidDepth() > 4);
+
+    // Large ranges are read from coarse buckets, which must not include frames next to the range
+    CHECK(levels.peak(0, 0, 500) == 10);
+    CHECK(levels.peak(0, 0, 501) == 200);
+    CHECK(levels.peak(1, 500, frames) == 10);
+    CHECK(levels.peak(1, 499, frames) == 250);
+    CHECK(levels.peak(-1, 0, 500) == 250);
+    CHECK(levels.peak(-1, 256, 768) == 250);
+    CHECK(levels.peak(0, 501, 999) == 10);
+    CHECK(levels.peak(0, 500, 501) == 200);
+}
+
+TEST_CASE("Audio levels filled progressively")
+{
+    const int frames = 1000;
+    QVector<uint8_t> data(frames * 2);
+    quint32 seed = 7;
+    for (auto &value : data) {
+        seed = seed * 1664525u + 1013904223u;
+        value = uint8_t(seed >> 24);
+    }
+    AudioLevels levels = AudioLevels::allocate(frames, 2, 0, 25.);
+    AudioLevels reader = levels;
+    // Ranges are set in any order, the copies see the new frames
+    levels.setLevels(600, data.constData() + 600 * 2, 400);
+    CHECK(reader.peak(-1, 0, 600) == 0);
+    levels.setLevels(0, data.constData(), 600);
+    AudioLevels expected(data, 2, 0, 25.);
+    CHECK(reader.maxLevel() == expected.maxLevel());
+    CHECK(std::equal(reader.constBegin(), reader.constEnd(), expected.constBegin()));
+    for (int start = 0; start < frames; start += 97) {
+        CHECK(reader.peak(0, start, frames) == expected.peak(0, start, frames));
+        CHECK(reader.peak(-1, 0, start + 1) == expected.peak(-1, 0, start + 1));
+    }
+}
@@ -261,5 +261,38 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
         undoStack->undo();
         state1(6.1);
     }
+
+    SECTION("Interpolated values")
+    {
+        const double fps = pCore->getCurrentFps();
+        auto checkRange = [&](int in, int out) {
+            QVector<QVariant> values = model->getInterpolatedValues(in, out);
+            REQUIRE(values.size() == out - in + 1);
+            for (int frame = in; frame <= out; ++frame) {
+                REQUIRE(values.at(frame - in).toDouble() == Approx(model->getInterpolatedValue(frame).toDouble()));
+            }
+        };
+        REQUIRE(model->addKeyframe(GenTime(50, fps), KeyframeType::Linear, 42));
+        checkRange(0, 100);
+        const double before = model->getInterpolatedValue(75).toDouble();
+        REQUIRE(before == Approx(42));
+
+        // The cached animation follows the modifications
+        REQUIRE(model->addKeyframe(GenTime(100, fps), KeyframeType::Linear, 0));
+        REQUIRE(model->getInterpolatedValue(75).toDouble() == Approx(21));
+        checkRange(0, 100);
+        const QString modified = model->getAnimProperty();
+        undoStack->undo();
+        REQUIRE(model->getInterpolatedValue(75).toDouble() == Approx(before));
+        checkRange(40, 60);
+        REQUIRE(model->getInterpolatedValues(10, 5).isEmpty());
+
+        // The cached animation is dropped when the parameter is reset from outside
+        const QString name = effect->data(index, AssetParameterModel::NameRole).toString();
+        effect->setParameter(name, modified, false, index);
+        model->reset();
+        REQUIRE(model->getInterpolatedValue(75).toDouble() == Approx(21));
+        checkRange(70, 80);
+    }
     pCore->m_projectManager = nullptr;
 }
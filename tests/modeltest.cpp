@@ -6,6 +6,8 @@
 */
 #include "test_utils.hpp"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
+#include "undohelper.hpp"
 
 #include <QUndoGroup>
 
@@ -2296,3 +2298,64 @@ TEST_CASE("New KdenliveDoc activeTrack", "KdenliveDoc")
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
+
+TEST_CASE("Undo history memory budget", "[UndoStack]")
+{
+    const int previousLimit = KdenliveSettings::undomemorylimit();
+    KdenliveSettings::setUndomemorylimit(0);
+    DocUndoStack undoStack(nullptr);
+    const qint64 payload = 1024 * 1024;
+    int value = 0;
+    auto pushStep = [&](int i) {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        Fun operation = [&value]() {
+            value++;
+            return true;
+        };
+        Fun reverse = [&value]() {
+            value--;
+            return true;
+        };
+        operation();
+        PUSH_LAMBDA(operation, redo);
+        PUSH_FRONT_LAMBDA(reverse, undo);
+        undoStack.push(new FunctionalUndoCommand(undo, redo, QStringLiteral("step %1").arg(i), payload));
+    };
+    for (int i = 0; i < 10; ++i) {
+        pushStep(i);
+    }
+    REQUIRE(value == 10);
+    REQUIRE(undoStack.count() == 10);
+    // The payload of each operation is accounted
+    const qint64 fullCost = undoStack.memoryCost();
+    REQUIRE(fullCost >= 10 * payload);
+    const qint64 stepCost = fullCost / 10;
+
+    // Pushing after an undo drops the cost of the undone step
+    undoStack.undo();
+    REQUIRE(value == 9);
+    pushStep(9);
+    REQUIRE(undoStack.count() == 10);
+    CHECK(undoStack.memoryCost() == fullCost);
+
+    // Only the oldest steps are discarded, the last one is always kept
+    REQUIRE(undoStack.compact(fullCost / 2) == 5);
+    CHECK(undoStack.memoryCost() == fullCost - 5 * stepCost);
+    CHECK(undoStack.command(0)->isObsolete());
+    CHECK_FALSE(undoStack.command(5)->isObsolete());
+    undoStack.compact(0);
+    CHECK(undoStack.command(8)->isObsolete());
+    CHECK_FALSE(undoStack.command(9)->isObsolete());
+    CHECK(undoStack.memoryCost() == stepCost);
+
+    // The undo stops at the discarded steps
+    REQUIRE(undoStack.hasUndoableStep());
+    undoStack.undo();
+    REQUIRE(value == 9);
+    CHECK_FALSE(undoStack.hasUndoableStep());
+
+    undoStack.clear();
+    CHECK(undoStack.memoryCost() == 0);
+    KdenliveSettings::setUndomemorylimit(previousLimit);
+}
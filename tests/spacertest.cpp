@@ -261,3 +261,155 @@ TEST_CASE("Remove all spaces", "[Spacer]")
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
+
+TEST_CASE("Shift many items", "[Spacer]")
+{
+    // Create timeline
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    // Here we do some trickery to enable testing.
+    // We mock the project class so that the undoStack function returns our undoStack
+    KdenliveDoc document(undoStack, {1, 2});
+    Mock<KdenliveDoc> docMock(document);
+    KdenliveDoc &mockedDoc = docMock.get();
+
+    // We mock the project class so that the undoStack function returns our undoStack, and our mocked document
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    When(Method(pmMock, current)).AlwaysReturn(&mockedDoc);
+
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    mocked.m_project = &mockedDoc;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    mocked.updateTimeline(0, false, QString(), QString(), documentDate, 0);
+    auto timeline = mockedDoc.getTimeline(mockedDoc.uuid());
+    mocked.m_activeTimelineModel = timeline;
+    mocked.testSetActiveDocument(&mockedDoc, timeline);
+
+    int tid1 = timeline->getTrackIndexFromPosition(2);
+    int tid2 = timeline->getTrackIndexFromPosition(1);
+
+    QString binId = createProducer(*timeline->getProfile(), "red", binModel, 20);
+
+    // Clips of 20 frames separated by 10 frames blanks on track 1, one clip at 95 on track 2
+    const int count = 500;
+    std::vector<int> clips;
+    for (int i = 0; i < count; ++i) {
+        int cid;
+        REQUIRE(timeline->requestClipInsertion(binId, tid1, 30 * i, cid, false));
+        clips.push_back(cid);
+    }
+    int cid2;
+    REQUIRE(timeline->requestClipInsertion(binId, tid2, 95, cid2, false));
+
+    // Check the clips of track 1, the ones after from being moved by delta
+    auto checkPositions = [&](int from, int delta) {
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->getTrackClipsCount(tid1) == count);
+        for (int i = 0; i < count; ++i) {
+            int expected = 30 * i;
+            if (expected >= from) {
+                expected += delta;
+            }
+            REQUIRE(timeline->getClipPosition(clips[size_t(i)]) == expected);
+        }
+    };
+    checkPositions(0, 0);
+
+    SECTION("Insert and remove space on one track")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        REQUIRE(TimelineFunctions::requestInsertSpace(timeline, QPoint(60, 160), undo, redo, {tid1}));
+        checkPositions(60, 100);
+        REQUIRE(timeline->getClipPosition(cid2) == 95);
+        REQUIRE(undo());
+        checkPositions(0, 0);
+
+        // Same operation with the spacer, which moves the items as a group
+        std::pair<int, int> spacerOp = TimelineFunctions::requestSpacerStartOperation(timeline, tid1, 60);
+        int cid = spacerOp.first;
+        REQUIRE(cid > -1);
+        int start = timeline->getItemPosition(cid);
+        Fun spacerUndo = []() { return true; };
+        Fun spacerRedo = []() { return true; };
+        REQUIRE(TimelineFunctions::requestSpacerEndOperation(timeline, cid, start, start + 100, tid1, -1, spacerUndo, spacerRedo));
+        checkPositions(60, 100);
+        undoStack->undo();
+        checkPositions(0, 0);
+
+        // The items are only shifted at once when nothing crosses the position
+        Fun shiftUndo = []() { return true; };
+        Fun shiftRedo = []() { return true; };
+        CHECK_FALSE(timeline->requestShiftItems(70, 100, {tid1}, shiftUndo, shiftRedo));
+        checkPositions(0, 0);
+        // or when all the items of a group move
+        int gid = timeline->requestClipsGroup({clips[1], clips[3]});
+        REQUIRE(gid > -1);
+        CHECK_FALSE(timeline->requestShiftItems(60, 100, {tid1}, shiftUndo, shiftRedo));
+        checkPositions(0, 0);
+        REQUIRE(timeline->requestShiftItems(30, 100, {tid1}, shiftUndo, shiftRedo));
+        checkPositions(30, 100);
+        REQUIRE(timeline->getGroupElements(clips[1]).size() == 2);
+        REQUIRE(shiftUndo());
+        checkPositions(0, 0);
+        REQUIRE(timeline->requestClipUngroup(clips[1]));
+
+        REQUIRE(redo());
+        checkPositions(60, 100);
+        Fun removeUndo = []() { return true; };
+        Fun removeRedo = []() { return true; };
+        REQUIRE(TimelineFunctions::removeSpace(timeline, QPoint(60, 160), removeUndo, removeRedo, {tid1}, false));
+        checkPositions(0, 0);
+        REQUIRE(removeUndo());
+        checkPositions(60, 100);
+        REQUIRE(removeRedo());
+        checkPositions(0, 0);
+    }
+    SECTION("Insert space on all tracks")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        REQUIRE(TimelineFunctions::requestInsertSpace(timeline, QPoint(90, 100), undo, redo));
+        checkPositions(90, 10);
+        REQUIRE(timeline->getClipPosition(cid2) == 105);
+        REQUIRE(undo());
+        checkPositions(0, 0);
+        REQUIRE(timeline->getClipPosition(cid2) == 95);
+        REQUIRE(redo());
+        checkPositions(90, 10);
+        REQUIRE(timeline->getClipPosition(cid2) == 105);
+        REQUIRE(undo());
+        // A clip crossing the position goes through a group move
+        REQUIRE(TimelineFunctions::requestInsertSpace(timeline, QPoint(100, 110), undo, redo));
+        checkPositions(90, 10);
+        REQUIRE(timeline->getClipPosition(cid2) == 105);
+        REQUIRE(undo());
+        checkPositions(0, 0);
+        REQUIRE(timeline->getClipPosition(cid2) == 95);
+    }
+    SECTION("Remove all blanks")
+    {
+        REQUIRE(TimelineFunctions::requestDeleteAllBlanksFrom(timeline, tid1, 0));
+        REQUIRE(timeline->checkConsistency());
+        for (int i = 0; i < count; ++i) {
+            REQUIRE(timeline->getClipPosition(clips[size_t(i)]) == 20 * i);
+        }
+        REQUIRE(timeline->getClipPosition(cid2) == 95);
+        undoStack->undo();
+        checkPositions(0, 0);
+        undoStack->redo();
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(timeline->getClipPosition(clips.back()) == 20 * (count - 1));
+        undoStack->undo();
+        checkPositions(0, 0);
+    }
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
@@ -0,0 +1,152 @@
+/*
+    SPDX-FileCopyrightText: 2023 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "test_utils.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <atomic>
+#include <functional>
+
+#include "jobs/abstracttask.h"
+#include "jobs/taskmanager.h"
+
+namespace {
+/** @brief A task processing frames until it is canceled, like the clip jobs do.
+ *  Once canceled, it only stops when released so that the tests can check that nobody waited for it */
+class FrameTask : public AbstractTask
+{
+public:
+    FrameTask(int owner, std::atomic<int> &started, std::atomic<int> &lastStarted, const std::atomic<bool> &released)
+        : AbstractTask({ObjectType::BinClip, owner}, AbstractTask::CACHEJOB, nullptr)
+        , m_started(started)
+        , m_lastStarted(lastStarted)
+        , m_released(released)
+    {
+    }
+    void run() override
+    {
+        AbstractTaskDone whenFinished(m_owner.second, this);
+        if (m_isCanceled || pCore->taskManager.isBlocked()) {
+            return;
+        }
+        QMutexLocker lock(&m_runMutex);
+        m_running = true;
+        m_lastStarted = m_owner.second;
+        m_started++;
+        for (int frame = 0; frame < 10000 && !(m_isCanceled && m_released); ++frame) {
+            QThread::msleep(1);
+        }
+    }
+
+private:
+    std::atomic<int> &m_started;
+    std::atomic<int> &m_lastStarted;
+    const std::atomic<bool> &m_released;
+};
+
+// Process the GUI events until the condition is met
+bool waitFor(const std::function<bool()> &condition, int timeout = 10000)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition() && timer.elapsed() < timeout) {
+        QCoreApplication::processEvents();
+        QThread::msleep(1);
+    }
+    return condition();
+}
+} // namespace
+
+TEST_CASE("Cancel queued tasks without blocking", "[TaskManager]")
+{
+    TaskManager &manager = pCore->taskManager;
+    const int count = 1000;
+    const int firstOwner = 100000;
+    std::atomic<int> started{0};
+    std::atomic<int> lastStarted{-1};
+    std::atomic<bool> released{false};
+    for (int i = 0; i < count; ++i) {
+        manager.startTask(firstOwner + i, new FrameTask(firstOwner + i, started, lastStarted, released));
+    }
+    // Wait until the pool is busy, the other tasks are queued
+    REQUIRE(waitFor([&]() { return started > 0; }));
+    const int running = started;
+    const int runningOwner = lastStarted;
+
+    // Cancel the queued tasks first, then the running ones, one of them with a completion callback.
+    // The canceled tasks keep running until released, so returning from discardJobs shows that it did not wait for them.
+    bool done = false;
+    for (int i = count - 1; i >= 0; --i) {
+        if (firstOwner + i == runningOwner) {
+            manager.discardJobs({ObjectType::BinClip, runningOwner}, AbstractTask::NOJOBTYPE, false, {}, [&done]() { done = true; });
+        } else {
+            manager.discardJobs({ObjectType::BinClip, firstOwner + i});
+        }
+    }
+    CHECK(manager.jobStatus({ObjectType::BinClip, runningOwner}) == TaskManagerStatus::Running);
+    // The callback is only invoked from the event loop, once the task stopped
+    CHECK_FALSE(done);
+    // Queued tasks were dropped without taking a thread
+    CHECK(started <= running + manager.m_taskPool.maxThreadCount());
+
+    released = true;
+    REQUIRE(waitFor([&]() { return done; }));
+    REQUIRE(waitFor([&]() {
+        for (int i = 0; i < count; ++i) {
+            if (manager.hasPendingJob({ObjectType::BinClip, firstOwner + i})) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    // Let the deleted tasks go
+    QCoreApplication::processEvents();
+}
+
+TEST_CASE("Discard pending tasks only", "[TaskManager]")
+{
+    TaskManager &manager = pCore->taskManager;
+    const int count = 100;
+    const int firstOwner = 200000;
+    std::atomic<int> started{0};
+    std::atomic<int> lastStarted{-1};
+    std::atomic<bool> released{false};
+    for (int i = 0; i < count; ++i) {
+        manager.startTask(firstOwner + i, new FrameTask(firstOwner + i, started, lastStarted, released));
+    }
+    REQUIRE(waitFor([&]() { return started > 0; }));
+    manager.discardPendingJobs();
+    int running = 0;
+    {
+        QMutexLocker lk(&manager.m_queueMutex);
+        REQUIRE(manager.m_pendingTasks.empty());
+        running = int(manager.m_runningJobs.size());
+    }
+    // Only the running tasks are left
+    REQUIRE(waitFor([&]() {
+        int left = 0;
+        for (int i = 0; i < count; ++i) {
+            if (manager.hasPendingJob({ObjectType::BinClip, firstOwner + i})) {
+                left++;
+            }
+        }
+        return left == running;
+    }));
+    CHECK(waitFor([&]() { return started == running; }));
+    manager.discardAllJobs();
+    // Running tasks are canceled without waiting for them
+    CHECK(manager.jobStatus({ObjectType::BinClip, lastStarted}) == TaskManagerStatus::Running);
+    released = true;
+    REQUIRE(waitFor([&]() {
+        for (int i = 0; i < count; ++i) {
+            if (manager.hasPendingJob({ObjectType::BinClip, firstOwner + i})) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    QCoreApplication::processEvents();
+}